@@ -0,0 +1,402 @@
+/**
+ * GFX_Lite host microbenchmarks.
+ *
+ * Times the drawing primitives, text, every compositor mode and the colorutils / noise
+ * helpers at a few layer sizes, and prints ns per operation and megapixels per second.
+ * With --json the same results are written to a file, so runs from different releases
+ * can be compared.
+ *
+ *   gfx_bench [--json results.json] [--filter text] [--sizes 64x32,128x64] [--min-time 0.2] [--quick]
+ *
+ * "pixels per op" is what one operation actually covers: measured once by drawing on a
+ * cleared layer and counting what changed for shapes and text, width x height for
+ * whole-layer operations.
+ */
+
+#include "GFX_Layer.hpp"
+#include "Fonts/FreeSans9pt7b.h"
+#include "GFX_PaletteCache.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct Size {
+    uint16_t w, h;
+};
+
+struct Result {
+    std::string group;
+    std::string name;
+    Size        size;
+    uint64_t    iterations;
+    double      ns_per_op;
+    double      pixels_per_op;
+};
+
+struct Options {
+    const char       *json_path = nullptr;
+    const char       *filter    = nullptr;
+    double            min_time  = 0.2;          // seconds per measurement
+    std::vector<Size> sizes     = { { 64, 32 }, { 128, 64 }, { 256, 128 } };
+};
+
+Options             options;
+std::vector<Result> results;
+
+// Where the layers' callbacks go, like a panel driver's frame buffer
+std::vector<CRGB>   panel;
+Size                panel_size;
+
+volatile uint32_t   sink;                       // keeps pure computations alive
+
+double seconds(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+double timeBatch(const std::function<void()> &op, uint64_t n)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; i++) op();
+    return seconds(start);
+}
+
+/*
+ * Grow the batch until it takes a tenth of the minimum time, then time five batches
+ * sized to fill it and keep the median.
+ */
+void bench(const char *group, const std::string &name, Size size, double pixels_per_op, const std::function<void()> &op)
+{
+    const std::string full = std::string(group) + "/" + name;
+    if (options.filter && full.find(options.filter) == std::string::npos) return;
+
+    op();                                       // warm up caches and lazy tables
+
+    uint64_t n = 1;
+    double   t = timeBatch(op, n);
+    while (t < options.min_time / 10 && n < (1ull << 40)) {
+        n *= 2;
+        t = timeBatch(op, n);
+    }
+    n = std::max<uint64_t>(1, (uint64_t)(n * (options.min_time / 5) / std::max(t, 1e-9)));
+
+    double samples[5];
+    for (double &s : samples) s = timeBatch(op, n) / n;
+    std::sort(samples, samples + 5);
+
+    Result r = { group, name, size, n * 5, samples[2] * 1e9, pixels_per_op };
+    results.push_back(r);
+
+    const double mpix = pixels_per_op / (r.ns_per_op * 1e-9) / 1e6;
+    printf("%-12s %-28s %4ux%-4u %12.1f ns/op %10.1f px/op %10.2f Mpx/s\n",
+           group, name.c_str(), size.w, size.h, r.ns_per_op, pixels_per_op, mpix);
+    fflush(stdout);
+}
+
+void panelWrite(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (x < 0 || y < 0 || x >= panel_size.w || y >= panel_size.h) return;
+    panel[(size_t)y * panel_size.w + x] = CRGB(r, g, b);
+}
+
+// Pixels changed by one call of 'draw' on a black layer
+double coverage(GFX_Layer &layer, const std::function<void()> &draw)
+{
+    layer.fastFillScreen(CRGB(0, 0, 0));
+    draw();
+    return (double)layer.getWidth() * layer.getHeight() - layer.getPixelCount(CRGB(0, 0, 0));
+}
+
+void fillPattern(GFX_Layer &layer, uint8_t seed)
+{
+    for (int y = 0; y < layer.getHeight(); y++) {
+        for (int x = 0; x < layer.getWidth(); x++) {
+            layer.drawPixel(x, y, CRGB((x * 7 + seed) & 0xFF, (y * 13 + seed) & 0xFF, ((x ^ y) * 5) & 0xFF));
+        }
+    }
+}
+
+/* Groups */
+
+void benchPrimitives(Size s)
+{
+    GFX_Layer layer(s.w, s.h, panelWrite);
+    const CRGB colour(200, 120, 40);
+    const int16_t w = s.w, h = s.h;
+
+    auto fillRect = [&] { layer.fillRect(1, 1, w - 2, h - 2, colour); };
+    bench("primitives", "fillRect", s, coverage(layer, fillRect), fillRect);
+
+    auto fastFillRect = [&] { layer.fastFillRect(1, 1, w - 2, h - 2, colour); };
+    bench("primitives", "fastFillRect", s, coverage(layer, fastFillRect), fastFillRect);
+
+    // One op is one line, taken in turn from a fan covering every octant
+    struct Line { int16_t x0, y0, x1, y1; };
+    std::vector<Line> fan;
+    for (int16_t x = 0; x < w; x += 8) fan.push_back({ x, 0, (int16_t)(w - 1 - x), (int16_t)(h - 1) });
+    for (int16_t y = 0; y < h; y += 8) fan.push_back({ 0, y, (int16_t)(w - 1), (int16_t)(h - 1 - y) });
+    double line_pixels = 0;
+    for (const Line &l : fan) line_pixels += std::max(abs(l.x1 - l.x0), abs(l.y1 - l.y0)) + 1;
+
+    size_t next_line = 0;
+    bench("primitives", "drawLine", s, line_pixels / fan.size(), [&] {
+        const Line &l = fan[next_line];
+        layer.drawLine(l.x0, l.y0, l.x1, l.y1, colour);
+        if (++next_line == fan.size()) next_line = 0;
+    });
+
+    auto circle = [&] { layer.fillCircle(w / 2, h / 2, h / 2 - 1, colour); };
+    bench("primitives", "fillCircle", s, coverage(layer, circle), circle);
+
+    auto triangle = [&] { layer.fillTriangle(0, h - 1, w / 2, 0, w - 1, h - 1, colour); };
+    bench("primitives", "fillTriangle", s, coverage(layer, triangle), triangle);
+
+    // Quarter-screen RGB565 sprite
+    const int16_t bw = w / 2, bh = h / 2;
+    std::vector<uint16_t> bitmap((size_t)bw * bh);
+    for (size_t i = 0; i < bitmap.size(); i++) bitmap[i] = (uint16_t)(i * 2654435761u >> 16) | 0x0821;
+    auto rgbBitmap = [&] { layer.drawRGBBitmap(w / 4, h / 4, bitmap.data(), bw, bh); };
+    bench("primitives", "drawRGBBitmap", s, (double)bw * bh, rgbBitmap);
+}
+
+void benchText(Size s)
+{
+    GFX_Layer layer(s.w, s.h, panelWrite);
+    static const char text[] = "GFX Lite 0123456789 Hello!";
+    const size_t len = sizeof(text) - 1;
+    const uint16_t ink = 0xFFE0;
+
+    for (uint8_t font = 0; font < 2; font++) {
+        layer.setFont(font ? &FreeSans9pt7b : NULL);
+
+        for (uint8_t size = 1; size <= 3; size++) {
+            // One op is one character; the baseline sits low enough for the tallest glyph
+            const int16_t y = font ? 13 * size : 0;
+            double pixels = 0;
+            for (size_t i = 0; i < len; i++) {
+                pixels += coverage(layer, [&] { layer.drawChar((int16_t)((i * 3) % s.w), y, text[i], ink, ink, size); });
+            }
+            pixels /= len;
+
+            size_t i = 0;
+            const std::string name = std::string("drawChar ") + (font ? "FreeSans9pt" : "classic") + " x" + (char)('0' + size);
+            bench("text", name, s, pixels, [&] {
+                layer.drawChar((int16_t)((i * 3) % s.w), y, text[i], ink, ink, size);
+                if (++i == len) i = 0;
+            });
+        }
+    }
+    layer.setFont(NULL);
+}
+
+void benchCompositor(Size s)
+{
+    GFX_Layer bg(s.w, s.h, panelWrite), fg(s.w, s.h, panelWrite), mask(s.w, s.h, panelWrite), out(s.w, s.h, panelWrite);
+    fillPattern(bg, 0);
+    fillPattern(fg, 90);
+    fg.fillCircle(s.w / 2, s.h / 2, s.h / 4, CRGB(0, 0, 0));   // some transparent pixels
+    fillPattern(mask, 200);
+
+    GFX_AlphaMask alpha(s.w, s.h);
+    alpha.fromLuminance(mask);
+
+    GFX_LayerCompositor comp(panelWrite);
+    const GFX_Surface target(out);
+    const double px = (double)s.w * s.h;
+
+    static const char *const mode_names[] = {
+        "NORMAL", "MULTIPLY", "SCREEN", "OVERLAY", "DARKEN", "LIGHTEN", "ADD", "SUBTRACT", "DIFFERENCE", "COLOR_DODGE"
+    };
+
+    GFX_Layer *stack[3] = { &bg, &fg, &mask };
+    GFX_LayerCompositor::BlendMode stack_modes[3] = {
+        GFX_LayerCompositor::BLEND_NORMAL, GFX_LayerCompositor::BLEND_SCREEN, GFX_LayerCompositor::BLEND_MULTIPLY
+    };
+    uint8_t stack_opacity[3] = { 255, 200, 128 };
+
+    // The legacy forms flush through the callback; the GFX_Surface forms render to memory
+    for (uint8_t to_surface = 0; to_surface < 2; to_surface++) {
+        const char *group = to_surface ? "compositor" : "compositor-cb";
+
+        bench(group, "Stack", s, px, [&] { to_surface ? comp.Stack(bg, fg, target) : comp.Stack(bg, fg); });
+        bench(group, "Siloette", s, px, [&] { to_surface ? comp.Siloette(bg, fg, target) : comp.Siloette(bg, fg); });
+        bench(group, "Blend", s, px, [&] { to_surface ? comp.Blend(bg, fg, target, 100) : comp.Blend(bg, fg, 100); });
+        bench(group, "AlphaComposite", s, px, [&] {
+            to_surface ? comp.AlphaComposite(bg, fg, target, 160) : comp.AlphaComposite(bg, fg, 160);
+        });
+        bench(group, "Mask layer", s, px, [&] { to_surface ? comp.Mask(bg, fg, mask, target) : comp.Mask(bg, fg, mask); });
+        bench(group, "Mask alpha", s, px, [&] { to_surface ? comp.Mask(bg, fg, alpha, target) : comp.Mask(bg, fg, alpha); });
+
+        for (uint8_t m = 0; m <= GFX_LayerCompositor::BLEND_COLOR_DODGE; m++) {
+            const GFX_LayerCompositor::BlendMode mode = (GFX_LayerCompositor::BlendMode)m;
+            bench(group, std::string("BlendAdvanced ") + mode_names[m], s, px, [&] {
+                to_surface ? comp.BlendAdvanced(bg, fg, target, mode, 200) : comp.BlendAdvanced(bg, fg, mode, 200);
+            });
+        }
+
+        bench(group, "CompositeMultiple x3", s, px, [&] {
+            to_surface ? comp.CompositeMultiple(stack, 3, stack_modes, stack_opacity, target)
+                       : comp.CompositeMultiple(stack, 3, stack_modes, stack_opacity);
+        });
+    }
+}
+
+void benchColorUtils(Size s)
+{
+    GFX_Layer layer(s.w, s.h, panelWrite);
+    fillPattern(layer, 33);
+    const double px = (double)s.w * s.h;
+
+    bench("colorutils", "GFX_Layer::blur", s, px, [&] { layer.blur(64); });
+    bench("colorutils", "GFX_Layer::blur2d", s, px, [&] { layer.blur2d(64); });
+
+    std::vector<CRGB> leds((size_t)s.w * s.h);
+    bench("colorutils", "blur2d (buffer)", s, px, [&] { blur2d(leds.data(), s.w, s.h, s.w, 64); });
+
+    bench("colorutils", "ColorFromPalette", s, px, [&] {
+        uint8_t index = sink;
+        for (CRGB &p : leds) p = ColorFromPalette(RainbowColors_p, index++, 255, LINEARBLEND);
+        sink = leds[leds.size() / 2].r;
+    });
+
+    std::vector<uint8_t> indices((size_t)s.w * s.h);
+    for (size_t i = 0; i < indices.size(); i++) indices[i] = i * 7;
+    bench("colorutils", "map_data_through_palette", s, px, [&] {
+        map_data_into_colors_through_palette(indices.data(), indices.size(), leds.data(), RainbowColors_p, 200);
+        sink = leds[leds.size() / 2].r;
+    });
+
+    GFX_PaletteCache cache;
+    cache.setPalette(RainbowColors_p);
+    cache.setBrightness(200);
+    bench("colorutils", "GFX_PaletteCache::apply", s, px, [&] {
+        cache.apply(indices.data(), leds.data(), indices.size());
+        sink = leds[leds.size() / 2].r;
+    });
+    bench("colorutils", "GFX_Layer::mapPalette", s, px, [&] { layer.mapPalette(indices.data(), cache); });
+
+    bench("colorutils", "hsv2rgb_rainbow", s, px, [&] {
+        uint8_t hue = sink;
+        for (CRGB &p : leds) hsv2rgb_rainbow(CHSV(hue++, 240, 255), p);
+        sink = leds[leds.size() / 2].g;
+    });
+
+    uint32_t t = 0;
+    bench("noise", "fill_2dnoise16", s, px, [&] {
+        t += 64;
+        fill_2dnoise16(leds.data(), s.w, s.h, false, 3, 0, 3000, 0, 3000, t, 1, 0, 200, 0, 200, t >> 4, false);
+    });
+    bench("noise", "fill_2dnoise8", s, px, [&] {
+        t += 64;
+        fill_2dnoise8(leds.data(), s.w, s.h, false, 2, 0, 40, 0, 40, t, 1, 0, 200, 0, 200, t >> 4, false);
+    });
+
+    std::vector<uint8_t> map((size_t)s.w * s.h);
+    bench("noise", "fill_raw_2dnoise16into8", s, px, [&] {
+        fill_raw_2dnoise16into8(map.data(), s.w, s.h, 1, 0, 3000, 0, 3000, t += 64);
+        sink = map[map.size() / 2];
+    });
+    bench("noise", "fill_raw_2dnoise16into8 step 4", s, px, [&] {
+        fill_raw_2dnoise16into8_upscaled(map.data(), s.w, s.h, 4, 1, 0, 3000, 0, 3000, t += 64);
+        sink = map[map.size() / 2];
+    });
+    bench("noise", "fill_raw_2dsimplex8", s, px, [&] {
+        fill_raw_2dsimplex8(map.data(), s.w, s.h, 1, 0, 3000, 0, 3000, t += 64);
+        sink = map[map.size() / 2];
+    });
+}
+
+/* Output */
+
+void writeJson(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "gfx_bench: can't write %s\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"gfx_bench\",\n  \"version\": 1,\n");
+#if defined(__clang__)
+    fprintf(f, "  \"compiler\": \"clang %s\",\n", __clang_version__);
+#elif defined(__GNUC__)
+    fprintf(f, "  \"compiler\": \"gcc %s\",\n", __VERSION__);
+#endif
+#ifdef GFX_BENCH_BUILD_TYPE
+    fprintf(f, "  \"build_type\": \"%s\",\n", GFX_BENCH_BUILD_TYPE);
+#endif
+    fprintf(f, "  \"min_time_s\": %g,\n  \"results\": [\n", options.min_time);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        const double mpix = r.pixels_per_op / (r.ns_per_op * 1e-9) / 1e6;
+        fprintf(f, "    {\"group\": \"%s\", \"name\": \"%s\", \"width\": %u, \"height\": %u, "
+                   "\"iterations\": %llu, \"ns_per_op\": %.3f, \"pixels_per_op\": %.2f, \"mpixels_per_s\": %.3f}%s\n",
+                r.group.c_str(), r.name.c_str(), r.size.w, r.size.h, (unsigned long long)r.iterations,
+                r.ns_per_op, r.pixels_per_op, mpix, (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+bool parseSizes(const char *arg)
+{
+    options.sizes.clear();
+    while (*arg) {
+        unsigned w, h;
+        int used = 0;
+        if (sscanf(arg, "%ux%u%n", &w, &h, &used) != 2 || w == 0 || h == 0 || w > 4096 || h > 4096) return false;
+        options.sizes.push_back({ (uint16_t)w, (uint16_t)h });
+        arg += used;
+        if (*arg == ',') arg++;
+    }
+    return !options.sizes.empty();
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: gfx_bench [--json file] [--filter text] [--sizes WxH[,WxH...]] [--min-time seconds] [--quick]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg  = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if      (!strcmp(arg, "--json")     && next) { options.json_path = next; i++; }
+        else if (!strcmp(arg, "--filter")   && next) { options.filter = next; i++; }
+        else if (!strcmp(arg, "--min-time") && next) { options.min_time = atof(next); i++; }
+        else if (!strcmp(arg, "--sizes")    && next) {
+            if (!parseSizes(next)) { usage(); return 2; }
+            i++;
+        }
+        else if (!strcmp(arg, "--quick")) options.min_time = 0.01;
+        else { usage(); return 2; }
+    }
+    if (options.min_time <= 0) options.min_time = 0.2;
+
+    for (const Size &s : options.sizes) {
+        panel_size = s;
+        panel.assign((size_t)s.w * s.h, CRGB(0, 0, 0));
+
+        benchPrimitives(s);
+        benchText(s);
+        benchCompositor(s);
+        benchColorUtils(s);
+    }
+
+    if (options.json_path) writeJson(options.json_path);
+    return 0;
+}
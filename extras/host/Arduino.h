@@ -0,0 +1,44 @@
+/**
+ * Minimal Arduino.h for building GFX_Lite on a desktop host (Linux, macOS).
+ *
+ * Only what the library itself uses: fixed width types, byte/boolean, min/max,
+ * PROGMEM (a no-op here), F(), String, Print and the millis()/micros() clock.
+ * Not part of the Arduino library; see the CMakeLists.txt at the repository root.
+ */
+
+#ifndef GFX_HOST_ARDUINO_H
+#define GFX_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+using std::min;
+using std::max;
+
+// Flash is ordinary memory here. The pgm_read_*() fallbacks in GFX_Lite.cpp apply
+// (pgm_read_pointer() reads a full width pointer through pgm_read_dword()).
+#ifndef PROGMEM
+  #define PROGMEM
+#endif
+
+// Flash strings are ordinary strings on the host
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+// Monotonic clock, counted from the first call
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+#include "WString.h"
+#include "Print.h"
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * Host stand-in for Arduino's Print. GFX derives from it and implements
+ * write(uint8_t); print()/println() format into that. printf() is missing from
+ * some Arduino cores, so it isn't offered here either.
+ */
+
+#ifndef GFX_HOST_PRINT_H
+#define GFX_HOST_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print
+{
+    public:
+        virtual ~Print() {}
+
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size) {
+            size_t n = 0;
+            while (size--) n += write(*buffer++);
+            return n;
+        }
+        size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+        size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+        size_t print(const __FlashStringHelper *s) { return write(reinterpret_cast<const char *>(s)); }
+        size_t print(const String &s)              { return write(s.c_str(), s.size()); }
+        size_t print(const char *s)                { return write(s); }
+        size_t print(char c)                       { return write((uint8_t)c); }
+        size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+        size_t print(int v, int base = DEC)           { return print((long)v, base); }
+        size_t print(unsigned int v, int base = DEC)  { return print((unsigned long)v, base); }
+        size_t print(long v, int base = DEC);
+        size_t print(unsigned long v, int base = DEC);
+        size_t print(double v, int digits = 2);
+
+        size_t println()                           { return write("\r\n"); }
+        template <typename T> size_t println(const T &v)           { size_t n = print(v);       return n + println(); }
+        template <typename T> size_t println(const T &v, int mode) { size_t n = print(v, mode); return n + println(); }
+};
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * Host stand-in for Arduino's String: a std::string with the handful of
+ * Arduino spellings the library's API takes (const String &).
+ */
+
+#ifndef GFX_HOST_WSTRING_H
+#define GFX_HOST_WSTRING_H
+
+#include <string>
+
+class __FlashStringHelper;
+
+class String : public std::string
+{
+    public:
+        String() {}
+        String(const char *s) : std::string(s ? s : "") {}
+        String(const std::string &s) : std::string(s) {}
+        String(const __FlashStringHelper *s) : std::string(s ? reinterpret_cast<const char *>(s) : "") {}
+        explicit String(char c) : std::string(1, c) {}
+        explicit String(int v)           : std::string(std::to_string(v)) {}
+        explicit String(unsigned int v)  : std::string(std::to_string(v)) {}
+        explicit String(long v)          : std::string(std::to_string(v)) {}
+        explicit String(unsigned long v) : std::string(std::to_string(v)) {}
+
+        unsigned int length() const { return (unsigned int)size(); }
+        char charAt(unsigned int i) const { return i < size() ? (*this)[i] : 0; }
+};
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Host implementations behind the Arduino.h / Print.h shims.
+ */
+
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+#include <stdio.h>
+
+namespace {
+
+const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+template <typename Unit>
+uint32_t elapsed()
+{
+    return (uint32_t)std::chrono::duration_cast<Unit>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+} // namespace
+
+uint32_t millis() { return elapsed<std::chrono::milliseconds>(); }
+uint32_t micros() { return elapsed<std::chrono::microseconds>(); }
+
+void delay(uint32_t ms)             { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+// lib8tion's beat/timer helpers use this name off Arduino
+uint32_t get_millisecond_timer() { return millis(); }
+
+/*
+ * colorutils' XY-based blur1d/blur2d call the sketch's XY(). This weak one (row-major,
+ * 16 pixels wide, as in FastLED's XYMatrix example) only lets the library link; a
+ * program that uses those functions should define its own.
+ */
+__attribute__((weak)) uint16_t XY(uint16_t x, uint16_t y)
+{
+    return (uint16_t)(y * 16 + x);
+}
+
+/* Print */
+
+size_t Print::print(unsigned long v, int base)
+{
+    if (base < 2 || base > 16) base = 10;
+
+    char buf[8 * sizeof(long) + 1];
+    char *p = buf + sizeof(buf);
+    *--p = '\0';
+    do {
+        const unsigned digit = v % base;
+        *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        v /= base;
+    } while (v);
+    return write(p);
+}
+
+size_t Print::print(long v, int base)
+{
+    if (base == 10 && v < 0) {
+        return print('-') + print(0UL - (unsigned long)v, 10);
+    }
+    return print((unsigned long)v, base);
+}
+
+size_t Print::print(double v, int digits)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return write(buf);
+}
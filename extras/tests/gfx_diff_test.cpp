@@ -0,0 +1,1512 @@
+/**
+ * GFX_Lite differential tests.
+ *
+ * Renders randomized scenes twice, once through the library (fast fills, span
+ * compositor, ring-scrolled layers, worker-pool bands) and once through the plain
+ * per-pixel versions in gfx_reference.hpp, and compares the two pixel by pixel.
+ * Layer effects that have no reference are checked against themselves instead: a
+ * ring-scrolled and/or pooled layer has to end up identical to a plain serial one.
+ *
+ *   gfx_diff_test [--seed 1] [--iterations 300] [--filter compositor] [--out dir] [--verbose]
+ *
+ * Every case is derived from the seed, so a failure prints the seed and case number
+ * needed to replay it. Mismatches are written to --out as expected / actual / diff PPM
+ * images (the diff shows matching pixels dimmed and differing ones in red).
+ */
+
+#include "gfx_reference.hpp"
+#include "Fonts/FreeSans9pt7b.h"
+#include "Fonts/FreeMono12pt7b.h"
+#include "Fonts/FreeSerifBoldItalic9pt7b.h"
+#include "Fonts/Picopixel.h"
+#include "Fonts/TomThumb.h"
+#include "GFX_ColorMatrix.hpp"
+#include "GFX_ColorCurve.hpp"
+#include "GFX_PaletteCache.hpp"
+#include "GFX_Ticker.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+using gfx_ref::Image;
+
+namespace {
+
+struct Options {
+    uint32_t    seed       = 1;
+    uint32_t    iterations = 300;
+    const char *filter     = nullptr;
+    const char *out_dir    = "gfx_diff_failures";
+    bool        verbose    = false;
+};
+
+Options options;
+
+uint32_t cases    = 0;
+uint32_t failures = 0;
+uint32_t dumps    = 0;
+const uint32_t MAX_DUMPS = 24;
+
+GFX_WorkerPool *pool = nullptr;
+
+// Compositor callback output, in canvas coordinates, and how often each pixel came
+Image                captured;
+std::vector<uint8_t> captured_hits;
+uint32_t             stray_calls = 0;       // outside the background
+
+auto no_callback = [](int16_t, int16_t, uint8_t, uint8_t, uint8_t) {};
+
+/* ---- Random scenes ---------------------------------------------------------------- */
+
+// splitmix64: small, fast, and the same sequence on every platform
+struct Rng {
+    uint64_t state;
+
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint32_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return (uint32_t)((z ^ (z >> 31)) >> 32);
+    }
+
+    int32_t range(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi - lo + 1)); }   // inclusive
+    bool    chance(uint32_t percent)      { return next() % 100 < percent; }
+    uint8_t byte()                        { return (uint8_t)next(); }
+
+    // Mostly the interesting values: 0, 255 and the neighbours of the seams
+    uint8_t amount() {
+        static const uint8_t edges[] = { 0, 1, 127, 128, 254, 255 };
+        return chance(30) ? edges[next() % sizeof(edges)] : byte();
+    }
+
+    CRGB color() { return CRGB(byte(), byte(), byte()); }
+};
+
+Rng caseRng(uint32_t group, uint32_t index)
+{
+    return Rng(((uint64_t)options.seed << 32) ^ ((uint64_t)group << 24) ^ index);
+}
+
+/*
+ * A layer with random content: noise with a good share of transparent (black)
+ * pixels, plus a few solid shapes so runs and edges get exercised. ring = rotate the
+ * layer's origin first, so every read and write goes through the wrap.
+ */
+std::unique_ptr<GFX_Layer> makeLayer(Rng &rng, uint16_t w, uint16_t h, bool ring)
+{
+    std::unique_ptr<GFX_Layer> layer(new GFX_Layer(w, h, no_callback));
+    layer->clear();
+
+    if (ring) {
+        layer->setRingScroll(true);
+        layer->scrollX(rng.range(1, w), CRGB(0, 0, 0));
+        layer->scrollY(rng.range(1, h), CRGB(0, 0, 0));
+    }
+
+    const uint8_t key_share = rng.range(0, 60);
+    for (int16_t y = 0; y < h; y++) {
+        for (int16_t x = 0; x < w; x++) {
+            layer->drawPixel(x, y, rng.chance(key_share) ? CRGB(0, 0, 0) : rng.color());
+        }
+    }
+
+    for (int i = rng.range(0, 3); i > 0; i--) {
+        const CRGB c = rng.chance(30) ? CRGB(0, 0, 0) : rng.color();
+        gfx_ref::fillRect(*layer, rng.range(-4, w), rng.range(-4, h), rng.range(1, w), rng.range(1, h), c);
+    }
+    return layer;
+}
+
+// Same logical content, optionally ring-scrolled
+std::unique_ptr<GFX_Layer> copyLayer(Rng &rng, GFX_Layer &src, bool ring)
+{
+    const Image img = gfx_ref::snapshot(src);
+    std::unique_ptr<GFX_Layer> layer(new GFX_Layer(img.width, img.height, no_callback));
+    layer->clear();
+
+    if (ring) {
+        layer->setRingScroll(true);
+        layer->scrollX(rng.range(1, img.width), CRGB(0, 0, 0));
+        layer->scrollY(rng.range(1, img.height), CRGB(0, 0, 0));
+    }
+    for (int16_t y = 0; y < img.height; y++) {
+        for (int16_t x = 0; x < img.width; x++) layer->drawPixel(x, y, img.at(x, y));
+    }
+    layer->setPosition(src.getPositionX(), src.getPositionY());
+    layer->transparency_colour  = src.transparency_colour;
+    layer->transparency_enabled = src.transparency_enabled;
+    return layer;
+}
+
+/* ---- Comparing and dumping -------------------------------------------------------- */
+
+bool writePPM(const std::string &path, const Image &img)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    fprintf(f, "P6\n%d %d\n255\n", (int)img.width, (int)img.height);
+    for (const CRGB &c : img.px) {
+        const uint8_t rgb[3] = { c.r, c.g, c.b };
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+    return true;
+}
+
+void dump(const std::string &name, const Image &expected, const Image &actual)
+{
+    if (dumps >= MAX_DUMPS) return;
+    if (dumps++ == 0) mkdir(options.out_dir, 0755);
+
+    Image diff = expected;
+    for (size_t i = 0; i < diff.px.size(); i++) {
+        const CRGB e = expected.px[i];
+        diff.px[i] = (e == actual.px[i]) ? CRGB(e.r / 4, e.g / 4, e.b / 4) : CRGB(255, 0, 0);
+    }
+
+    std::string base = std::string(options.out_dir) + "/" + name;
+    for (char &c : base) if (c == ' ' || c == ':') c = '_';
+
+    if (writePPM(base + "_expected.ppm", expected) && writePPM(base + "_actual.ppm", actual) &&
+        writePPM(base + "_diff.ppm", diff)) {
+        printf("    wrote %s_{expected,actual,diff}.ppm\n", base.c_str());
+    }
+}
+
+/*
+ * One check. 'what' describes the case well enough to read the failure without
+ * replaying it; the seed and index are enough to replay it.
+ */
+bool check(const char *group, uint32_t index, const std::string &what, const Image &expected, const Image &actual)
+{
+    cases++;
+
+    uint32_t bad = 0;
+    int32_t  bx = 0, by = 0;
+    const bool same_shape = expected.width == actual.width && expected.height == actual.height;
+
+    for (int32_t y = 0; same_shape && y < expected.height; y++) {
+        for (int32_t x = 0; x < expected.width; x++) {
+            if (expected.at(x, y) != actual.at(x, y) && bad++ == 0) { bx = x; by = y; }
+        }
+    }
+
+    if (same_shape && bad == 0) {
+        if (options.verbose) printf("  ok   %s #%u %s\n", group, index, what.c_str());
+        return true;
+    }
+
+    failures++;
+    printf("  FAIL %s #%u (--seed %u) %s\n", group, index, options.seed, what.c_str());
+    if (!same_shape) {
+        printf("    size %dx%d, expected %dx%d\n", (int)actual.width, (int)actual.height,
+               (int)expected.width, (int)expected.height);
+        return false;
+    }
+
+    const CRGB e = expected.at(bx, by), a = actual.at(bx, by);
+    printf("    %u of %u pixels differ, first at (%d,%d): expected %u,%u,%u got %u,%u,%u\n",
+           bad, (unsigned)expected.px.size(), (int)bx, (int)by, e.r, e.g, e.b, a.r, a.g, a.b);
+
+    char name[96];
+    snprintf(name, sizeof(name), "%s_%u_%u", group, options.seed, index);
+    dump(name, expected, actual);
+    return false;
+}
+
+bool selected(const char *group)
+{
+    return !options.filter || strstr(group, options.filter);
+}
+
+std::string format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+std::string format(const char *fmt, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+/* ---- Fills ------------------------------------------------------------------------ */
+
+void testFills()
+{
+    const char *group = "fill";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(1, i);
+        const uint16_t w = rng.range(1, 80), h = rng.range(1, 48);
+        const bool ring = rng.chance(50);
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+
+        const int op = rng.range(0, 3);
+        const CRGB c = rng.color();
+        const int16_t x = rng.range(-w, 2 * w), y = rng.range(-h, 2 * h);
+        const int16_t rw = rng.range(-8, 2 * w), rh = rng.range(-8, 2 * h);
+        std::string what;
+
+        switch (op) {
+            case 0:
+                lib->fastFillRect(x, y, rw, rh, c);
+                gfx_ref::fillRect(*ref, x, y, rw, rh, c);
+                what = format("fastFillRect(%d,%d,%d,%d)", x, y, rw, rh);
+                break;
+            case 1:
+                lib->fillRect(x, y, rw, rh, c);
+                gfx_ref::fillRect(*ref, x, y, rw, rh, c);
+                what = format("fillRect(%d,%d,%d,%d)", x, y, rw, rh);
+                break;
+            case 2:
+                lib->fastFillScreen(c);
+                gfx_ref::fillRect(*ref, 0, 0, w, h, c);
+                what = "fastFillScreen";
+                break;
+            default:
+                lib->clear();
+                gfx_ref::fillRect(*ref, 0, 0, w, h, CRGB(0, 0, 0));
+                what = "clear";
+                break;
+        }
+        what += format(" on %ux%u%s", w, h, ring ? " ring" : "");
+        check(group, i, what, gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+/* ---- Text ------------------------------------------------------------------------- */
+
+struct Font {
+    const char    *name;
+    const GFXfont *font;
+};
+
+const Font fonts[] = {
+    { "classic",               nullptr },
+    { "FreeSans9pt7b",         &FreeSans9pt7b },
+    { "FreeMono12pt7b",        &FreeMono12pt7b },
+    { "FreeSerifBoldItalic9pt7b", &FreeSerifBoldItalic9pt7b },
+    { "Picopixel",             &Picopixel },
+    { "TomThumb",              &TomThumb },
+};
+
+void testText()
+{
+    const char *group = "text";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(2, i);
+        const uint16_t w = rng.range(8, 96), h = rng.range(8, 64);
+        const bool ring = rng.chance(30);
+
+        const Font &font = fonts[rng.next() % (sizeof(fonts) / sizeof(fonts[0]))];
+        const uint8_t sx = rng.range(1, 3), sy = rng.chance(70) ? sx : rng.range(1, 3);
+        const bool wrap = rng.chance(60);
+        const int16_t cx = rng.range(-30, w + 4), cy = rng.range(-20, h + 20);
+        const uint16_t color = (uint16_t)rng.next() | 1;    // never 0: that would be the background
+
+        // Printable ASCII, the odd newline, and now and then the high half
+        char text[24];
+        const int len = rng.range(1, sizeof(text) - 1);
+        for (int n = 0; n < len; n++) {
+            const uint32_t r = rng.next() % 100;
+            text[n] = (r < 5) ? '\n' : (r < 10 && !font.font) ? (char)rng.range(128, 254) : (char)rng.range(32, 126);
+        }
+        text[len] = 0;
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+
+        lib->setFont(font.font);
+        lib->setTextSize(sx, sy);
+        lib->setTextWrap(wrap);
+        lib->setTextColor(color);
+        lib->setCursor(cx, cy);
+        lib->print(text);
+
+        gfx_ref::print(*ref, font.font, sx, sy, cx, cy, text, color, wrap);
+
+        check(group, i, format("%s x%u,%u at (%d,%d)%s%s on %ux%u", font.name, sx, sy, cx, cy,
+                               wrap ? " wrap" : "", ring ? " ring" : "", w, h),
+              gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+/* ---- Ticker ----------------------------------------------------------------------- */
+
+// A GFX_Ticker rendered frame after frame into a strided buffer or a (ring-scrolled)
+// layer, every frame's target stacked under the last, against the looped text printed
+// straight into the window at each frame's scroll position
+void testTicker()
+{
+    const char *group = "ticker";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(17, i);
+        const Font &font = fonts[rng.next() % (sizeof(fonts) / sizeof(fonts[0]))];
+        const uint8_t  size  = rng.range(1, 3);
+        const uint16_t width = rng.range(0, 80);       // 0 is clamped to 1
+        const uint16_t speed = rng.chance(10) ? rng.range(1024, 8192) : rng.range(1, 1024);
+        const uint16_t gap   = rng.range(0, 20);
+        const CRGB ink = rng.color(), paper = rng.chance(50) ? CRGB(0, 0, 0) : rng.color();
+        const bool transparent = rng.chance(30);
+        const int  frames = rng.range(1, 40);
+
+        std::vector<std::string> messages(rng.range(1, 3));
+        for (std::string &m : messages) {
+            for (int n = rng.range(1, 12); n > 0; n--) m += rng.chance(5) ? '\n' : (char)rng.range(32, 126);
+        }
+
+        GFX_Ticker ticker(width, font.font, size);
+        ticker.setColors(ink, paper);
+        ticker.setSpeed(speed);
+        ticker.setGap(gap);
+        ticker.restart();
+        for (const std::string &m : messages) ticker.append(m.c_str());
+
+        // The target sits somewhere on the canvas, the window somewhere around it
+        const uint16_t tw = rng.range(1, 90), th = rng.range(1, 30);
+        const int16_t  tx = rng.range(-10, 10), ty = rng.range(-10, 10);
+        const int16_t  rx = tx + rng.range(-20, tw), ry = ty + rng.range(-20, th);
+        const bool to_layer = rng.chance(50), ring = to_layer && rng.chance(50);
+
+        std::unique_ptr<GFX_Layer> layer;
+        std::vector<CRGB> buffer;
+        const uint16_t stride = tw + (to_layer ? 0 : rng.range(0, 5));
+        Image target(tx, ty, tw, th);
+        if (to_layer) {
+            layer = makeLayer(rng, tw, th, ring);
+            layer->setPosition(tx, ty);
+            target = gfx_ref::snapshot(*layer);
+        } else {
+            buffer.resize((size_t)stride * th);
+            for (CRGB &c : buffer) c = rng.color();
+            for (int32_t y = 0; y < th; y++) {
+                for (int32_t x = 0; x < tw; x++) target.at(x, y) = buffer[(size_t)y * stride + x];
+            }
+        }
+
+        Image expected(0, 0, tw, th * frames), actual(0, 0, tw, th * frames);
+        for (int f = 0; f < frames; f++) {
+            if (f) ticker.update();
+            if (to_layer) ticker.render(GFX_Surface(*layer), rx, ry, transparent);
+            else          ticker.render(GFX_Surface(buffer.data(), tw, th, stride, tx, ty), rx, ry, transparent);
+
+            const Image window = gfx_ref::tickerWindow(messages, font.font, size, width ? width : 1, gap,
+                                                       ((uint32_t)f * speed) >> 8, ink, paper);
+            for (int32_t y = 0; y < window.height; y++) {
+                for (int32_t x = 0; x < window.width; x++) {
+                    const int32_t px = rx - tx + x, py = ry - ty + y;
+                    if (px < 0 || py < 0 || px >= tw || py >= th) continue;
+                    if (!transparent || window.at(x, y) != paper) target.at(px, py) = window.at(x, y);
+                }
+            }
+
+            const Image now = to_layer ? gfx_ref::snapshot(*layer) : Image();
+            for (int32_t y = 0; y < th; y++) {
+                for (int32_t x = 0; x < tw; x++) {
+                    expected.at(x, f * th + y) = target.at(x, y);
+                    actual.at(x, f * th + y)   = to_layer ? now.at(x, y) : buffer[(size_t)y * stride + x];
+                }
+            }
+        }
+
+        check(group, i, format("%s x%u window %u speed %u gap %u, %d frames at (%d,%d) into %ux%u %s%s%s", font.name,
+                               size, width, speed, gap, frames, rx, ry, tw, th, to_layer ? "layer" : "buffer",
+                               ring ? " ring" : "", transparent ? " transparent" : ""),
+              expected, actual);
+    }
+}
+
+/* ---- Compositor ------------------------------------------------------------------- */
+
+const char *const mode_names[] = {
+    "NORMAL", "MULTIPLY", "SCREEN", "OVERLAY", "DARKEN", "LIGHTEN", "ADD", "SUBTRACT", "DIFFERENCE", "COLOR_DODGE"
+};
+
+enum Op { STACK, SILOETTE, BLEND, ADVANCED, ALPHA, MASK, ALPHA_MASK, MULTIPLE, OP_COUNT };
+const char *const op_names[] = { "Stack", "Siloette", "Blend", "BlendAdvanced", "AlphaComposite", "Mask", "Mask(alpha)", "CompositeMultiple" };
+
+enum Output { CALLBACK, SURFACE, IN_PLACE, OUTPUT_COUNT };
+const char *const output_names[] = { "callback", "surface", "in place" };
+
+// Anywhere from just off one edge of the background to just off the other
+void place(Rng &rng, GFX_Layer &layer, GFX_Layer &bg)
+{
+    layer.setPosition(rng.range(bg.getPositionX() - layer.getWidth() - 2, bg.getPositionX() + bg.getWidth() + 2),
+                      rng.range(bg.getPositionY() - layer.getHeight() - 2, bg.getPositionY() + bg.getHeight() + 2));
+}
+
+void testCompositor()
+{
+    const char *group = "compositor";
+    if (!selected(group)) return;
+
+    GFX_LayerCompositor comp([](int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b) {
+        const int32_t ix = x - captured.x, iy = y - captured.y;
+        if (ix < 0 || iy < 0 || ix >= captured.width || iy >= captured.height) { stray_calls++; return; }
+        captured.at(ix, iy) = CRGB(r, g, b);
+        captured_hits[(size_t)iy * captured.width + ix]++;
+    });
+
+    for (uint32_t i = 0; i < options.iterations * 2; i++) {
+        Rng rng = caseRng(3, i);
+
+        const Op     op     = (Op)(rng.next() % OP_COUNT);
+        const Output output = (Output)(rng.next() % OUTPUT_COUNT);
+        const bool   pooled = rng.chance(40);
+        comp.setWorkerPool(pooled ? pool : nullptr);
+
+        // Background and up to three upper layers, each maybe ring-scrolled
+        const uint8_t count = (op == MULTIPLE) ? rng.range(2, 4) : 2;
+        std::unique_ptr<GFX_Layer> layers[4];
+        GFX_Layer *ptrs[4];
+        for (uint8_t n = 0; n < count; n++) {
+            layers[n] = makeLayer(rng, rng.range(1, 100), rng.range(1, 48), rng.chance(40));
+            ptrs[n] = layers[n].get();
+            if (n == 0) layers[n]->setPosition(rng.range(-6, 6), rng.range(-6, 6));
+            else        place(rng, *layers[n], *layers[0]);
+            layers[n]->setTransparency(rng.chance(70));
+        }
+        GFX_Layer &bg = *layers[0], &fg = *layers[1];
+
+        std::unique_ptr<GFX_Layer> mask_layer;
+        std::unique_ptr<GFX_AlphaMask> alpha;
+        if (op == MASK) {
+            mask_layer = makeLayer(rng, rng.range(1, 100), rng.range(1, 48), rng.chance(40));
+            place(rng, *mask_layer, bg);
+        } else if (op == ALPHA_MASK) {
+            alpha.reset(new GFX_AlphaMask(rng.range(1, 100), rng.range(1, 48)));
+            for (int16_t y = 0; y < alpha->getHeight(); y++) {
+                for (int16_t x = 0; x < alpha->getWidth(); x++) alpha->setAlpha(x, y, rng.amount());
+            }
+            alpha->setPosition(rng.range(-6 - alpha->getWidth(), bg.getWidth() + 6), rng.range(-6 - alpha->getHeight(), bg.getHeight() + 6));
+        }
+
+        GFX_LayerCompositor::BlendMode modes[4];
+        uint8_t opacities[4];
+        for (uint8_t n = 0; n < 4; n++) {
+            modes[n]     = (GFX_LayerCompositor::BlendMode)(rng.next() % 10);
+            opacities[n] = rng.amount();
+        }
+        const GFX_LayerCompositor::BlendMode mode = modes[1];
+        const uint8_t opacity = opacities[1];
+
+        // Reference first: in-place output overwrites the background
+        Image expected;
+        switch (op) {
+            case STACK:      expected = gfx_ref::blend(bg, fg, GFX_LayerCompositor::BLEND_NORMAL, 255, true); break;
+            case SILOETTE:   expected = gfx_ref::siloette(bg, fg); break;
+            case BLEND:      expected = gfx_ref::blend(bg, fg, GFX_LayerCompositor::BLEND_NORMAL, opacity, true); break;
+            case ADVANCED:   expected = gfx_ref::blend(bg, fg, mode, opacity, fg.transparency_enabled); break;
+            case ALPHA:      expected = gfx_ref::blend(bg, fg, GFX_LayerCompositor::BLEND_NORMAL, opacity, fg.transparency_enabled); break;
+            case MASK:       expected = gfx_ref::mask(bg, fg, *mask_layer); break;
+            case ALPHA_MASK: expected = gfx_ref::mask(bg, fg, *alpha); break;
+            default:         expected = gfx_ref::compositeMultiple(ptrs, count, modes, opacities); break;
+        }
+
+        // In place, Stack(bg, fg, true) renders through a ring-scrolled background's rows
+        const bool write_back = (op == STACK && output == IN_PLACE && rng.chance(50));
+        const bool was_linear = bg.isLinear();
+
+        // Surface: a random window onto the canvas, with a stride wider than the window
+        const CRGB sentinel(1, 2, 3);
+        Image target;
+        std::vector<CRGB> surface_memory;
+        std::unique_ptr<GFX_Surface> surface;
+
+        if (output == SURFACE) {
+            const int32_t sw = rng.range(1, 110), sh = rng.range(1, 56);
+            const uint16_t stride = sw + rng.range(0, 5);
+            target = Image(rng.range(-10, 60), rng.range(-10, 30), sw, sh, sentinel);
+            surface_memory.assign((size_t)stride * sh, sentinel);
+            surface.reset(new GFX_Surface(surface_memory.data(), sw, sh, stride, target.x, target.y));
+
+            // Only the part over the background is written
+            Image clipped = target;
+            for (int32_t y = 0; y < target.height; y++) {
+                for (int32_t x = 0; x < target.width; x++) {
+                    const int32_t ex = target.x + x - expected.x, ey = target.y + y - expected.y;
+                    if (ex >= 0 && ey >= 0 && ex < expected.width && ey < expected.height) clipped.at(x, y) = expected.at(ex, ey);
+                }
+            }
+            expected = clipped;
+        } else if (output == IN_PLACE && !write_back) {
+            surface.reset(new GFX_Surface(bg));
+        } else if (output != IN_PLACE) {
+            captured = Image(expected.x, expected.y, expected.width, expected.height, sentinel);
+            captured_hits.assign(expected.px.size(), 0);
+            stray_calls = 0;
+        }
+
+        const GFX_Surface *dst = surface.get();
+        switch (op) {
+            case STACK:      dst ? comp.Stack(bg, fg, *dst) : comp.Stack(bg, fg, write_back); break;
+            case SILOETTE:   dst ? comp.Siloette(bg, fg, *dst) : comp.Siloette(bg, fg); break;
+            case BLEND:      dst ? comp.Blend(bg, fg, *dst, opacity) : comp.Blend(bg, fg, opacity); break;
+            case ADVANCED:   dst ? comp.BlendAdvanced(bg, fg, *dst, mode, opacity) : comp.BlendAdvanced(bg, fg, mode, opacity); break;
+            case ALPHA:      dst ? comp.AlphaComposite(bg, fg, *dst, opacity) : comp.AlphaComposite(bg, fg, opacity); break;
+            case MASK:       dst ? comp.Mask(bg, fg, *mask_layer, *dst) : comp.Mask(bg, fg, *mask_layer); break;
+            case ALPHA_MASK: dst ? comp.Mask(bg, fg, *alpha, *dst) : comp.Mask(bg, fg, *alpha); break;
+            default:         dst ? comp.CompositeMultiple(ptrs, count, modes, opacities, *dst)
+                                 : comp.CompositeMultiple(ptrs, count, modes, opacities); break;
+        }
+
+        Image actual;
+        if (output == SURFACE) {
+            actual = target;
+            for (int32_t y = 0; y < target.height; y++) {
+                for (int32_t x = 0; x < target.width; x++) actual.at(x, y) = surface->row(y)[x];
+            }
+            // Nothing may be written past the window into the stride padding
+            for (int32_t y = 0; y < target.height; y++) {
+                for (int32_t x = target.width; x < surface->stride; x++) {
+                    if (surface->row(y)[x] != sentinel) actual.at(0, y) = CRGB(255, 0, 255);
+                }
+            }
+        } else if (output == IN_PLACE) {
+            actual = gfx_ref::snapshot(bg);
+            // ... without linearizing it first
+            if (write_back && bg.isLinear() != was_linear) actual.px[0] = CRGB(255, 0, 255);
+        } else {
+            actual = captured;
+            // Every pixel exactly once, nothing outside the background
+            for (size_t n = 0; n < captured_hits.size(); n++) {
+                if (captured_hits[n] != 1) actual.px[n] = CRGB(255, 0, 255);
+            }
+            if (stray_calls) actual.px[0] = CRGB(255, 0, 255);
+        }
+
+        std::string what = format("%s", op_names[op]);
+        if (op == ADVANCED || op == MULTIPLE) what += format(" %s", mode_names[mode]);
+        if (op == BLEND || op == ADVANCED || op == ALPHA) what += format(" opacity %u", opacity);
+        if (op == ADVANCED || op == ALPHA) what += fg.transparency_enabled ? " keyed" : "";
+        what += format(" x%u -> %s%s%s", count - 1, output_names[output], write_back ? " (writeBackToBg)" : "",
+                       pooled ? " pooled" : "");
+        for (uint8_t n = 0; n < count; n++) {
+            what += format(" [%ux%u@%d,%d%s]", layers[n]->getWidth(), layers[n]->getHeight(), layers[n]->getPositionX(),
+                           layers[n]->getPositionY(), layers[n]->isRingScroll() ? " ring" : "");
+        }
+        check(group, i, what, expected, actual);
+    }
+}
+
+
+// In-place composites over a background at a fractional position, against the same
+// composite into a separate buffer. Resampling the background reads the row above and
+// the column to the left, which rendering in place overwrites.
+void testCompositorSubpixel()
+{
+    const char *group = "compositor_subpixel";
+    if (!selected(group)) return;
+
+    GFX_LayerCompositor serial(no_callback), comp(no_callback);
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(18, i);
+        const uint16_t w = rng.range(1, 100), h = rng.range(1, 48);
+        const bool ring = rng.chance(40), pooled = rng.chance(70);
+
+        std::unique_ptr<GFX_Layer> plain = makeLayer(rng, w, h, false);
+        std::unique_ptr<GFX_Layer> bg = copyLayer(rng, *plain, ring);
+        const int32_t x_q8 = rng.range(-6, 6) * 256 + rng.range(0, 255), y_q8 = rng.range(-6, 6) * 256 + rng.range(1, 255);
+        plain->setPositionQ8(x_q8, y_q8);
+        bg->setPositionQ8(x_q8, y_q8);
+
+        std::unique_ptr<GFX_Layer> fg = makeLayer(rng, rng.range(1, 100), rng.range(1, 48), rng.chance(40));
+        place(rng, *fg, *plain);
+        if (rng.chance(30)) fg->setPositionQ8(fg->getPositionX() * 256 + rng.byte(), fg->getPositionY() * 256 + rng.byte());
+        fg->setTransparency(rng.chance(70));
+
+        const int op = rng.range(0, 3);
+        GFX_LayerCompositor::BlendMode modes[2] = { GFX_LayerCompositor::BLEND_NORMAL,
+                                                    (GFX_LayerCompositor::BlendMode)(rng.next() % 10) };
+        uint8_t opacities[2] = { 255, rng.amount() };
+
+        auto run = [&](GFX_LayerCompositor &c, GFX_Layer &back, const GFX_Surface &dst) {
+            GFX_Layer *layers[2] = { &back, fg.get() };
+            switch (op) {
+                case 0:
+                case 3:  c.Stack(back, *fg, dst); break;
+                case 1:  c.BlendAdvanced(back, *fg, dst, modes[1], opacities[1]); break;
+                default: c.CompositeMultiple(layers, 2, modes, opacities, dst); break;
+            }
+        };
+
+        // Expected: the same composite into a buffer over the background's rectangle
+        std::vector<CRGB> buffer((size_t)w * h);
+        run(serial, *plain, GFX_Surface(buffer.data(), w, h, w, plain->getPositionX(), plain->getPositionY()));
+        Image expected(0, 0, w, h);
+        expected.px = buffer;
+
+        comp.setWorkerPool(pooled ? pool : nullptr);
+        if (op == 3) comp.Stack(*bg, *fg, true);
+        else         run(comp, *bg, GFX_Surface(*bg));
+
+        static const char *names[] = { "Stack", "BlendAdvanced", "CompositeMultiple", "Stack(writeBackToBg)" };
+        check(group, i, format("%s in place, background %ux%u@%d,%d (q8)%s%s, foreground %ux%u@%d,%d", names[op],
+                               w, h, x_q8, y_q8, ring ? " ring" : "", pooled ? " pooled" : "",
+                               fg->getWidth(), fg->getHeight(), fg->getPositionX(), fg->getPositionY()),
+              expected, gfx_ref::snapshot(*bg));
+    }
+}
+
+/* ---- Alpha masks ------------------------------------------------------------------ */
+
+// A mask of random alpha values
+std::unique_ptr<GFX_AlphaMask> makeMask(Rng &rng, uint16_t w, uint16_t h)
+{
+    std::unique_ptr<GFX_AlphaMask> alpha(new GFX_AlphaMask(w, h));
+    for (int16_t y = 0; y < h; y++) {
+        for (int16_t x = 0; x < w; x++) alpha->setAlpha(x, y, rng.amount());
+    }
+    return alpha;
+}
+
+// Mask contents copied alpha by alpha
+std::unique_ptr<GFX_AlphaMask> copyMask(const GFX_AlphaMask &src)
+{
+    std::unique_ptr<GFX_AlphaMask> alpha(new GFX_AlphaMask(src.getWidth(), src.getHeight()));
+    for (int16_t y = 0; y < src.getHeight(); y++) {
+        for (int16_t x = 0; x < src.getWidth(); x++) alpha->setAlpha(x, y, src.getAlpha(x, y));
+    }
+    return alpha;
+}
+
+void testMasks()
+{
+    const char *group = "mask";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(10, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 60);
+        const uint16_t lw = rng.chance(50) ? w : rng.range(1, 90), lh = rng.chance(50) ? h : rng.range(1, 60);
+        const bool ring = rng.chance(50);
+
+        std::unique_ptr<GFX_AlphaMask> ref = makeMask(rng, w, h);
+        std::unique_ptr<GFX_AlphaMask> lib = copyMask(*ref);
+
+        std::unique_ptr<GFX_Layer> plain = makeLayer(rng, lw, lh, false);
+        std::unique_ptr<GFX_Layer> source = copyLayer(rng, *plain, ring);
+
+        gfx_ref::fromLuminance(*ref, *plain);
+        lib->fromLuminance(*source);
+
+        check(group, i, format("fromLuminance %ux%u from %ux%u%s", w, h, lw, lh, ring ? " ring" : ""),
+              gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+// GFX_AlphaMask's own fills and GFX primitives drawn on it, against a pen that sets one
+// alpha at a time
+void testMaskDrawing()
+{
+    const char *group = "mask_draw";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(13, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 60);
+
+        std::unique_ptr<GFX_AlphaMask> ref = makeMask(rng, w, h);
+        std::unique_ptr<GFX_AlphaMask> lib = copyMask(*ref);
+        gfx_ref::MaskPen pen(*ref);
+
+        std::string what;
+        for (int n = rng.range(1, 4); n > 0; n--) {
+            const CRGB c = rng.color();
+            const uint16_t c565 = rng.next();
+            const int16_t x = rng.range(-w, 2 * w), y = rng.range(-h, 2 * h);
+            const int16_t x2 = rng.range(-w, 2 * w), y2 = rng.range(-h, 2 * h);
+            const int16_t rw = rng.range(-8, 2 * w), rh = rng.range(-8, 2 * h), r = rng.range(0, w);
+
+            switch (rng.range(0, 7)) {
+                case 0:
+                    lib->fillRect(x, y, rw, rh, c);
+                    pen.fillRect(x, y, rw, rh, c);
+                    what += format(" fillRect(%d,%d,%d,%d)", x, y, rw, rh);
+                    break;
+                case 1:
+                    lib->fillRect(x, y, rw, rh, c565);
+                    pen.fillRect(x, y, rw, rh, c565);
+                    what += format(" fillRect(%d,%d,%d,%d,565)", x, y, rw, rh);
+                    break;
+                case 2:
+                    lib->drawPixel(x, y, c);
+                    pen.drawPixel(x, y, c);
+                    what += format(" drawPixel(%d,%d)", x, y);
+                    break;
+                case 3:
+                    lib->fillCircle(x, y, r, c);
+                    pen.fillCircle(x, y, r, c);
+                    what += format(" fillCircle(%d,%d,%d)", x, y, r);
+                    break;
+                case 4:
+                    lib->fillTriangle(x, y, x2, y2, x + rw, y2 + rh, c565);
+                    pen.fillTriangle(x, y, x2, y2, x + rw, y2 + rh, c565);
+                    what += format(" fillTriangle(%d,%d,%d,%d,%d,%d)", x, y, x2, y2, x + rw, y2 + rh);
+                    break;
+                case 5:
+                    lib->drawLine(x, y, x2, y2, c);
+                    pen.drawLine(x, y, x2, y2, c);
+                    what += format(" drawLine(%d,%d,%d,%d)", x, y, x2, y2);
+                    break;
+                case 6:
+                    lib->fillScreen(c);
+                    pen.fillScreen(c);
+                    what += " fillScreen";
+                    break;
+                default:
+                    lib->fillAlpha(c.r);
+                    gfx_ref::fillAlpha(*ref, c.r);
+                    what += format(" fillAlpha(%u)", c.r);
+                    break;
+            }
+        }
+
+        check(group, i, what.substr(1) + format(" on %ux%u", w, h), gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+/* ---- Worker pool ------------------------------------------------------------------ */
+
+// parallelFor() over rows, each band running a nested parallelFor() over its row's
+// columns (documented to run serially on that thread); every pixel written exactly once
+void testWorkerPool()
+{
+    const char *group = "pool";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(11, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 90);
+        const uint32_t salt = rng.next();
+
+        Image expected(0, 0, w, h), actual(0, 0, w, h);
+        std::vector<uint8_t> hits((size_t)w * h, 0);
+        for (int32_t y = 0; y < h; y++) {
+            for (int32_t x = 0; x < w; x++) expected.at(x, y) = CRGB(x, y, salt);
+        }
+
+        pool->parallelFor(h, [&](uint16_t begin, uint16_t end, uint8_t) {
+            for (uint16_t y = begin; y < end; y++) {
+                pool->parallelFor(w, [&](uint16_t x0, uint16_t x1, uint8_t) {
+                    for (uint16_t x = x0; x < x1; x++) {
+                        actual.at(x, y) = CRGB(x, y, salt);
+                        hits[(size_t)y * w + x]++;
+                    }
+                });
+            }
+        });
+        for (size_t n = 0; n < hits.size(); n++) {
+            if (hits[n] != 1) actual.px[n] = CRGB(255, 0, 255);
+        }
+
+        check(group, i, format("nested parallelFor %ux%u", w, h), expected, actual);
+    }
+}
+
+/* ---- Layer effects ---------------------------------------------------------------- */
+
+enum Effect {
+    DIM, BRIGHTNESS, BLUR, BLUR2D, BLUR_ROWS, BLUR_COLUMNS, BOX_BLUR, COLOR_MATRIX, CURVE,
+    SUBPIXEL, FLIP_H, FLIP_V, ROTATE_180, SCROLL_X, SCROLL_Y, EFFECT_COUNT
+};
+const char *const effect_names[] = {
+    "dim", "adjustBrightness", "blur", "blur2d", "blurRows", "blurColumns", "boxBlur", "applyColorMatrix",
+    "applyCurve", "moveSubpixel", "flipHorizontal", "flipVertical", "rotate180", "scrollX", "scrollY"
+};
+
+struct EffectArgs {
+    uint8_t  amount, radius, passes;
+    int32_t  dx_q8, dy_q8;
+    int16_t  shift;
+    CRGB     fill;
+    float    saturation, gamma;
+};
+
+void apply(GFX_Layer &layer, Effect effect, const EffectArgs &a)
+{
+    switch (effect) {
+        case DIM:          layer.dim(a.amount); break;
+        case BRIGHTNESS:   layer.adjustBrightness(a.amount); break;
+        case BLUR:         layer.blur(a.amount); break;
+        case BLUR2D:       layer.blur2d(a.amount); break;
+        case BLUR_ROWS:    layer.blurRows(a.amount); break;
+        case BLUR_COLUMNS: layer.blurColumns(a.amount); break;
+        case BOX_BLUR:     layer.boxBlur(a.radius, a.passes, a.amount); break;
+        case COLOR_MATRIX: layer.applyColorMatrix(GFX_ColorMatrix::saturation(a.saturation)); break;
+        case CURVE:        layer.adjustGamma(a.gamma); break;
+        case SUBPIXEL:     layer.moveSubpixel(a.dx_q8, a.dy_q8, a.fill); break;
+        case FLIP_H:       layer.flipHorizontal(); break;
+        case FLIP_V:       layer.flipVertical(); break;
+        case ROTATE_180:   layer.rotate180(); break;
+        case SCROLL_X:     layer.scrollX(a.shift, a.fill); break;
+        case SCROLL_Y:     layer.scrollY(a.shift, a.fill); break;
+        default:           break;
+    }
+}
+
+// Per-pixel versions where the effect is simple enough to state; false otherwise
+bool reference(GFX_Layer &layer, Effect effect, const EffectArgs &a)
+{
+    switch (effect) {
+        case DIM:
+        case BRIGHTNESS:   gfx_ref::scale(layer, a.amount); return true;
+        case FLIP_H:       gfx_ref::flipHorizontal(layer); return true;
+        case FLIP_V:       gfx_ref::flipVertical(layer); return true;
+        case ROTATE_180:   gfx_ref::flipHorizontal(layer); gfx_ref::flipVertical(layer); return true;
+        case SCROLL_X:
+        case SCROLL_Y: {
+            const Image img = gfx_ref::snapshot(layer);
+            const int32_t dx = (effect == SCROLL_X) ? a.shift : 0, dy = (effect == SCROLL_Y) ? a.shift : 0;
+            for (int32_t y = 0; y < img.height; y++) {
+                for (int32_t x = 0; x < img.width; x++) {
+                    const int32_t sx = x - dx, sy = y - dy;
+                    const bool inside = sx >= 0 && sy >= 0 && sx < img.width && sy < img.height;
+                    layer.drawPixel(x, y, inside ? img.at(sx, sy) : a.fill);
+                }
+            }
+            return true;
+        }
+        default:           return false;
+    }
+}
+
+void testEffects()
+{
+    const char *group = "effects";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(4, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 70);
+        const Effect effect = (Effect)(rng.next() % EFFECT_COUNT);
+
+        EffectArgs a;
+        a.amount     = rng.amount();
+        a.radius     = rng.range(0, 6);
+        a.passes     = rng.range(1, 3);
+        a.dx_q8      = rng.range(-3 * 256, 3 * 256);
+        a.dy_q8      = rng.range(-3 * 256, 3 * 256);
+        a.shift      = rng.chance(10) ? rng.range(-2 * w, 2 * w) : rng.range(-8, 8);
+        a.fill       = rng.chance(50) ? CRGB(0, 0, 0) : rng.color();
+        a.saturation = rng.range(0, 200) / 100.0f;
+        a.gamma      = rng.range(40, 300) / 100.0f;
+        if (effect == SCROLL_Y && rng.chance(90)) a.shift = rng.range(-(int32_t)h, h);
+
+        // The plain serial layer is the reference for the ring-scrolled / pooled one
+        std::unique_ptr<GFX_Layer> plain = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = !ring || rng.chance(50);
+        std::unique_ptr<GFX_Layer> fast = copyLayer(rng, *plain, ring);
+        if (pooled) fast->setWorkerPool(pool);
+
+        const std::string what = format("%s on %ux%u%s%s", effect_names[effect], w, h, ring ? " ring" : "", pooled ? " pooled" : "");
+
+        std::unique_ptr<GFX_Layer> ref = copyLayer(rng, *plain, false);
+        const bool has_reference = reference(*ref, effect, a);
+
+        apply(*plain, effect, a);
+        apply(*fast, effect, a);
+
+        if (has_reference) check(group, i, what + " (reference)", gfx_ref::snapshot(*ref), gfx_ref::snapshot(*plain));
+        check(group, i, what, gfx_ref::snapshot(*plain), gfx_ref::snapshot(*fast));
+    }
+}
+
+/* ---- Transforms ------------------------------------------------------------------- */
+
+// Quarter turns in place and into another layer, against per-pixel moves. Sizes that
+// don't fit have to be refused, leaving both layers alone.
+void testRotate()
+{
+    const char *group = "rotate";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(14, i);
+        const int  mode = rng.range(0, 2);             // in place, into another layer, into itself
+        const bool clockwise = rng.chance(50);
+        const uint16_t w = rng.range(1, 70), h = (mode != 1 && rng.chance(80)) ? w : rng.range(1, 70);
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = rng.chance(50);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+        if (pooled) lib->setWorkerPool(pool);
+
+        const char *name = clockwise ? "rotate90" : "rotate270";
+        std::string what;
+        bool ok, expect_ok;
+
+        if (mode == 1) {
+            const bool fits = rng.chance(85);
+            const uint16_t dw = fits ? h : rng.range(1, 70), dh = fits ? w : rng.range(1, 70);
+            std::unique_ptr<GFX_Layer> ref_dst = makeLayer(rng, dw, dh, false);
+            const bool dst_ring = rng.chance(50);
+            std::unique_ptr<GFX_Layer> lib_dst = copyLayer(rng, *ref_dst, dst_ring);
+
+            expect_ok = dw == h && dh == w;
+            if (expect_ok) gfx_ref::rotate(*ref, *ref_dst, clockwise);
+            ok = clockwise ? lib->rotate90(*lib_dst) : lib->rotate270(*lib_dst);
+
+            what = format("%s %ux%u%s into %ux%u%s%s", name, w, h, ring ? " ring" : "", dw, dh,
+                          dst_ring ? " ring" : "", pooled ? " pooled" : "");
+            check(group, i, what, gfx_ref::snapshot(*ref_dst), gfx_ref::snapshot(*lib_dst));
+            check(group, i, what + " (source)", gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+        } else {
+            expect_ok = w == h;
+            if (expect_ok) gfx_ref::rotate(*ref, *ref, clockwise);
+            if (mode == 0) ok = clockwise ? lib->rotate90() : lib->rotate270();
+            else           ok = clockwise ? lib->rotate90(*lib) : lib->rotate270(*lib);
+
+            what = format("%s %s %ux%u%s%s", name, mode == 0 ? "in place" : "into itself", w, h,
+                          ring ? " ring" : "", pooled ? " pooled" : "");
+            check(group, i, what, gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+        }
+
+        if (ok != expect_ok) {
+            check(group, i, what + format(" returned %s", ok ? "true" : "false"),
+                  Image(0, 0, 1, 1, CRGB(expect_ok, 0, 0)), Image(0, 0, 1, 1, CRGB(ok, 0, 0)));
+        }
+    }
+}
+
+// drawAffine() from a (ring-scrolled) layer or a strided buffer, against the inverse
+// transform evaluated at every destination pixel
+void testAffine()
+{
+    const char *group = "affine";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(15, i);
+        const uint16_t w = rng.range(1, 80), h = rng.range(1, 60);
+        const uint16_t sw = rng.range(1, 40), sh = rng.range(1, 40);
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = rng.chance(50);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+        if (pooled) lib->setWorkerPool(pool);
+
+        // The source: a layer, maybe ring-scrolled, or a buffer with padded rows
+        const bool from_layer = rng.chance(50), src_ring = from_layer && rng.chance(50);
+        const uint16_t stride = sw + (from_layer ? 0 : rng.range(0, 5));
+        std::unique_ptr<GFX_Layer> src_layer;
+        std::vector<CRGB> buffer;
+        Image src(0, 0, sw, sh);
+        if (from_layer) {
+            src_layer = makeLayer(rng, sw, sh, src_ring);
+            src = gfx_ref::snapshot(*src_layer);
+        } else {
+            buffer.resize((size_t)stride * sh);
+            for (CRGB &c : buffer) c = rng.chance(20) ? CRGB(0, 0, 0) : rng.color();
+            for (int32_t y = 0; y < sh; y++) {
+                for (int32_t x = 0; x < sw; x++) src.at(x, y) = buffer[(size_t)y * stride + x];
+            }
+        }
+
+        // Spin about the source centre, scale (now and then to nothing), shear, place
+        const float degrees = rng.chance(30) ? rng.range(0, 3) * 90.0f : rng.range(-36000, 36000) / 100.0f;
+        const float sx = rng.chance(3) ? 0.0f : rng.range(20, 300) / 100.0f;
+        const float sy = rng.chance(20) ? rng.range(20, 300) / 100.0f : sx;
+        const float kx = rng.chance(20) ? rng.range(-100, 100) / 100.0f : 0.0f;
+        const float ky = rng.chance(20) ? rng.range(-100, 100) / 100.0f : 0.0f;
+        const int16_t px = rng.range(-10, w + 10), py = rng.range(-10, h + 10);
+
+        GFX_Affine xf;
+        xf.translate(-sw / 2.0f, -sh / 2.0f).rotate(degrees).scale(sx, sy).shear(kx, ky).translate(px, py);
+
+        const uint8_t flags = (rng.chance(50) ? GFX_Affine::BILINEAR : GFX_Affine::NEAREST) |
+                              (rng.chance(40) ? GFX_Affine::COLOR_KEY : 0);
+        const CRGB key = rng.chance(50) ? CRGB(0, 0, 0) : src.at(rng.range(0, sw - 1), rng.range(0, sh - 1));
+
+        gfx_ref::drawAffine(*ref, src, xf, flags, key);
+        if (from_layer) lib->drawAffine(GFX_Surface(*src_layer), xf, flags, key);
+        else            lib->drawAffine(GFX_Surface(buffer.data(), sw, sh, stride), xf, flags, key);
+
+        const std::string what = format("drawAffine %s%s from %ux%u %s%s rotate %.2f scale %.2f,%.2f shear %.2f,%.2f "
+                                        "to (%d,%d) on %ux%u%s%s", (flags & GFX_Affine::BILINEAR) ? "bilinear" : "nearest",
+                                        (flags & GFX_Affine::COLOR_KEY) ? " keyed" : "", sw, sh,
+                                        from_layer ? "layer" : "buffer", src_ring ? " ring" : "", degrees, sx, sy,
+                                        kx, ky, px, py, w, h, ring ? " ring" : "", pooled ? " pooled" : "");
+        check(group, i, what, gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+/* ---- Analysis --------------------------------------------------------------------- */
+
+// The stats as pixels, for check(): the three histograms as rows, then a row with the
+// return value and every other field, 24 bits of each
+Image statsImage(bool ok, const GFX_LayerStats &s)
+{
+    auto pack = [](uint32_t v) { return CRGB(v >> 16, v >> 8, v); };
+
+    Image img(0, 0, 256, 4);
+    for (int ch = 0; ch < 3; ch++) {
+        for (int n = 0; n < 256; n++) img.at(n, ch) = pack(s.histogram[ch][n]);
+    }
+
+    const uint32_t fields[] = { ok, s.flags, s.count, s.dominant_count, (uint32_t)s.min_x, (uint32_t)s.min_y,
+                                (uint32_t)s.max_x, (uint32_t)s.max_y, s.foreground, s.luma_min, s.luma_max };
+    const size_t count = sizeof(fields) / sizeof(fields[0]);
+    for (size_t n = 0; n < count; n++) img.at(n, 3) = pack(fields[n]);
+    img.at(count, 3)     = s.average;
+    img.at(count + 1, 3) = s.dominant;
+    return img;
+}
+
+// computeStats() against a per-pixel tally. Both start from the same junk, so the
+// fields that weren't asked for have to come back as they were.
+void testStats()
+{
+    const char *group = "stats";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(16, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 70);
+        const uint8_t  flags = rng.chance(30) ? GFX_LayerStats::ALL : rng.range(0, GFX_LayerStats::ALL);
+        const CRGB background = rng.chance(60) ? CRGB(0, 0, 0) : rng.color();
+        const bool whole = rng.chance(30);
+
+        int16_t x = 0, y = 0, rw = w, rh = h;
+        if (!whole) {
+            x  = rng.range(-8, w);
+            y  = rng.range(-8, h);
+            rw = rng.range(0, w + 8);
+            rh = rng.range(0, h + 8);
+        }
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = rng.chance(50);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+        if (pooled) lib->setWorkerPool(pool);
+
+        GFX_LayerStats expected;
+        for (int ch = 0; ch < 3; ch++) {
+            for (int n = 0; n < 256; n++) expected.histogram[ch][n] = rng.next() & 0xFFFFFF;
+        }
+        expected.flags          = rng.byte();
+        expected.count          = rng.next() & 0xFFFFFF;
+        expected.average        = rng.color();
+        expected.dominant       = rng.color();
+        expected.dominant_count = rng.next() & 0xFFFFFF;
+        expected.min_x          = rng.next();
+        expected.min_y          = rng.next();
+        expected.max_x          = rng.next();
+        expected.max_y          = rng.next();
+        expected.foreground     = rng.next() & 0xFFFFFF;
+        expected.luma_min       = rng.byte();
+        expected.luma_max       = rng.byte();
+        GFX_LayerStats actual = expected;
+
+        gfx_ref::computeStats(*ref, expected, x, y, rw, rh, flags, background);
+        const bool ok = whole ? lib->computeStats(actual, flags, background)
+                              : lib->computeStats(actual, x, y, rw, rh, flags, background);
+
+        const std::string what = format("computeStats flags 0x%02X (%d,%d %dx%d) on %ux%u%s%s", flags, x, y, rw, rh,
+                                        w, h, ring ? " ring" : "", pooled ? " pooled" : "");
+        check(group, i, what, statsImage(true, expected), statsImage(ok, actual));
+    }
+}
+
+/* ---- Noise fills ------------------------------------------------------------------ */
+
+GFX_NoiseField noiseField(Rng &rng)
+{
+    const int32_t span = rng.chance(20) ? 32767 : 400;    // mostly scales people use
+    return GFX_NoiseField(rng.range(1, 4), rng.next(), rng.range(-span, span), rng.next(), rng.range(-span, span), rng.next());
+}
+
+void testNoise()
+{
+    const char *group = "noise";
+    if (!selected(group)) return;
+
+    GFX_NoiseScratch shared;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(5, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 70);
+        const bool wide = rng.chance(50), blend = rng.chance(30), whole = rng.chance(30);
+        const GFX_NoiseField value = noiseField(rng), hue = noiseField(rng);
+        const uint16_t hue_shift = rng.next();
+
+        int16_t x = 0, y = 0, rw = w, rh = h;
+        if (!whole) {
+            x  = rng.range(-8, w);
+            y  = rng.range(-8, h);
+            rw = rng.range(0, w + 8);
+            rh = rng.range(0, h + 8);
+        }
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = rng.chance(50);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+        if (pooled) lib->setWorkerPool(pool);
+
+        gfx_ref::fillNoise(*ref, wide, x, y, rw, rh, value, hue, hue_shift, blend);
+
+        // Sometimes the layer's own scratch, sometimes one shared across cases
+        GFX_NoiseScratch *scratch = rng.chance(50) ? &shared : nullptr;
+        bool ok;
+        if (whole) {
+            ok = wide ? lib->fillNoise16(value, hue, hue_shift, blend, scratch)
+                      : lib->fillNoise8(value, hue, blend, scratch);
+        } else {
+            ok = wide ? lib->fillNoise16(x, y, rw, rh, value, hue, hue_shift, blend, scratch)
+                      : lib->fillNoise8(x, y, rw, rh, value, hue, blend, scratch);
+        }
+
+        const std::string what = format("fillNoise%s %d octaves (%d,%d %dx%d) on %ux%u%s%s%s%s", wide ? "16" : "8",
+                                        value.octaves, x, y, rw, rh, w, h, blend ? " blend" : "",
+                                        ring ? " ring" : "", pooled ? " pooled" : "", ok ? "" : " (failed)");
+        check(group, i, what, gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+// fillSimplex() against one snoise16() call per pixel and octave
+void testSimplex()
+{
+    const char *group = "simplex";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(7, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 70);
+        const bool blend = rng.chance(30), whole = rng.chance(30);
+        const GFX_NoiseField value = noiseField(rng), hue = noiseField(rng);
+        const uint16_t hue_shift = rng.next();
+
+        int16_t x = 0, y = 0, rw = w, rh = h;
+        if (!whole) {
+            x  = rng.range(-8, w);
+            y  = rng.range(-8, h);
+            rw = rng.range(0, w + 8);
+            rh = rng.range(0, h + 8);
+        }
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = rng.chance(50);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+        if (pooled) lib->setWorkerPool(pool);
+
+        gfx_ref::fillSimplex(*ref, x, y, rw, rh, value, hue, hue_shift, blend);
+
+        const bool ok = whole ? lib->fillSimplex(value, hue, hue_shift, blend)
+                              : lib->fillSimplex(x, y, rw, rh, value, hue, hue_shift, blend);
+
+        const std::string what = format("fillSimplex %d octaves (%d,%d %dx%d) on %ux%u%s%s%s%s", value.octaves,
+                                        x, y, rw, rh, w, h, blend ? " blend" : "", ring ? " ring" : "",
+                                        pooled ? " pooled" : "", ok ? "" : " (failed)");
+        check(group, i, what, gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+// The upscaled 16-bit noise fill, built in random tiles, against bilinear interpolation
+// of the full fill; and its error report against the full fill, as grey levels
+void testNoiseUpscale()
+{
+    const char *group = "noise_upscale";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(8, i);
+        const int w = rng.range(1, 120), h = rng.range(1, 50);
+        const int step = 2 << rng.range(0, 2);
+        const GFX_NoiseField f = noiseField(rng);
+
+        const std::vector<uint8_t> expected = gfx_ref::upscaledNoise16(w, h, step, f);
+
+        std::vector<uint8_t> tiled((size_t)w * h, 0);
+        const int tw = rng.range(1, w), th = rng.range(1, h);
+        for (int ty = 0; ty < h; ty += th) {
+            for (int tx = 0; tx < w; tx += tw) {
+                fill_raw_2dnoise16into8_upscaled_window(&tiled[(size_t)ty * w + tx], w, w, h, tx, ty, tw, th, step,
+                                                        f.octaves, f.x, f.xscale, f.y, f.yscale, f.time);
+            }
+        }
+
+        std::vector<uint8_t> full((size_t)w * h, 0);
+        fill_raw_2dnoise16into8(full.data(), w, h, f.octaves, f.x, f.xscale, f.y, f.yscale, f.time);
+        uint8_t worst = 0;
+        for (size_t k = 0; k < full.size(); k++) worst = std::max(worst, (uint8_t)abs(full[k] - expected[k]));
+        const uint8_t reported = fill_raw_2dnoise16into8_upscale_error(w, h, step, f.octaves, f.x, f.xscale,
+                                                                       f.y, f.yscale, f.time);
+
+        // The error report rides along as one extra row
+        Image want(0, 0, w, h + 1), got(0, 0, w, h + 1);
+        for (size_t k = 0; k < expected.size(); k++) {
+            want.px[k] = CRGB(expected[k], expected[k], expected[k]);
+            got.px[k]  = CRGB(tiled[k], tiled[k], tiled[k]);
+        }
+        want.at(0, h) = CRGB(worst, worst, worst);
+        got.at(0, h)  = CRGB(reported, reported, reported);
+
+        check(group, i, format("step %d, %d octaves, %dx%d in %dx%d tiles", step, f.octaves, w, h, tw, th), want, got);
+    }
+}
+
+// GFX_Layer::mapPalette() through one GFX_PaletteCache shared by every case (so each
+// case also checks it noticed the change) against map_data_into_colors_through_palette()
+void testPalette()
+{
+    const char *group = "palette";
+    if (!selected(group)) return;
+
+    GFX_PaletteCache cache;
+    CRGBPalette16  pal16;
+    CRGBPalette32  pal32;
+    CRGBPalette256 pal256;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(9, i);
+        const uint16_t w = rng.range(1, 90), h = rng.range(1, 70);
+        const int kind = rng.range(0, 3);
+        const TBlendType blend = (TBlendType)rng.range(0, 2);
+        const uint8_t brightness = rng.chance(30) ? 255 : rng.next();
+        const uint8_t opacity    = rng.chance(50) ? 255 : rng.next();
+        const bool whole = rng.chance(30);
+
+        for (CRGB &c : pal16.entries)  c = CRGB(rng.next(), rng.next(), rng.next());
+        for (CRGB &c : pal32.entries)  c = CRGB(rng.next(), rng.next(), rng.next());
+        for (CRGB &c : pal256.entries) c = CRGB(rng.next(), rng.next(), rng.next());
+
+        int16_t x = 0, y = 0, rw = w, rh = h;
+        if (!whole) {
+            x  = rng.range(-8, w);
+            y  = rng.range(-8, h);
+            rw = rng.range(1, w + 8);
+            rh = rng.range(1, h + 8);
+        }
+        std::vector<uint8_t> indices((size_t)rw * rh);
+        for (uint8_t &v : indices) v = rng.next();
+
+        std::unique_ptr<GFX_Layer> ref = makeLayer(rng, w, h, false);
+        const bool ring = rng.chance(50), pooled = rng.chance(50);
+        std::unique_ptr<GFX_Layer> lib = copyLayer(rng, *ref, ring);
+        if (pooled) lib->setWorkerPool(pool);
+
+        static const char *names[] = { "CRGBPalette16", "CRGBPalette32", "CRGBPalette256", "RainbowColors_p" };
+        switch (kind) {
+            case 0:
+                cache.setPalette(pal16, blend);
+                gfx_ref::mapPalette(*ref, x, y, rw, rh, indices.data(), pal16, brightness, blend, opacity);
+                break;
+            case 1:
+                cache.setPalette(pal32, blend);
+                gfx_ref::mapPalette(*ref, x, y, rw, rh, indices.data(), pal32, brightness, blend, opacity);
+                break;
+            case 2:
+                cache.setPalette(pal256, blend);
+                gfx_ref::mapPalette(*ref, x, y, rw, rh, indices.data(), pal256, brightness, blend, opacity);
+                break;
+            default:
+                cache.setPalette(RainbowColors_p, blend);
+                gfx_ref::mapPalette(*ref, x, y, rw, rh, indices.data(), RainbowColors_p, brightness, blend, opacity);
+                break;
+        }
+        cache.setBrightness(brightness);
+
+        if (whole) {
+            lib->mapPalette(indices.data(), cache, opacity);
+        } else {
+            lib->mapPalette(x, y, rw, rh, indices.data(), cache, opacity);
+        }
+
+        const std::string what = format("%s blend %d brightness %u opacity %u (%d,%d %dx%d) on %ux%u%s%s", names[kind],
+                                        blend, brightness, opacity, x, y, rw, rh, w, h, ring ? " ring" : "",
+                                        pooled ? " pooled" : "");
+        check(group, i, what, gfx_ref::snapshot(*ref), gfx_ref::snapshot(*lib));
+    }
+}
+
+// The row kernels against one inoise8() / inoise16() call per sample, as grey levels
+// (16-bit samples as high byte red, low byte green)
+void testNoiseRows()
+{
+    const char *group = "noise_rows";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(6, i);
+        const int count = rng.range(1, 300);
+        const int kind  = rng.range(0, 3);
+        const uint32_t x = rng.next(), y = rng.next(), z = rng.next();
+        const int32_t  dx = (int32_t)rng.next() >> rng.range(0, 31);
+
+        Image expected(0, 0, count, 1), actual(0, 0, count, 1);
+        std::vector<uint16_t> row16(count);
+        std::vector<uint8_t>  row8(count);
+
+        for (int k = 0; k < count; k++) {
+            const uint32_t sx = x + (uint32_t)k * dx;
+            uint16_t v;
+            switch (kind) {
+                case 0:  v = inoise16(sx, y, z); break;
+                case 1:  v = inoise16(sx, y); break;
+                case 2:  v = inoise8(sx, y, z); break;
+                default: v = inoise8(sx, y); break;
+            }
+            expected.at(k, 0) = (kind < 2) ? CRGB(v >> 8, v & 0xFF, 0) : CRGB(v, v, v);
+        }
+
+        switch (kind) {
+            case 0:  inoise16_row(row16.data(), count, x, dx, y, z); break;
+            case 1:  inoise16_row(row16.data(), count, x, dx, y); break;
+            case 2:  inoise8_row(row8.data(), count, x, dx, y, z); break;
+            default: inoise8_row(row8.data(), count, x, dx, y); break;
+        }
+        for (int k = 0; k < count; k++) {
+            actual.at(k, 0) = (kind < 2) ? CRGB(row16[k] >> 8, row16[k] & 0xFF, 0) : CRGB(row8[k], row8[k], row8[k]);
+        }
+
+        static const char *names[] = { "inoise16_row 3D", "inoise16_row 2D", "inoise8_row 3D", "inoise8_row 2D" };
+        check(group, i, format("%s x %d dx %d", names[kind], count, dx), expected, actual);
+    }
+}
+
+// The library's raw and colour 2D noise fills against the original recursive ones, on
+// the same random starting contents (16-bit samples as high byte red, low byte green)
+void testNoiseFills()
+{
+    const char *group = "noise_fills";
+    if (!selected(group)) return;
+
+    for (uint32_t i = 0; i < options.iterations; i++) {
+        Rng rng = caseRng(12, i);
+        const int w = rng.range(1, 90), h = rng.range(1, 70);
+        const int kind = rng.range(0, 4);
+        const GFX_NoiseField value = noiseField(rng), hue = noiseField(rng);
+        const bool serpentine = rng.chance(50), blend = rng.chance(30);
+        const uint16_t hue_shift = rng.next();
+        const size_t n = (size_t)w * h;
+
+        Image expected(0, 0, w, h), actual(0, 0, w, h);
+        std::string what;
+
+        if (kind == 2) {
+            // Random octave frequency and amplitude, as only the 12 argument form takes them
+            const uint8_t freq_i = rng.range(1, 3), freq_f = rng.byte();
+            q88 freq88(freq_i, freq_f);
+            const fract16 amplitude = rng.next();
+            std::vector<uint16_t> ref(n), lib(n);
+            for (size_t k = 0; k < n; k++) ref[k] = lib[k] = rng.next();
+
+            gfx_ref::orig::fill_raw_2dnoise16(ref.data(), w, h, value.octaves, freq88, amplitude, 1,
+                                              value.x, value.xscale, value.y, value.yscale, value.time);
+            fill_raw_2dnoise16(lib.data(), w, h, value.octaves, freq88, amplitude, 1,
+                               value.x, value.xscale, value.y, value.yscale, value.time);
+            for (size_t k = 0; k < n; k++) {
+                expected.px[k] = CRGB(ref[k] >> 8, ref[k] & 0xFF, 0);
+                actual.px[k]   = CRGB(lib[k] >> 8, lib[k] & 0xFF, 0);
+            }
+            what = format("fill_raw_2dnoise16 %d octaves freq %u+%u/256 amplitude %u", value.octaves, freq_i, freq_f,
+                          amplitude);
+        } else if (kind < 2) {
+            std::vector<uint8_t> ref(n), lib(n);
+            for (size_t k = 0; k < n; k++) ref[k] = lib[k] = rng.byte();
+
+            if (kind == 0) {
+                gfx_ref::orig::fill_raw_2dnoise8(ref.data(), w, h, value.octaves, value.x, value.xscale, value.y, value.yscale, value.time);
+                fill_raw_2dnoise8(lib.data(), w, h, value.octaves, value.x, value.xscale, value.y, value.yscale, value.time);
+            } else {
+                gfx_ref::orig::fill_raw_2dnoise16into8(ref.data(), w, h, value.octaves, value.x, value.xscale, value.y, value.yscale, value.time);
+                fill_raw_2dnoise16into8(lib.data(), w, h, value.octaves, value.x, value.xscale, value.y, value.yscale, value.time);
+            }
+            for (size_t k = 0; k < n; k++) {
+                expected.px[k] = CRGB(ref[k], ref[k], ref[k]);
+                actual.px[k]   = CRGB(lib[k], lib[k], lib[k]);
+            }
+            what = format("%s %d octaves", kind == 0 ? "fill_raw_2dnoise8" : "fill_raw_2dnoise16into8", value.octaves);
+        } else {
+            for (size_t k = 0; k < n; k++) expected.px[k] = actual.px[k] = rng.color();
+
+            if (kind == 3) {
+                gfx_ref::orig::fill_2dnoise8(expected.px.data(), w, h, serpentine, value.octaves, value.x, value.xscale,
+                                             value.y, value.yscale, value.time, hue.octaves, hue.x, hue.xscale,
+                                             hue.y, hue.yscale, hue.time, blend);
+                fill_2dnoise8(actual.px.data(), w, h, serpentine, value.octaves, value.x, value.xscale, value.y,
+                              value.yscale, value.time, hue.octaves, hue.x, hue.xscale, hue.y, hue.yscale, hue.time, blend);
+            } else {
+                gfx_ref::orig::fill_2dnoise16(expected.px.data(), w, h, serpentine, value.octaves, value.x, value.xscale,
+                                              value.y, value.yscale, value.time, hue.octaves, hue.x, hue.xscale,
+                                              hue.y, hue.yscale, hue.time, blend, hue_shift);
+                fill_2dnoise16(actual.px.data(), w, h, serpentine, value.octaves, value.x, value.xscale, value.y,
+                               value.yscale, value.time, hue.octaves, hue.x, hue.xscale, hue.y, hue.yscale, hue.time,
+                               blend, hue_shift);
+            }
+            what = format("%s %d octaves%s%s", kind == 3 ? "fill_2dnoise8" : "fill_2dnoise16", value.octaves,
+                          serpentine ? " serpentine" : "", blend ? " blend" : "");
+        }
+
+        check(group, i, format("%s on %dx%d", what.c_str(), w, h), expected, actual);
+    }
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: gfx_diff_test [--seed N] [--iterations N] [--out dir] [--verbose]\n"
+                    "                     [--filter fill|text|ticker|compositor|compositor_subpixel|effects|rotate|affine|\n"
+                    "                               stats|mask|mask_draw|pool|noise|noise_fills|noise_rows|noise_upscale|\n"
+                    "                               simplex|palette]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg  = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if      (!strcmp(arg, "--seed")       && next) { options.seed = strtoul(next, nullptr, 0); i++; }
+        else if (!strcmp(arg, "--iterations") && next) { options.iterations = strtoul(next, nullptr, 0); i++; }
+        else if (!strcmp(arg, "--filter")     && next) { options.filter = next; i++; }
+        else if (!strcmp(arg, "--out")        && next) { options.out_dir = next; i++; }
+        else if (!strcmp(arg, "--verbose")) options.verbose = true;
+        else { usage(); return 2; }
+    }
+
+    GFX_WorkerPool workers(4);
+    pool = &workers;
+
+    testFills();
+    testText();
+    testTicker();
+    testCompositor();
+    testCompositorSubpixel();
+    testEffects();
+    testRotate();
+    testAffine();
+    testStats();
+    testMasks();
+    testMaskDrawing();
+    testWorkerPool();
+    testNoise();
+    testNoiseRows();
+    testNoiseFills();
+    testNoiseUpscale();
+    testPalette();
+    testSimplex();
+
+    printf("gfx_diff_test: seed %u, %u cases, %u failed\n", options.seed, cases, failures);
+    return failures ? 1 : 0;
+}
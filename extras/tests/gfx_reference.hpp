@@ -0,0 +1,786 @@
+/**
+ * Straightforward reference versions of the GFX_Lite paths that have fast paths.
+ *
+ * Everything here goes one pixel at a time through GFX_Layer::drawPixel() and
+ * getPixel(), the two calls every optimisation has to agree with, and spells the
+ * compositor's per-pixel rules out in plain scalar code. gfx_diff_test renders the
+ * same scenes through these and through the library and compares the results.
+ *
+ * When a fast path deliberately changes the output, change the rule here in the same
+ * commit, so the difference shows up in review.
+ */
+
+#ifndef GFX_REFERENCE_HPP
+#define GFX_REFERENCE_HPP
+
+#include "GFX_Layer.hpp"
+#include "glcdfont.c"            // the classic font; static, so this is our own copy
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace gfx_ref {
+
+typedef GFX_LayerCompositor::BlendMode BlendMode;
+
+// A canvas-positioned block of pixels, like a GFX_Surface that owns its memory
+struct Image {
+    int32_t x = 0, y = 0;
+    int32_t width = 0, height = 0;
+    std::vector<CRGB> px;
+
+    Image() {}
+    Image(int32_t cx, int32_t cy, int32_t w, int32_t h, CRGB fill = CRGB(0, 0, 0))
+        : x(cx), y(cy), width(w), height(h), px((size_t)w * h, fill) {}
+
+    CRGB &at(int32_t ix, int32_t iy) { return px[(size_t)iy * width + ix]; }
+    const CRGB &at(int32_t ix, int32_t iy) const { return px[(size_t)iy * width + ix]; }
+};
+
+// Logical layer contents (ring scroll resolved)
+inline Image snapshot(GFX_Layer &layer)
+{
+    Image img(layer.getPositionX(), layer.getPositionY(), layer.getWidth(), layer.getHeight());
+    for (int32_t y = 0; y < img.height; y++) {
+        for (int32_t x = 0; x < img.width; x++) img.at(x, y) = layer.getPixel(x, y);
+    }
+    return img;
+}
+
+/* ---- Drawing ---------------------------------------------------------------------- */
+
+inline void fillRect(GFX_Layer &layer, int16_t x, int16_t y, int16_t w, int16_t h, CRGB color)
+{
+    for (int32_t j = y; j < (int32_t)y + h; j++) {
+        for (int32_t i = x; i < (int32_t)x + w; i++) {
+            if (i >= INT16_MIN && i <= INT16_MAX && j >= INT16_MIN && j <= INT16_MAX) {
+                layer.drawPixel((int16_t)i, (int16_t)j, color);
+            }
+        }
+    }
+}
+
+// One glyph cell of size sx x sy, in the layer's 565 path like drawChar()
+inline void fillCell(GFX_Layer &layer, int32_t x, int32_t y, uint8_t sx, uint8_t sy, uint16_t color)
+{
+    for (int32_t j = 0; j < sy; j++) {
+        for (int32_t i = 0; i < sx; i++) layer.drawPixel((int16_t)(x + i), (int16_t)(y + j), color);
+    }
+}
+
+/*
+ * print() with a transparent background: the classic 6x8 font when font is null,
+ * otherwise a GFXfont with the cursor on the baseline. Wraps like GFX::write().
+ */
+inline void print(GFX_Layer &layer, const GFXfont *gfx_font, uint8_t sx, uint8_t sy,
+                  int16_t cursor_x, int16_t cursor_y, const char *text, uint16_t color, bool wrap = true)
+{
+    const int32_t width = layer.getWidth();
+    int32_t cx = cursor_x, cy = cursor_y;
+
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        unsigned char c = *p;
+
+        if (!gfx_font) {
+            if (c == '\n') { cx = 0; cy += sy * 8; continue; }
+            if (c == '\r') continue;
+            if (wrap && cx + sx * 6 > width) { cx = 0; cy += sy * 8; }
+
+            unsigned char g = (c >= 176) ? c + 1 : c;   // 'classic' charset quirk
+            for (int32_t i = 0; i < 5; i++) {
+                uint8_t line = font[g * 5 + i];
+                for (int32_t j = 0; j < 8; j++, line >>= 1) {
+                    if (line & 1) fillCell(layer, cx + i * sx, cy + j * sy, sx, sy, color);
+                }
+            }
+            cx += sx * 6;
+            continue;
+        }
+
+        if (c == '\n') { cx = 0; cy += sy * gfx_font->yAdvance; continue; }
+        if (c == '\r' || c < gfx_font->first || c > gfx_font->last) continue;
+
+        const GFXglyph &glyph = gfx_font->glyph[c - gfx_font->first];
+        if (glyph.width > 0 && glyph.height > 0) {
+            if (wrap && cx + sx * (glyph.xOffset + glyph.width) > width) { cx = 0; cy += sy * gfx_font->yAdvance; }
+
+            const uint8_t *bits = gfx_font->bitmap + glyph.bitmapOffset;
+            for (int32_t yy = 0, bit = 0; yy < glyph.height; yy++) {
+                for (int32_t xx = 0; xx < glyph.width; xx++, bit++) {
+                    if (bits[bit >> 3] & (0x80 >> (bit & 7))) {
+                        fillCell(layer, cx + (glyph.xOffset + xx) * sx, cy + (glyph.yOffset + yy) * sy, sx, sy, color);
+                    }
+                }
+            }
+        }
+        cx += glyph.xAdvance * sx;
+    }
+}
+
+/* ---- Compositing ------------------------------------------------------------------ */
+
+inline uint8_t mix(BlendMode mode, uint8_t base, uint8_t overlay)
+{
+    switch (mode) {
+        case GFX_LayerCompositor::BLEND_MULTIPLY:   return (base * overlay) / 255;
+        case GFX_LayerCompositor::BLEND_SCREEN:     return 255 - ((255 - base) * (255 - overlay)) / 255;
+        case GFX_LayerCompositor::BLEND_OVERLAY:
+            return (base < 128) ? (2 * base * overlay) / 255 : 255 - (2 * (255 - base) * (255 - overlay)) / 255;
+        case GFX_LayerCompositor::BLEND_DARKEN:     return (overlay < base) ? overlay : base;
+        case GFX_LayerCompositor::BLEND_LIGHTEN:    return (overlay > base) ? overlay : base;
+        case GFX_LayerCompositor::BLEND_ADD:        return (base + overlay > 255) ? 255 : base + overlay;
+        case GFX_LayerCompositor::BLEND_SUBTRACT:   return (base > overlay) ? base - overlay : 0;
+        case GFX_LayerCompositor::BLEND_DIFFERENCE: return (base > overlay) ? base - overlay : overlay - base;
+        case GFX_LayerCompositor::BLEND_COLOR_DODGE: {
+            if (overlay == 255) return 255;
+            int v = (base * 255) / (255 - overlay);
+            return (v > 255) ? 255 : v;
+        }
+        case GFX_LayerCompositor::BLEND_NORMAL:
+        default:                                    return overlay;
+    }
+}
+
+// One foreground pixel over one background pixel
+inline CRGB blendPixel(BlendMode mode, uint8_t opacity, bool keyed, CRGB key, CRGB base, CRGB overlay)
+{
+    if (opacity == 0) return base;
+    if (keyed && overlay == key) return base;
+
+    CRGB result(mix(mode, base.r, overlay.r), mix(mode, base.g, overlay.g), mix(mode, base.b, overlay.b));
+    if (opacity < 255) {
+        result.r = blend8(base.r, result.r, opacity);
+        result.g = blend8(base.g, result.g, opacity);
+        result.b = blend8(base.b, result.b, opacity);
+    }
+    return result;
+}
+
+// Layer pixel under canvas position (cx,cy); false when the layer doesn't cover it
+inline bool sample(GFX_Layer &layer, int32_t cx, int32_t cy, CRGB &out)
+{
+    const int32_t x = cx - layer.getPositionX(), y = cy - layer.getPositionY();
+    if (x < 0 || y < 0 || x >= layer.getWidth() || y >= layer.getHeight()) return false;
+    out = layer.getPixel(x, y);
+    return true;
+}
+
+// Output over the background's canvas rectangle; rule(cx, cy, bg) gives each pixel
+template <class Rule>
+Image composite(GFX_Layer &bg, Rule rule)
+{
+    Image out = snapshot(bg);
+    for (int32_t y = 0; y < out.height; y++) {
+        for (int32_t x = 0; x < out.width; x++) {
+            out.at(x, y) = rule(out.x + x, out.y + y, out.at(x, y));
+        }
+    }
+    return out;
+}
+
+inline Image blend(GFX_Layer &bg, GFX_Layer &fg, BlendMode mode, uint8_t opacity, bool keyed)
+{
+    return composite(bg, [&](int32_t cx, int32_t cy, CRGB base) {
+        CRGB overlay;
+        return sample(fg, cx, cy, overlay) ? blendPixel(mode, opacity, keyed, fg.transparency_colour, base, overlay) : base;
+    });
+}
+
+inline Image siloette(GFX_Layer &bg, GFX_Layer &fg)
+{
+    return composite(bg, [&](int32_t cx, int32_t cy, CRGB base) {
+        CRGB overlay;
+        return (sample(fg, cx, cy, overlay) && overlay != fg.transparency_colour) ? base : CRGB(0, 0, 0);
+    });
+}
+
+inline Image mask(GFX_Layer &bg, GFX_Layer &fg, GFX_Layer &mask_layer)
+{
+    return composite(bg, [&](int32_t cx, int32_t cy, CRGB base) {
+        CRGB overlay, m;
+        if (!sample(fg, cx, cy, overlay) || !sample(mask_layer, cx, cy, m)) return base;
+        return ::blend(base, overlay, (uint8_t)((m.r + m.g + m.b) / 3));
+    });
+}
+
+inline Image mask(GFX_Layer &bg, GFX_Layer &fg, GFX_AlphaMask &alpha)
+{
+    return composite(bg, [&](int32_t cx, int32_t cy, CRGB base) {
+        CRGB overlay;
+        const int32_t mx = cx - alpha.getPositionX(), my = cy - alpha.getPositionY();
+        if (!sample(fg, cx, cy, overlay) || mx < 0 || my < 0 || mx >= alpha.getWidth() || my >= alpha.getHeight()) return base;
+        return ::blend(base, overlay, alpha.getAlpha(mx, my));
+    });
+}
+
+// layers[0] is the base, the rest are blended on in order
+inline Image compositeMultiple(GFX_Layer *layers[], uint8_t count, BlendMode modes[], uint8_t opacities[])
+{
+    return composite(*layers[0], [&](int32_t cx, int32_t cy, CRGB acc) {
+        for (uint8_t i = 1; i < count; i++) {
+            CRGB overlay;
+            if (sample(*layers[i], cx, cy, overlay)) {
+                acc = blendPixel(modes[i], opacities[i], layers[i]->transparency_enabled,
+                                 layers[i]->transparency_colour, acc, overlay);
+            }
+        }
+        return acc;
+    });
+}
+
+/* ---- Alpha masks ------------------------------------------------------------------ */
+
+// Mask contents as grey levels
+inline Image snapshot(const GFX_AlphaMask &alpha)
+{
+    Image img(alpha.getPositionX(), alpha.getPositionY(), alpha.getWidth(), alpha.getHeight());
+    for (int32_t y = 0; y < img.height; y++) {
+        for (int32_t x = 0; x < img.width; x++) {
+            const uint8_t a = alpha.getAlpha(x, y);
+            img.at(x, y) = CRGB(a, a, a);
+        }
+    }
+    return img;
+}
+
+// The overlapping top-left part of the mask takes the layer's logical pixels' luminance
+inline void fromLuminance(GFX_AlphaMask &alpha, GFX_Layer &layer)
+{
+    for (int16_t y = 0; y < alpha.getHeight() && y < layer.getHeight(); y++) {
+        for (int16_t x = 0; x < alpha.getWidth() && x < layer.getWidth(); x++) {
+            const CRGB c = layer.getPixel(x, y);
+            alpha.setAlpha(x, y, (c.r + c.g + c.b) / 3);
+        }
+    }
+}
+
+/*
+ * A GFX that sets mask alpha one pixel at a time, so GFX primitives drawn on it go
+ * through the base class fillRect() instead of GFX_AlphaMask's row fill.
+ */
+struct MaskPen : GFX {
+    GFX_AlphaMask &alpha;
+
+    explicit MaskPen(GFX_AlphaMask &a) : GFX(a.getWidth(), a.getHeight()), alpha(a) {}
+
+    void drawPixel(int16_t x, int16_t y, CRGB c) { alpha.setAlpha(x, y, (c.r + c.g + c.b) / 3); }
+    void drawPixel(int16_t x, int16_t y, uint16_t c) { drawPixel(x, y, color565_to_CRGB(c)); }
+};
+
+inline void fillAlpha(GFX_AlphaMask &alpha, uint8_t a)
+{
+    for (int16_t y = 0; y < alpha.getHeight(); y++) {
+        for (int16_t x = 0; x < alpha.getWidth(); x++) alpha.setAlpha(x, y, a);
+    }
+}
+
+/* ---- Whole-layer effects ---------------------------------------------------------- */
+
+inline void scale(GFX_Layer &layer, uint8_t value)
+{
+    for (int16_t y = 0; y < layer.getHeight(); y++) {
+        for (int16_t x = 0; x < layer.getWidth(); x++) {
+            CRGB c = layer.getPixel(x, y);
+            c.nscale8(value);
+            layer.drawPixel(x, y, c);
+        }
+    }
+}
+
+inline void flipHorizontal(GFX_Layer &layer)
+{
+    Image img = snapshot(layer);
+    for (int32_t y = 0; y < img.height; y++) {
+        for (int32_t x = 0; x < img.width; x++) layer.drawPixel(x, y, img.at(img.width - 1 - x, y));
+    }
+}
+
+inline void flipVertical(GFX_Layer &layer)
+{
+    Image img = snapshot(layer);
+    for (int32_t y = 0; y < img.height; y++) {
+        for (int32_t x = 0; x < img.width; x++) layer.drawPixel(x, y, img.at(x, img.height - 1 - y));
+    }
+}
+
+/* ---- Original noise fills --------------------------------------------------------- */
+
+/*
+ * The 2D noise fills as they were before the octave loop and the row kernels: one
+ * recursion per octave and one inoise8() / inoise16() call per sample. Kept as they
+ * were, apart from std::vector for the stack arrays and orig:: on the calls (q44 and
+ * q88 arguments would otherwise find the library's versions too), so the library's
+ * fills can be checked against them.
+ */
+namespace orig {
+
+inline void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, q44 freq44, fract8 amplitude, int skip, uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time) {
+  if(octaves > 1) {
+    orig::fill_raw_2dnoise8(pData, width, height, octaves-1, freq44, amplitude, skip+1, x*freq44, freq44 * scalex, y*freq44, freq44 * scaley, time);
+  } else {
+    // amplitude is always 255 on the lowest level
+    amplitude=255;
+  }
+
+  scalex *= skip;
+  scaley *= skip;
+
+  fract8 invamp = 255-amplitude;
+  uint16_t xx = x;
+  for(int i = 0; i < height; ++i, y+=scaley) {
+    uint8_t *pRow = pData + (i*width);
+    xx = x;
+    for(int j = 0; j < width; ++j, xx+=scalex) {
+      uint8_t noise_base = inoise8(xx,y,time);
+      noise_base = (0x80 & noise_base) ? (noise_base - 127) : (127 - noise_base);
+      noise_base = scale8(noise_base<<1,amplitude);
+      if(skip == 1) {
+        pRow[j] = scale8(pRow[j],invamp) + noise_base;
+      } else {
+        for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
+          uint8_t *pRow = pData + (ii*width);
+          for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
+            pRow[jj] = scale8(pRow[jj],invamp) + noise_base;
+          }
+        }
+      }
+    }
+  }
+}
+
+inline void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, uint16_t x, int scalex, uint16_t y, int scaley, uint16_t time) {
+  orig::fill_raw_2dnoise8(pData, width, height, octaves, q44(2,0), 128, 1, x, scalex, y, scaley, time);
+}
+
+inline void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves, q88 freq88, fract16 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  if(octaves > 1) {
+    orig::fill_raw_2dnoise16(pData, width, height, octaves-1, freq88, amplitude, skip, x *freq88 , scalex *freq88, y * freq88, scaley * freq88, time);
+  } else {
+    // amplitude is always 255 on the lowest level
+    amplitude=65535;
+  }
+
+  scalex *= skip;
+  scaley *= skip;
+  fract16 invamp = 65535-amplitude;
+  for(int i = 0; i < height; i+=skip, y+=scaley) {
+    uint16_t *pRow = pData + (i*width);
+    // xx was an int here; unsigned is the same bits without the signed overflow
+    uint32_t xx = x;
+    for(int j = 0; j < width; j+=skip, xx+=scalex) {
+      uint16_t noise_base = inoise16(xx,y,time);
+      noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
+      noise_base = scale16(noise_base<<1, amplitude);
+      if(skip==1) {
+        pRow[j] = scale16(pRow[j],invamp) + noise_base;
+      } else {
+        for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
+          uint16_t *pRow = pData + (ii*width);
+          for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
+            pRow[jj] = scale16(pRow[jj],invamp) + noise_base;
+          }
+        }
+      }
+    }
+  }
+}
+
+inline void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, q44 freq44, fract8 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  if(octaves > 1) {
+    orig::fill_raw_2dnoise16into8(pData, width, height, octaves-1, freq44, amplitude, skip+1, x*freq44, scalex *freq44, y*freq44, scaley * freq44, time);
+  } else {
+    // amplitude is always 255 on the lowest level
+    amplitude=255;
+  }
+
+  scalex *= skip;
+  scaley *= skip;
+  uint32_t xx;
+  fract8 invamp = 255-amplitude;
+  for(int i = 0; i < height; i+=skip, y+=scaley) {
+    uint8_t *pRow = pData + (i*width);
+    xx = x;
+    for(int j = 0; j < width; j+=skip, xx+=scalex) {
+      uint16_t noise_base = inoise16(xx,y,time);
+      noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
+      noise_base = scale8(noise_base>>7,amplitude);
+      if(skip==1) {
+        pRow[j] = qadd8(scale8(pRow[j],invamp),noise_base);
+      } else {
+        for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
+          uint8_t *pRow = pData + (ii*width);
+          for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
+            pRow[jj] = scale8(pRow[jj],invamp) + noise_base;
+          }
+        }
+      }
+    }
+  }
+}
+
+inline void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, uint32_t x, int scalex, uint32_t y, int scaley, uint32_t time) {
+  orig::fill_raw_2dnoise16into8(pData, width, height, octaves, q44(2,0), 171, 1, x, scalex, y, scaley, time);
+}
+
+inline void fill_2dnoise8(CRGB *leds, int width, int height, bool serpentine,
+            uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
+  std::vector<uint8_t> V((size_t)height*width, 0);
+  std::vector<uint8_t> H((size_t)height*width, 0);
+
+  orig::fill_raw_2dnoise8(V.data(),width,height,octaves,x,xscale,y,yscale,time);
+  orig::fill_raw_2dnoise8(H.data(),width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+
+  int w1 = width-1;
+  int h1 = height-1;
+  for(int i = 0; i < height; ++i) {
+    int wb = i*width;
+    for(int j = 0; j < width; ++j) {
+      CRGB led(CHSV(H[(h1-i)*width + (w1-j)],255,V[wb+j]));
+
+      int pos = j;
+      if(serpentine && (i & 0x1)) {
+        pos = w1-j;
+      }
+
+      if(blend) {
+        leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
+      } else {
+        leds[wb+pos] = led;
+      }
+    }
+  }
+}
+
+inline void fill_2dnoise16(CRGB *leds, int width, int height, bool serpentine,
+            uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift) {
+  std::vector<uint8_t> V((size_t)height*width, 0);
+  std::vector<uint8_t> H((size_t)height*width, 0);
+
+  orig::fill_raw_2dnoise16into8(V.data(),width,height,octaves,q44(2,0),171,1,x,xscale,y,yscale,time);
+  orig::fill_raw_2dnoise8(H.data(),width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+
+  int w1 = width-1;
+  int h1 = height-1;
+  hue_shift >>= 8;
+
+  for(int i = 0; i < height; ++i) {
+    int wb = i*width;
+    for(int j = 0; j < width; ++j) {
+      CRGB led(CHSV(hue_shift + (H[(h1-i)*width + (w1-j)]),196,V[wb+j]));
+
+      int pos = j;
+      if(serpentine && (i & 0x1)) {
+        pos = w1-j;
+      }
+
+      if(blend) {
+        leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
+      } else {
+        leds[wb+pos] = led;
+      }
+    }
+  }
+}
+
+} // namespace orig
+
+/* ---- Transforms ------------------------------------------------------------------- */
+
+// rotate90() / rotate270(): source (x,y) lands on (H-1-y, x) / (y, W-1-x) of 'dst',
+// which may be 'src' itself
+inline void rotate(GFX_Layer &src, GFX_Layer &dst, bool clockwise)
+{
+    const Image img = snapshot(src);
+    for (int32_t y = 0; y < img.height; y++) {
+        for (int32_t x = 0; x < img.width; x++) {
+            if (clockwise) dst.drawPixel(img.height - 1 - y, x, img.at(x, y));
+            else           dst.drawPixel(y, img.width - 1 - x, img.at(x, y));
+        }
+    }
+}
+
+/*
+ * drawAffine(): every destination pixel centre mapped back through the inverse
+ * transform in 16.16, computed afresh per pixel, and sampled when it lands inside
+ * 'src'. Bilinear taps are clamped at the edges; keyed taps take the nearest colour.
+ */
+inline void drawAffine(GFX_Layer &layer, const Image &src, const GFX_Affine &xf, uint8_t flags, CRGB key)
+{
+    const float det = xf.a * xf.d - xf.b * xf.c;
+    if (src.width == 0 || src.height == 0 || fabsf(det) < 1e-9f) return;
+
+    const float ia =  xf.d / det, ib = -xf.b / det;
+    const float ic = -xf.c / det, id =  xf.a / det;
+    const float ox = 0.5f - xf.tx, oy = 0.5f - xf.ty;
+
+    const int64_t u00 = llroundf((ia * ox + ib * oy) * 65536.0f), v00 = llroundf((ic * ox + id * oy) * 65536.0f);
+    const int64_t du_dx = llroundf(ia * 65536.0f), dv_dx = llroundf(ic * 65536.0f);
+    const int64_t du_dy = llroundf(ib * 65536.0f), dv_dy = llroundf(id * 65536.0f);
+
+    for (int32_t y = 0; y < layer.getHeight(); y++) {
+        for (int32_t x = 0; x < layer.getWidth(); x++) {
+            const int64_t u = u00 + y * du_dy + x * du_dx;
+            const int64_t v = v00 + y * dv_dy + x * dv_dx;
+            if (u < 0 || v < 0 || u >= ((int64_t)src.width << 16) || v >= ((int64_t)src.height << 16)) continue;
+
+            const CRGB nearest = src.at(u >> 16, v >> 16);
+            if ((flags & GFX_Affine::COLOR_KEY) && nearest == key) continue;
+            if (!(flags & GFX_Affine::BILINEAR)) {
+                layer.drawPixel(x, y, nearest);
+                continue;
+            }
+
+            const int64_t su = u - 0x8000, sv = v - 0x8000;
+            const int32_t fx = (su >> 8) & 0xFF, fy = (sv >> 8) & 0xFF;
+            const int32_t x0 = std::max<int64_t>(su >> 16, 0), x1 = std::min<int64_t>((su >> 16) + 1, src.width - 1);
+            const int32_t y0 = std::max<int64_t>(sv >> 16, 0), y1 = std::min<int64_t>((sv >> 16) + 1, src.height - 1);
+
+            CRGB tap[4] = { src.at(x0, y0), src.at(x1, y0), src.at(x0, y1), src.at(x1, y1) };
+            CRGB out;
+            for (int n = 0; n < 4; n++) {
+                if ((flags & GFX_Affine::COLOR_KEY) && tap[n] == key) tap[n] = nearest;
+            }
+            for (int ch = 0; ch < 3; ch++) {
+                const uint32_t top = tap[0].raw[ch] * (256 - fx) + tap[1].raw[ch] * fx;
+                const uint32_t bot = tap[2].raw[ch] * (256 - fx) + tap[3].raw[ch] * fx;
+                out.raw[ch] = (top * (256 - fy) + bot * fy + 32768) >> 16;
+            }
+            layer.drawPixel(x, y, out);
+        }
+    }
+}
+
+/* ---- Analysis --------------------------------------------------------------------- */
+
+// computeStats(): the clipped rectangle, pixel by pixel in row order
+inline void computeStats(GFX_Layer &layer, GFX_LayerStats &stats, int16_t x, int16_t y, int16_t w, int16_t h,
+                         uint8_t flags, CRGB background)
+{
+    const int32_t x0 = std::max<int32_t>(x, 0), y0 = std::max<int32_t>(y, 0);
+    const int32_t x1 = std::max<int32_t>(std::min<int32_t>((int32_t)x + w, layer.getWidth()), x0);
+    const int32_t y1 = std::max<int32_t>(std::min<int32_t>((int32_t)y + h, layer.getHeight()), y0);
+
+    std::vector<uint32_t> histogram(3 * 256), buckets(4096);
+    uint64_t sum[3] = {};
+    int32_t  min_x = INT16_MAX, min_y = INT16_MAX, max_x = INT16_MIN, max_y = INT16_MIN;
+    uint32_t foreground = 0;
+    uint8_t  luma_min = 255, luma_max = 0;
+
+    for (int32_t j = y0; j < y1; j++) {
+        for (int32_t i = x0; i < x1; i++) {
+            const CRGB c = layer.getPixel(i, j);
+            for (int ch = 0; ch < 3; ch++) {
+                histogram[ch * 256 + c.raw[ch]]++;
+                sum[ch] += c.raw[ch];
+            }
+            buckets[(c.r >> 4) * 256 + (c.g >> 4) * 16 + (c.b >> 4)]++;
+            if (c != background) {
+                min_x = std::min(min_x, i);
+                max_x = std::max(max_x, i);
+                min_y = std::min(min_y, j);
+                max_y = std::max(max_y, j);
+                foreground++;
+            }
+            luma_min = std::min(luma_min, c.getLuma());
+            luma_max = std::max(luma_max, c.getLuma());
+        }
+    }
+
+    const uint32_t count = (uint32_t)(x1 - x0) * (y1 - y0);
+
+    if (flags & GFX_LayerStats::HISTOGRAM) {
+        for (int ch = 0; ch < 3; ch++) {
+            for (int n = 0; n < 256; n++) stats.histogram[ch][n] = histogram[ch * 256 + n];
+        }
+    }
+    if (flags & GFX_LayerStats::AVERAGE) {
+        stats.average = count ? CRGB(sum[0] / count, sum[1] / count, sum[2] / count) : CRGB(0, 0, 0);
+    }
+    if (flags & GFX_LayerStats::DOMINANT) {
+        const size_t best = std::max_element(buckets.begin(), buckets.end()) - buckets.begin();   // first of equals
+        stats.dominant       = CRGB((best >> 8) * 17, ((best >> 4) & 0x0F) * 17, (best & 0x0F) * 17);
+        stats.dominant_count = buckets[best];
+    }
+    if (flags & GFX_LayerStats::BOUNDS) {
+        stats.min_x      = min_x;
+        stats.min_y      = min_y;
+        stats.max_x      = max_x;
+        stats.max_y      = max_y;
+        stats.foreground = foreground;
+    }
+    if (flags & GFX_LayerStats::LUMA) {
+        stats.luma_min = count ? luma_min : 0;
+        stats.luma_max = luma_max;
+    }
+    stats.flags = flags;
+    stats.count = count;
+}
+
+/* ---- Noise ------------------------------------------------------------------------ */
+
+/*
+ * fillNoise8() / fillNoise16(): the original fill_2dnoise8() / fill_2dnoise16() over
+ * the whole layer-sized matrix, of which only the clipped rectangle x,y,w,h is kept.
+ */
+inline void fillNoise(GFX_Layer &layer, bool wide, int16_t x, int16_t y, int16_t w, int16_t h,
+                      const GFX_NoiseField &v, const GFX_NoiseField &hue, uint16_t hue_shift, bool blend)
+{
+    Image img = snapshot(layer);
+    std::vector<CRGB> full = img.px;
+
+    if (wide) {
+        orig::fill_2dnoise16(full.data(), img.width, img.height, false, v.octaves, v.x, v.xscale, v.y, v.yscale, v.time,
+                             hue.octaves, hue.x, hue.xscale, hue.y, hue.yscale, hue.time, blend, hue_shift);
+    } else {
+        orig::fill_2dnoise8(full.data(), img.width, img.height, false, v.octaves, v.x, v.xscale, v.y, v.yscale, v.time,
+                            hue.octaves, hue.x, hue.xscale, hue.y, hue.yscale, hue.time, blend);
+    }
+
+    for (int32_t j = y; j < (int32_t)y + h; j++) {
+        for (int32_t i = x; i < (int32_t)x + w; i++) {
+            if (i >= 0 && j >= 0 && i < img.width && j < img.height) layer.drawPixel(i, j, full[(size_t)j * img.width + i]);
+        }
+    }
+}
+
+/*
+ * fill_raw_2dnoise16into8_upscaled(): the full fill over a map reaching the node
+ * past the last pixel, then each pixel bilinear between its four nodes.
+ */
+inline std::vector<uint8_t> upscaledNoise16(int width, int height, int step, const GFX_NoiseField &f)
+{
+    const int nw = ((width - 1) / step + 1) * step + 1, nh = ((height - 1) / step + 1) * step + 1;
+    std::vector<uint8_t> full((size_t)nw * nh, 0), out((size_t)width * height);
+    orig::fill_raw_2dnoise16into8(full.data(), nw, nh, f.octaves, f.x, f.xscale, f.y, f.yscale, f.time);
+
+    const auto node = [&](int i, int j) { return (int32_t)full[(size_t)i * step * nw + j * step]; };
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            const int32_t b = i / step, a = j / step, fy = i % step, fx = j % step;
+            const int32_t top = node(b, a) * (step - fx) + node(b, a + 1) * fx;
+            const int32_t bot = node(b + 1, a) * (step - fx) + node(b + 1, a + 1) * fx;
+            out[(size_t)i * width + j] = (top * (step - fy) + bot * fy + step * step / 2) / (step * step);
+        }
+    }
+    return out;
+}
+
+/*
+ * fillSimplex(): one snoise16() call per pixel and octave, at the pixel's own field
+ * coordinates.
+ */
+inline uint8_t simplexSample(const GFX_NoiseField &f, int32_t i, int32_t j)
+{
+    const uint8_t octaves = f.octaves < 1 ? 1 : f.octaves > 8 ? 8 : f.octaves;
+    const uint32_t x = f.x + (uint32_t)i * (uint32_t)f.xscale;
+    const uint32_t y = f.y + (uint32_t)j * (uint32_t)f.yscale;
+
+    int32_t acc = 0, weight = 0;
+    for (uint8_t o = 0; o < octaves; o++) {
+        acc    += ((int32_t)snoise16(x << o, y << o, f.time) - 32768) * (256 >> o);
+        weight += 256 >> o;
+    }
+    const int32_t v = 128 + acc / weight / 256;
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+inline void fillSimplex(GFX_Layer &layer, int16_t x, int16_t y, int16_t w, int16_t h,
+                        const GFX_NoiseField &v, const GFX_NoiseField &hue, uint16_t hue_shift, bool blend)
+{
+    Image img = snapshot(layer);
+
+    for (int32_t j = y; j < (int32_t)y + h; j++) {
+        for (int32_t i = x; i < (int32_t)x + w; i++) {
+            if (i < 0 || j < 0 || i >= img.width || j >= img.height) continue;
+            CRGB led(CHSV((hue_shift >> 8) + simplexSample(hue, i, j), 255, simplexSample(v, i, j)));
+            if (blend) {
+                CRGB px = img.px[(size_t)j * img.width + i];
+                px >>= 1; px += (led >>= 1);
+                led = px;
+            }
+            layer.drawPixel(i, j, led);
+        }
+    }
+}
+
+/*
+ * mapPalette(): map_data_into_colors_through_palette() one pixel at a time, on the
+ * clipped part of the x,y,w,h rectangle; 'indices' is w x h.
+ */
+template <typename PALETTE>
+inline void mapPalette(GFX_Layer &layer, int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *indices,
+                       const PALETTE &pal, uint8_t brightness, TBlendType blend, uint8_t opacity)
+{
+    Image img = snapshot(layer);
+
+    for (int32_t j = y; j < (int32_t)y + h; j++) {
+        for (int32_t i = x; i < (int32_t)x + w; i++) {
+            if (i < 0 || j < 0 || i >= img.width || j >= img.height) continue;
+            uint8_t index = indices[(size_t)(j - y) * w + (i - x)];
+            CRGB px = img.px[(size_t)j * img.width + i];
+            map_data_into_colors_through_palette(&index, 1, &px, pal, brightness, opacity, blend);
+            layer.drawPixel(i, j, px);
+        }
+    }
+}
+
+/* ---- Ticker ----------------------------------------------------------------------- */
+
+/*
+ * A GFX_Ticker's window after it has scrolled 'scroll' pixels: the messages, each
+ * followed by a 'gap' pixel gap, looped and laid out from virtual column 'width'
+ * on, printed into a window-sized layer. Ink where a glyph pixel is, paper elsewhere.
+ * The strip is as tall as the font's tallest glyph extent, with the top of the
+ * highest glyph on row 0.
+ */
+inline Image tickerWindow(const std::vector<std::string> &messages, const GFXfont *gfx_font, uint8_t size,
+                          uint16_t width, uint16_t gap, uint32_t scroll, CRGB ink, CRGB paper)
+{
+    int32_t top = 0, bottom = 8 * size;
+    if (gfx_font) {
+        top = INT32_MAX;
+        bottom = INT32_MIN;
+        for (int c = gfx_font->first; c <= gfx_font->last; c++) {
+            if (c == '\n' || c == '\r') continue;
+            const GFXglyph &glyph = gfx_font->glyph[c - gfx_font->first];
+            top    = std::min<int32_t>(top, glyph.yOffset * size);
+            bottom = std::max<int32_t>(bottom, (glyph.yOffset + glyph.height) * size);
+        }
+    }
+
+    std::string text;
+    for (const std::string &m : messages) {
+        for (char c : m) text += (c == '\n') ? ' ' : c;
+        text += '\n';
+    }
+
+    GFX_Layer layer(width, bottom - top, [](int16_t, int16_t, uint8_t, uint8_t, uint8_t) {});
+    layer.clear();
+
+    // Everything up to a glyph's width past the window; further on can't reach into it
+    int64_t cursor = width;
+    while (!text.empty() && cursor < (int64_t)scroll + width + 64 * size) {
+        const int64_t start = cursor;
+        for (char c : text) {
+            const unsigned char uc = c;
+            if (uc == '\n') { cursor += gap; continue; }
+
+            const char one[2] = { c, 0 };
+            if (cursor + 64 * size > (int64_t)scroll) print(layer, gfx_font, size, size, cursor - scroll, -top, one, 0xFFFF, false);
+            if (!gfx_font) cursor += 6 * size;
+            else if (uc >= gfx_font->first && uc <= gfx_font->last) cursor += gfx_font->glyph[uc - gfx_font->first].xAdvance * size;
+        }
+        if (cursor == start) break;
+    }
+
+    Image img = snapshot(layer);
+    for (CRGB &c : img.px) c = (c == CRGB(0, 0, 0)) ? paper : ink;
+    return img;
+}
+
+} // namespace gfx_ref
+
+#endif
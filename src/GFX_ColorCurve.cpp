@@ -0,0 +1,170 @@
+/**
+ * Per-channel tone curve lookup tables, see GFX_ColorCurve.hpp
+ */
+
+#include "GFX_ColorCurve.hpp"
+#include <math.h>
+#include <string.h>
+
+void GFX_ColorCurve::setIdentity(uint8_t channels)
+{
+    for (uint8_t c = 0; c < 3; c++) {
+        if (channels & (1 << c)) channel[c].kind = IDENTITY;
+    }
+    dirty |= channels & ALL;
+}
+
+void GFX_ColorCurve::setGamma(float gamma, uint8_t channels)
+{
+    for (uint8_t c = 0; c < 3; c++) {
+        if (!(channels & (1 << c))) continue;
+        if (channel[c].kind == GAMMA && channel[c].gamma == gamma) continue;
+        channel[c].kind  = GAMMA;
+        channel[c].gamma = gamma;
+        dirty |= 1 << c;
+    }
+}
+
+void GFX_ColorCurve::setGamma(float gamma_r, float gamma_g, float gamma_b)
+{
+    setGamma(gamma_r, RED);
+    setGamma(gamma_g, GREEN);
+    setGamma(gamma_b, BLUE);
+}
+
+bool GFX_ColorCurve::setControlPoints(const uint8_t points[][2], uint8_t count, uint8_t channels)
+{
+    if (!points || count == 0) return false;
+    if (count > MAX_POINTS) count = MAX_POINTS;
+
+    // Insertion sort by input level; a repeated level keeps the last point given
+    Channel ch;
+    ch.kind  = POINTS;
+    ch.count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t j = 0;
+        while (j < ch.count && ch.points[j][0] < points[i][0]) j++;
+        if (j < ch.count && ch.points[j][0] == points[i][0]) {
+            ch.points[j][1] = points[i][1];
+            continue;
+        }
+        for (uint8_t k = ch.count; k > j; k--) {
+            ch.points[k][0] = ch.points[k - 1][0];
+            ch.points[k][1] = ch.points[k - 1][1];
+        }
+        ch.points[j][0] = points[i][0];
+        ch.points[j][1] = points[i][1];
+        ch.count++;
+    }
+
+    for (uint8_t c = 0; c < 3; c++) {
+        if (!(channels & (1 << c))) continue;
+        channel[c] = ch;
+        dirty |= 1 << c;
+    }
+    return true;
+}
+
+void GFX_ColorCurve::setFunction(uint8_t (*fn)(uint8_t), uint8_t channels)
+{
+    for (uint8_t c = 0; c < 3; c++) {
+        if (!(channels & (1 << c))) continue;
+        channel[c].kind = fn ? FUNCTION : IDENTITY;
+        channel[c].fn   = fn;
+        dirty |= 1 << c;
+    }
+}
+
+// Fritsch-Carlson monotone cubic through the control points: smooth, and never
+// overshoots, so a rising set of points gives a rising curve.
+void GFX_ColorCurve::buildPoints(const Channel &ch, uint8_t *out) const
+{
+    const uint8_t n = ch.count;
+
+    if (n == 1) {
+        memset(out, ch.points[0][1], 256);
+        return;
+    }
+
+    float slope[MAX_POINTS] = {};       // of each segment
+    float tangent[MAX_POINTS];          // at each point
+
+    for (uint8_t k = 0; k + 1 < n; k++) {
+        slope[k] = (float)(ch.points[k + 1][1] - ch.points[k][1]) / (ch.points[k + 1][0] - ch.points[k][0]);
+    }
+    tangent[0]     = slope[0];
+    tangent[n - 1] = slope[n - 2];
+    for (uint8_t k = 1; k + 1 < n; k++) {
+        tangent[k] = (slope[k - 1] * slope[k] <= 0) ? 0 : (slope[k - 1] + slope[k]) / 2;
+    }
+    for (uint8_t k = 0; k + 1 < n; k++) {
+        if (slope[k] == 0) {
+            tangent[k] = tangent[k + 1] = 0;
+            continue;
+        }
+        float a = tangent[k] / slope[k], b = tangent[k + 1] / slope[k];
+        float s = a * a + b * b;
+        if (s > 9) {
+            float t = 3 / sqrtf(s);
+            tangent[k]     = t * a * slope[k];
+            tangent[k + 1] = t * b * slope[k];
+        }
+    }
+
+    uint8_t k = 0;
+    for (int v = 0; v < 256; v++) {
+        if (v <= ch.points[0][0])     { out[v] = ch.points[0][1];     continue; }
+        if (v >= ch.points[n - 1][0]) { out[v] = ch.points[n - 1][1]; continue; }
+        while (v > ch.points[k + 1][0]) k++;
+
+        const float h  = ch.points[k + 1][0] - ch.points[k][0];
+        const float t  = (v - ch.points[k][0]) / h;
+        const float t2 = t * t, t3 = t2 * t;
+        const float y  = (2 * t3 - 3 * t2 + 1) * ch.points[k][1]
+                       + (t3 - 2 * t2 + t) * h * tangent[k]
+                       + (-2 * t3 + 3 * t2) * ch.points[k + 1][1]
+                       + (t3 - t2) * h * tangent[k + 1];
+        out[v] = (y <= 0) ? 0 : (y >= 255) ? 255 : (uint8_t)(y + 0.5f);
+    }
+}
+
+void GFX_ColorCurve::update()
+{
+    if (!dirty) return;
+
+    for (uint8_t c = 0; c < 3; c++) {
+        if (!(dirty & (1 << c))) continue;
+
+        const Channel &ch = channel[c];
+        uint8_t *out = lut[c];
+
+        switch (ch.kind) {
+            case GAMMA:
+                for (int v = 0; v < 256; v++) out[v] = applyGamma_video((uint8_t)v, ch.gamma);
+                break;
+            case POINTS:
+                buildPoints(ch, out);
+                break;
+            case FUNCTION:
+                for (int v = 0; v < 256; v++) out[v] = ch.fn((uint8_t)v);
+                break;
+            default:
+                for (int v = 0; v < 256; v++) out[v] = v;
+                break;
+        }
+    }
+
+    dirty = 0;
+}
+
+void GFX_ColorCurve::map(CRGB *leds, size_t count) const
+{
+    const uint8_t *r = lut[0], *g = lut[1], *b = lut[2];
+
+    for (size_t i = 0; i < count; i++) {
+        CRGB &p = leds[i];
+        p.r = r[p.r];
+        p.g = g[p.g];
+        p.b = b[p.b];
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * Per-channel 256 entry tone curve: gamma, a smooth curve through a few control
+ * points, or any function, turned into lookup tables so applying it costs three
+ * table reads per pixel.
+ *
+ * The tables are rebuilt lazily, on the first apply() after a setter changed
+ * something, so one curve can be kept around and shared by any number of layers.
+ *
+ * Requires GFX_Lite
+ */
+
+#ifndef GFX_COLOR_CURVE_HPP
+#define GFX_COLOR_CURVE_HPP
+
+#include "GFX_Lite.h"
+
+class GFX_ColorCurve
+{
+    public:
+        // Channel masks for the setters
+        enum {
+            RED   = 0x01,
+            GREEN = 0x02,
+            BLUE  = 0x04,
+            ALL   = 0x07
+        };
+
+        static const uint8_t MAX_POINTS = 16;
+
+        GFX_ColorCurve() { setIdentity(); }
+
+        void setIdentity(uint8_t channels = ALL);
+
+        // Same result as applyGamma_video(): never takes a non-zero level down to zero
+        void setGamma(float gamma, uint8_t channels = ALL);
+        void setGamma(float gamma_r, float gamma_g, float gamma_b);
+
+        /*
+         * Smooth monotone curve through (in, out) control points, e.g. {{0,0},{64,40},{255,255}}.
+         * Points are sorted by 'in'; levels outside the first/last point are held flat.
+         * At most MAX_POINTS are used. Returns false if there are none.
+         */
+        bool setControlPoints(const uint8_t points[][2], uint8_t count, uint8_t channels = ALL);
+
+        // Any mapping, evaluated 256 times when the tables are rebuilt
+        void setFunction(uint8_t (*fn)(uint8_t), uint8_t channels = ALL);
+
+        // Rebuild any tables whose parameters changed. apply() does this itself.
+        void update();
+
+        // Map 'count' pixels in place
+        void apply(CRGB *leds, size_t count) { update(); map(leds, count); }
+        CRGB apply(const CRGB &c) { update(); return CRGB(lut[0][c.r], lut[1][c.g], lut[2][c.b]); }
+
+        // Map with the tables as they are, without checking for changes. Safe to call
+        // from several threads at once after update().
+        void map(CRGB *leds, size_t count) const;
+
+        // 256 entries for channel 0 (red), 1 (green) or 2 (blue), current after update()
+        const uint8_t *table(uint8_t channel) const { return lut[channel]; }
+
+    private:
+        enum Kind { IDENTITY, GAMMA, POINTS, FUNCTION };
+
+        struct Channel {
+            Kind     kind;
+            float    gamma;
+            uint8_t  points[MAX_POINTS][2];
+            uint8_t  count;
+            uint8_t (*fn)(uint8_t);
+        };
+
+        Channel channel[3];
+        uint8_t lut[3][256];
+        uint8_t dirty = 0;              // channel mask of tables to rebuild
+
+        void buildPoints(const Channel &ch, uint8_t *out) const;
+};
+
+#endif
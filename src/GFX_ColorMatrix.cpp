@@ -0,0 +1,220 @@
+/**
+ * Fixed point colour matrix, see GFX_ColorMatrix.hpp
+ */
+
+#include "GFX_ColorMatrix.hpp"
+#include <math.h>
+
+#if GFX_SIMD_SSE2
+  #include <emmintrin.h>
+#elif GFX_SIMD_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace {
+
+inline int16_t toFixed(float v, float scale)
+{
+    float f = v * scale;
+    f += (f < 0) ? -0.5f : 0.5f;
+    if (f >  32767.0f) return  32767;
+    if (f < -32768.0f) return -32768;
+    return (int16_t)f;
+}
+
+inline uint8_t clamp8(int32_t v)
+{
+    return (v < 0) ? 0 : (v > 255) ? 255 : (uint8_t)v;
+}
+
+} // namespace
+
+void GFX_ColorMatrix::setIdentity()
+{
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) m[r][c] = (r == c) ? 1.0f : 0.0f;
+        off[r] = 0;
+    }
+    quantize();
+}
+
+void GFX_ColorMatrix::set(const float matrix[3][3], const float offset[3])
+{
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) m[r][c] = matrix[r][c];
+        off[r] = offset ? offset[r] : 0;
+    }
+    quantize();
+}
+
+void GFX_ColorMatrix::quantize()
+{
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) q[r][c] = toFixed(m[r][c], 256.0f);
+        q_offset[r] = toFixed(off[r], 1.0f);
+    }
+}
+
+GFX_ColorMatrix &GFX_ColorMatrix::then(const GFX_ColorMatrix &next)
+{
+    float nm[3][3], noff[3];
+
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            nm[r][c] = next.m[r][0] * m[0][c] + next.m[r][1] * m[1][c] + next.m[r][2] * m[2][c];
+        }
+        noff[r] = next.m[r][0] * off[0] + next.m[r][1] * off[1] + next.m[r][2] * off[2] + next.off[r];
+    }
+
+    set(nm, noff);
+    return *this;
+}
+
+/* Presets */
+
+// Rec. 709 luma weights, as used by CRGB::getLuma()
+static const float LUMA_R = 0.2126f, LUMA_G = 0.7152f, LUMA_B = 0.0722f;
+
+GFX_ColorMatrix GFX_ColorMatrix::saturation(float amount)
+{
+    const float s = amount, i = 1.0f - amount;
+    const float mat[3][3] = {
+        { i * LUMA_R + s, i * LUMA_G,     i * LUMA_B     },
+        { i * LUMA_R,     i * LUMA_G + s, i * LUMA_B     },
+        { i * LUMA_R,     i * LUMA_G,     i * LUMA_B + s },
+    };
+    return GFX_ColorMatrix(mat);
+}
+
+GFX_ColorMatrix GFX_ColorMatrix::contrast(float amount, uint8_t pivot)
+{
+    const float mat[3][3] = { { amount, 0, 0 }, { 0, amount, 0 }, { 0, 0, amount } };
+    const float o = pivot * (1.0f - amount);
+    const float offset[3] = { o, o, o };
+    return GFX_ColorMatrix(mat, offset);
+}
+
+GFX_ColorMatrix GFX_ColorMatrix::brightness(float scale)
+{
+    const float mat[3][3] = { { scale, 0, 0 }, { 0, scale, 0 }, { 0, 0, scale } };
+    return GFX_ColorMatrix(mat);
+}
+
+// Rotation about the grey axis, keeping luma (same as SVG's feColorMatrix hueRotate)
+GFX_ColorMatrix GFX_ColorMatrix::hueRotation(float degrees)
+{
+    const float a = degrees * (float)M_PI / 180.0f;
+    const float c = cosf(a), s = sinf(a);
+    const float mat[3][3] = {
+        { 0.213f + c * 0.787f - s * 0.213f, 0.715f - c * 0.715f - s * 0.715f, 0.072f - c * 0.072f + s * 0.928f },
+        { 0.213f - c * 0.213f + s * 0.143f, 0.715f + c * 0.285f + s * 0.140f, 0.072f - c * 0.072f - s * 0.283f },
+        { 0.213f - c * 0.213f - s * 0.787f, 0.715f - c * 0.715f + s * 0.715f, 0.072f + c * 0.928f + s * 0.072f },
+    };
+    return GFX_ColorMatrix(mat);
+}
+
+GFX_ColorMatrix GFX_ColorMatrix::sepia(float amount)
+{
+    static const float tone[3][3] = {
+        { 0.393f, 0.769f, 0.189f },
+        { 0.349f, 0.686f, 0.168f },
+        { 0.272f, 0.534f, 0.131f },
+    };
+    float mat[3][3];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) mat[r][c] = amount * tone[r][c] + ((r == c) ? 1.0f - amount : 0.0f);
+    }
+    return GFX_ColorMatrix(mat);
+}
+
+GFX_ColorMatrix GFX_ColorMatrix::whiteBalance(float gain_r, float gain_g, float gain_b)
+{
+    const float mat[3][3] = { { gain_r, 0, 0 }, { 0, gain_g, 0 }, { 0, 0, gain_b } };
+    return GFX_ColorMatrix(mat);
+}
+
+/* Applying */
+
+CRGB GFX_ColorMatrix::apply(const CRGB &c) const
+{
+    CRGB out;
+    for (int r = 0; r < 3; r++) {
+        int32_t acc = q[r][0] * c.r + q[r][1] * c.g + q[r][2] * c.b + (int32_t)q_offset[r] * 256 + 128;
+        out.raw[r] = clamp8(acc >> 8);
+    }
+    return out;
+}
+
+void GFX_ColorMatrix::apply(CRGB *leds, size_t count) const
+{
+    size_t i = 0;
+
+#if GFX_SIMD_SSE2
+    // Each output channel is two pmaddwd's over (r,g) and (b,256) pairs: 4 pixels per
+    // instruction, the offset riding along as a coefficient on the constant 256.
+    __m128i coef_rg[3], coef_b1[3];
+    for (int r = 0; r < 3; r++) {
+        coef_rg[r] = _mm_set1_epi32((uint16_t)q[r][0] | ((uint32_t)(uint16_t)q[r][1] << 16));
+        coef_b1[r] = _mm_set1_epi32((uint16_t)q[r][2] | ((uint32_t)(uint16_t)q_offset[r] << 16));
+    }
+    const __m128i k256  = _mm_set1_epi16(256);
+    const __m128i round = _mm_set1_epi32(128);
+
+    for (; i + 8 <= count; i += 8) {
+        CRGB *p = leds + i;
+
+        const __m128i r = _mm_setr_epi16(p[0].r, p[1].r, p[2].r, p[3].r, p[4].r, p[5].r, p[6].r, p[7].r);
+        const __m128i g = _mm_setr_epi16(p[0].g, p[1].g, p[2].g, p[3].g, p[4].g, p[5].g, p[6].g, p[7].g);
+        const __m128i b = _mm_setr_epi16(p[0].b, p[1].b, p[2].b, p[3].b, p[4].b, p[5].b, p[6].b, p[7].b);
+
+        const __m128i rg_lo = _mm_unpacklo_epi16(r, g), rg_hi = _mm_unpackhi_epi16(r, g);
+        const __m128i b1_lo = _mm_unpacklo_epi16(b, k256), b1_hi = _mm_unpackhi_epi16(b, k256);
+
+        alignas(16) uint8_t out[3][16];
+        for (int c = 0; c < 3; c++) {
+            __m128i lo = _mm_add_epi32(_mm_madd_epi16(rg_lo, coef_rg[c]), _mm_madd_epi16(b1_lo, coef_b1[c]));
+            __m128i hi = _mm_add_epi32(_mm_madd_epi16(rg_hi, coef_rg[c]), _mm_madd_epi16(b1_hi, coef_b1[c]));
+            lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 8);
+            hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 8);
+            const __m128i v = _mm_packs_epi32(lo, hi);
+            _mm_store_si128((__m128i *)out[c], _mm_packus_epi16(v, v));
+        }
+
+        for (int k = 0; k < 8; k++) {
+            p[k].r = out[0][k];
+            p[k].g = out[1][k];
+            p[k].b = out[2][k];
+        }
+    }
+#elif GFX_SIMD_NEON
+    // vld3 splits 8 pixels into channel vectors; widening multiply-accumulate into
+    // 32 bits, then a rounding, saturating narrow back down to bytes.
+    for (; i + 8 <= count; i += 8) {
+        uint8_t *p = (uint8_t *)(leds + i);
+        const uint8x8x3_t in = vld3_u8(p);
+
+        const int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(in.val[0]));
+        const int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(in.val[1]));
+        const int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(in.val[2]));
+
+        uint8x8x3_t out;
+        for (int c = 0; c < 3; c++) {
+            const int32x4_t base = vdupq_n_s32((int32_t)q_offset[c] * 256);
+
+            int32x4_t lo = vmlal_n_s16(base, vget_low_s16(r), q[c][0]);
+            lo = vmlal_n_s16(lo, vget_low_s16(g), q[c][1]);
+            lo = vmlal_n_s16(lo, vget_low_s16(b), q[c][2]);
+
+            int32x4_t hi = vmlal_n_s16(base, vget_high_s16(r), q[c][0]);
+            hi = vmlal_n_s16(hi, vget_high_s16(g), q[c][1]);
+            hi = vmlal_n_s16(hi, vget_high_s16(b), q[c][2]);
+
+            out.val[c] = vqmovun_s16(vcombine_s16(vqrshrn_n_s32(lo, 8), vqrshrn_n_s32(hi, 8)));
+        }
+
+        vst3_u8(p, out);
+    }
+#endif
+
+    for (; i < count; i++) leds[i] = apply(leds[i]);
+}
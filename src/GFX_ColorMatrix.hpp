@@ -0,0 +1,62 @@
+/**
+ * 3x3 colour matrix plus offset, applied in fixed point.
+ *
+ *   out.r = m[0][0]*r + m[0][1]*g + m[0][2]*b + offset[0]   (same for g and b)
+ *
+ * The matrix is kept in float for building and combining, and converted to Q8.8
+ * (coefficients -128..+128, offsets in whole levels) whenever it changes, so
+ * applying it is integer only, with the result clamped to 0..255. Rows are done
+ * 8 pixels at a time with SSE2 on x86 and NEON on ARM.
+ *
+ * Presets can be chained with then(), so brightness, saturation and tint
+ * adjustments become a single pass over the pixels.
+ *
+ * Requires GFX_Lite
+ */
+
+#ifndef GFX_COLOR_MATRIX_HPP
+#define GFX_COLOR_MATRIX_HPP
+
+#include "GFX_Lite.h"
+
+class GFX_ColorMatrix
+{
+    public:
+        GFX_ColorMatrix() { setIdentity(); }
+        GFX_ColorMatrix(const float matrix[3][3], const float offset[3] = NULL) { set(matrix, offset); }
+
+        void setIdentity();
+
+        // offset (levels added after the multiply) is optional
+        void set(const float matrix[3][3], const float offset[3] = NULL);
+
+        // Apply 'next' after this one: this = next * this
+        GFX_ColorMatrix &then(const GFX_ColorMatrix &next);
+
+        // Presets
+        static GFX_ColorMatrix saturation(float amount);                  // 0 = grey, 1 = unchanged, 2 = vivid
+        static GFX_ColorMatrix contrast(float amount, uint8_t pivot = 128); // 1 = unchanged, around 'pivot'
+        static GFX_ColorMatrix brightness(float scale);                   // 1 = unchanged
+        static GFX_ColorMatrix hueRotation(float degrees);
+        static GFX_ColorMatrix sepia(float amount = 1.0f);                // 0 = unchanged, 1 = full sepia
+        static GFX_ColorMatrix whiteBalance(float gain_r, float gain_g, float gain_b);
+
+        // Transform 'count' pixels in place
+        void apply(CRGB *leds, size_t count) const;
+        CRGB apply(const CRGB &c) const;
+
+        // The fixed point form actually applied
+        int16_t coefficient(uint8_t row, uint8_t col) const { return q[row][col]; }
+        int16_t offset(uint8_t row) const { return q_offset[row]; }
+
+    private:
+        float   m[3][3];
+        float   off[3];
+
+        int16_t q[3][3];                // Q8.8
+        int16_t q_offset[3];            // whole levels
+
+        void quantize();
+};
+
+#endif
@@ -7,21 +7,53 @@
  **/
 
 #include "GFX_Layer.hpp"
+#include "GFX_ColorCurve.hpp"
+#include "GFX_PaletteCache.hpp"
+#include "GFX_ColorMatrix.hpp"
+#include <algorithm>
+
+namespace {
+
+// Runs fn over row bands of [0, rows): on the pool if there is one, else inline as one band
+inline void forEachBand(GFX_WorkerPool *pool, uint16_t rows, const GFX_WorkerPool::BandFn &fn)
+{
+    if (pool) pool->parallelFor(rows, fn);
+    else      fn(0, rows, 0);
+}
+
+inline uint8_t bandCount(GFX_WorkerPool *pool, uint16_t rows)
+{
+    return pool ? pool->bands(rows) : 1;
+}
+
+// a moved towards b by f/256, per channel. lerp8by8 rather than blend8, so f = 0
+// gives a exactly and whole-pixel moves are plain shifts.
+inline CRGB lerpPixel(const CRGB &a, const CRGB &b, uint8_t f)
+{
+    return CRGB(lerp8by8(a.r, b.r, f), lerp8by8(a.g, b.g, f), lerp8by8(a.b, b.b, f));
+}
+
+} // namespace
 
 /**
  * Dim all the pixels in the display.
  */
-void GFX_Layer::dim(byte value)  {   
+void GFX_Layer::dim(byte value)  {
+    GFX_PROFILE_CALL("GFX_Layer::dim");
 
 		// nscale8 max value is 255, or it'll flip back to 0 
 		// (documentation is wrong when it says x/256), it's actually x/255
-		for (int y = 0; y < _height; y++) {
-			for (int x = 0; x < _width; x++) {
-				pixels->data[y][x].nscale8(value);
-		}}
+		forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+			for (int y = begin; y < end; y++) {
+				for (int x = 0; x < _width; x++) {
+					pixels->data[y][x].nscale8(value);
+			}}
+		});
 }
 
-void GFX_Layer::clear() { 
+void GFX_Layer::clear() {
+    GFX_PROFILE_PRIMITIVE("GFX_Layer::clear");
+		GFX_STATS(countFill(0, 0, _width, _height));
 		for (int y = 0; y < _height; y++) {
 			for (int x = 0; x < _width; x++) {
 				pixels->data[y][x] = CRGB(0, 0, 0);
@@ -51,6 +83,7 @@ void GFX_Layer::fillTransparent(int r, int g, int b) {
 // default value is in definition
 void GFX_Layer::drawCentreText(const char *buf, textPosition textPos, const GFXfont *f, CRGB color, int yadjust) 
 {
+    GFX_PROFILE_CALL("GFX_Layer::drawCentreText");
 			int16_t x1, y1;
 			uint16_t w, h;
 
@@ -119,39 +152,7 @@ void GFX_Layer::drawCentreText(const char *buf, textPosition textPos, const GFXf
   // Move the contents of the screen left (-ve) or right (+ve)
   void GFX_Layer::moveX(int offset) 
   {
-		if(offset > 0) { // move right
-		//	Sprintln("Moving right");
-
-			for(int x = _width - 1; x >= 0; x--){ // 63 to 0
-				for(int y = 0; y < _height; y++){ // 0 to 31
-					if (x - offset >= 0) 
-					{
-						//  Serial.printf("setting y %d x %d to y %d x %d\n", y, x, y, x-offset);
-						pixels->data[y][x] = pixels->data[y][x-offset];
-					}
-					else {
-						pixels->data[y][x] = BLACK_BACKGROUND_PIXEL_COLOUR;            
-					}
-				}    
-			}
-		} else { // move left
-
-		//	Sprintln("Moving Left");
-			for(int x = 0; x <=_width - 1; x++){
-				for(int y = 0; y < _height; y++){
-					if ( x > (_width-1)+offset )
-					{
-						pixels->data[y][x] = BLACK_BACKGROUND_PIXEL_COLOUR;                    
-						//Serial.println("eh?");
-					}
-					else
-					{
-						pixels->data[y][x] = pixels->data[y][x-offset]; 
-						//	Serial.println("eh?");
-					}
-				}    
-			}         
-		} 
+		scrollX(offset, BLACK_BACKGROUND_PIXEL_COLOUR);
   } 
   
 /**
@@ -160,45 +161,169 @@ void GFX_Layer::drawCentreText(const char *buf, textPosition textPos, const GFXf
  */
   void GFX_Layer::autoCenterX()
   {
-	  	int leftmost_x = 0, rightmost_x = 0, adjusted_leftmost_x = 0;
-
-		// Find leftmost
-		for(int x = 0; x < _width; x++) { 
-			for(int y = 0; y < _height; y++) {
-				if (pixels->data[y][x] != BLACK_BACKGROUND_PIXEL_COLOUR)
-				{
-					leftmost_x = x;
-					//Serial.printf("Left most x pixel is %d\n", leftmost_x);
-					goto rightmost;
-				}
-			}
-		}
-
-		rightmost:
-		for(int x = _width-1; x >= 0; x--) { 
-			for(int y = 0; y < _height; y++) {
-				if (pixels->data[y][x] != BLACK_BACKGROUND_PIXEL_COLOUR)
-				{
-					rightmost_x = x+1;
-					//Serial.printf("Right most x pixel is %d\n", rightmost_x);					
-					goto centreit;
-				}
-			}
-		}
+		GFX_LayerStats stats;
+		if (!computeStats(stats, GFX_LayerStats::BOUNDS, BLACK_BACKGROUND_PIXEL_COLOUR) || stats.empty()) return;
 
-		centreit:
-			adjusted_leftmost_x = ( _width - (rightmost_x - leftmost_x))/2;
-			//Serial.printf("Adjusted: %d, Moving x coords by %d pixels.\n", adjusted_leftmost_x, adjusted_leftmost_x-leftmost_x);
-			moveX(adjusted_leftmost_x-leftmost_x);
+		int leftmost_x = stats.min_x, rightmost_x = stats.max_x + 1;
+		int adjusted_leftmost_x = ( _width - (rightmost_x - leftmost_x))/2;
+		//Serial.printf("Adjusted: %d, Moving x coords by %d pixels.\n", adjusted_leftmost_x, adjusted_leftmost_x-leftmost_x);
+		moveX(adjusted_leftmost_x-leftmost_x);
   } // end autoCentreX
   
+  // Move the contents of the screen up (-ve) or down (+ve)
   void GFX_Layer::moveY(int delta)
   {
-	// Not implemented
+		scrollY(delta, BLACK_BACKGROUND_PIXEL_COLOUR);
   }
 
+/*
+ * Sub-pixel moves. Moving by d = i + f/256 makes out(x) = in(x - i) lerped towards
+ * in(x - i - 1) by f. Both taps are on the same side of x, so walking x away from
+ * them lets each pass work in place. Rows then columns.
+ */
+void GFX_Layer::moveSubpixel(int32_t dx_q8, int32_t dy_q8, CRGB fill)
+{
+    GFX_PROFILE_CALL("GFX_Layer::moveSubpixel");
+    if (!isInitialized() || (dx_q8 == 0 && dy_q8 == 0)) return;
+    linearize();
+
+    const int32_t ix = dx_q8 >> 8, iy = dy_q8 >> 8;
+    const uint8_t fx = dx_q8 & 0xFF, fy = dy_q8 & 0xFF;
+
+    if (dx_q8) {
+        forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+            for (uint16_t y = begin; y < end; y++) {
+                CRGB *row = pixels->data[y];
+                auto tap = [&](int32_t sx) -> CRGB { return (sx >= 0 && sx < _width) ? row[sx] : fill; };
+
+                if (dx_q8 > 0) {
+                    for (int32_t x = _width - 1; x >= 0; x--) row[x] = lerpPixel(tap(x - ix), tap(x - ix - 1), fx);
+                } else {
+                    for (int32_t x = 0; x < _width; x++)      row[x] = lerpPixel(tap(x - ix), tap(x - ix - 1), fx);
+                }
+            }
+        });
+    }
+
+    if (dy_q8) {
+        // Columns are independent, so the bands split the width
+        forEachBand(worker_pool, _width, [&](uint16_t begin, uint16_t end, uint8_t band) {
+            auto pass = [&](int32_t y) {
+                const int32_t sa = y - iy, sb = y - iy - 1;
+                const CRGB *ra = (sa >= 0 && sa < _height) ? pixels->data[sa] : nullptr;
+                const CRGB *rb = (sb >= 0 && sb < _height) ? pixels->data[sb] : nullptr;
+                CRGB *out = pixels->data[y];
+                for (uint16_t x = begin; x < end; x++) {
+                    out[x] = lerpPixel(ra ? ra[x] : fill, rb ? rb[x] : fill, fy);
+                }
+            };
+
+            if (dy_q8 > 0) for (int32_t y = _height - 1; y >= 0; y--) pass(y);
+            else           for (int32_t y = 0; y < _height; y++)      pass(y);
+        });
+    }
+}
+
+void GFX_Layer::moveSubpixel(const GFX_Surface &dst, int32_t dx_q8, int32_t dy_q8, CRGB fill) const
+{
+    GFX_PROFILE_CALL("GFX_Layer::moveSubpixel");
+    if (!isInitialized() || !dst.data || dst.width == 0) return;
+    if (dst.data == pixels->contiguous_memory) return;      // in place is the other overload
+
+    const int32_t ix = dx_q8 >> 8, iy = dy_q8 >> 8;
+    const uint8_t fx = dx_q8 & 0xFF, fy = dy_q8 & 0xFF;
+
+    // Two horizontally resampled source rows per band; going down a row, the upper one
+    // is the lower one of the row before
+    const uint8_t bands = bandCount(worker_pool, dst.height);
+    CRGB *scratch = new(std::nothrow) CRGB[(size_t)bands * 2 * dst.width];
+    if (!scratch) return;
+
+    auto resampleRow = [&](int32_t sy, CRGB *out) {
+        if (sy < 0 || sy >= _height) {
+            for (uint16_t x = 0; x < dst.width; x++) out[x] = fill;
+            return;
+        }
+        const CRGB *row = pixels->data[sy];
+        auto tap = [&](int32_t sx) -> CRGB { return (sx >= 0 && sx < _width) ? row[column(sx)] : fill; };
+        for (int32_t x = 0; x < dst.width; x++) out[x] = lerpPixel(tap(x - ix), tap(x - ix - 1), fx);
+    };
+
+    forEachBand(worker_pool, dst.height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        CRGB *upper = scratch + (size_t)band * 2 * dst.width;
+        CRGB *lower = upper + dst.width;
+
+        resampleRow(begin - iy - 1, upper);
+        for (uint16_t y = begin; y < end; y++) {
+            resampleRow(y - iy, lower);
+            CRGB *out = dst.row(y);
+            for (uint16_t x = 0; x < dst.width; x++) out[x] = lerpPixel(lower[x], upper[x], fy);
+            std::swap(upper, lower);
+        }
+    });
+
+    delete[] scratch;
+}
+
+const CRGB *GFX_Layer::sampleRow(uint16_t y, uint16_t x, uint16_t count, CRGB *scratch) const
+{
+    if (!sub_x && !sub_y) return readRow(y, x, count, scratch);
+    return sampleRow(y, x, count, scratch, y < _height ? pixels->data[y] : nullptr,
+                     (y > 0 && y <= _height) ? pixels->data[y - 1] : nullptr);
+}
+
+const CRGB *GFX_Layer::sampleRow(uint16_t y, uint16_t x, uint16_t count, CRGB *scratch,
+                                 const CRGB *row, const CRGB *above) const
+{
+    // Same taps as moveSubpixel(sub_x, sub_y) with the transparency colour moving in
+    const CRGB edge = transparency_colour;
+    auto tap = [&](const CRGB *r, int32_t sx) -> CRGB {
+        return (r && sx >= 0 && sx < _width) ? r[column(sx)] : edge;
+    };
+
+    for (uint16_t i = 0; i < count; i++) {
+        const int32_t sx = x + i;
+        const CRGB lower = lerpPixel(tap(row, sx),   tap(row, sx - 1),   sub_x);
+        const CRGB upper = lerpPixel(tap(above, sx), tap(above, sx - 1), sub_x);
+        scratch[i] = lerpPixel(lower, upper, sub_y);
+    }
+    return scratch;
+}
+
+void GFX_Layer::setRingScroll(bool enable)
+{
+    if (!enable) linearize();
+    ring_scroll = enable;
+}
+
+void GFX_Layer::linearize()
+{
+    GFX_PROFILE_PRIMITIVE("GFX_Layer::linearize");
+    if (!pixels || isLinear()) return;
+
+    CRGB *base = pixels->contiguous_memory;
+
+    // Rows: the pointer table was rotated, so rotate the memory to match
+    const size_t first_row = (pixels->data[0] - base) / _width;
+    if (first_row) {
+        std::rotate(base, base + first_row * _width, base + (size_t)_width * _height);
+        for (int i = 0; i < _height; i++) {
+            pixels->data[i] = &base[i * _width];
+        }
+    }
+
+    // Columns
+    if (scroll_x) {
+        for (int y = 0; y < _height; y++) {
+            std::rotate(pixels->data[y], pixels->data[y] + scroll_x, pixels->data[y] + _width);
+        }
+        scroll_x = 0;
+    }
+}
+
 // Advanced layer operations implementations
 void GFX_Layer::fastFillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB color) {
+    GFX_PROFILE_PRIMITIVE("GFX_Layer::fastFillRect");
     // Bounds checking and clipping
     if (x >= _width || y >= _height) return;
     if (x + w < 0 || y + h < 0) return;
@@ -210,16 +335,27 @@ void GFX_Layer::fastFillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB co
     if (y + h > _height) { h = _height - y; }
     
     if (w <= 0 || h <= 0) return;
+    GFX_STATS(countFill(x, y, w, h));
     
-    // Use memset for single-row fills when possible
+    // A ring-scrolled layer may have the span split across the seam
+    const uint16_t px    = column(x);
+    const uint16_t first = min((int)w, _width - px);
+
     for (int16_t j = y; j < y + h; j++) {
-        for (int16_t i = x; i < x + w; i++) {
-            pixels->data[j][i] = color;
+        CRGB *row = pixels->data[j];
+        for (int16_t i = 0; i < first; i++) {
+            row[px + i] = color;
+        }
+        for (int16_t i = 0; i < w - first; i++) {
+            row[i] = color;
         }
     }
 }
 
 void GFX_Layer::fastFillScreen(CRGB color) {
+    GFX_PROFILE_PRIMITIVE("GFX_Layer::fastFillScreen");
+    GFX_STATS(countFill(0, 0, _width, _height));
+
     // Use the contiguous memory for faster fills
     if (pixels->contiguous_memory) {
         for (int i = 0; i < _width * _height; i++) {
@@ -236,7 +372,28 @@ void GFX_Layer::fastFillScreen(CRGB color) {
 }
 
 void GFX_Layer::scrollX(int16_t pixels_to_scroll, CRGB fill_color) {
+    GFX_PROFILE_CALL("GFX_Layer::scrollX");
     if (pixels_to_scroll == 0) return;
+
+    // Everything scrolls out
+    if (abs(pixels_to_scroll) >= _width) {
+        fastFillScreen(fill_color);
+        return;
+    }
+
+    if (ring_scroll) {
+        // Move the origin, then clear the strip that scrolled in: O(height * |pixels|)
+        if (pixels_to_scroll > 0) {
+            scroll_x = (scroll_x + _width - pixels_to_scroll) % _width;
+            fastFillRect(0, 0, pixels_to_scroll, _height, fill_color);
+        } else {
+            scroll_x = (scroll_x - pixels_to_scroll) % _width;
+            fastFillRect(_width + pixels_to_scroll, 0, -pixels_to_scroll, _height, fill_color);
+        }
+        return;
+    }
+
+    linearize();
     
     if (pixels_to_scroll > 0) {
         // Scroll right
@@ -267,7 +424,28 @@ void GFX_Layer::scrollX(int16_t pixels_to_scroll, CRGB fill_color) {
 }
 
 void GFX_Layer::scrollY(int16_t pixels_to_scroll, CRGB fill_color) {
+    GFX_PROFILE_CALL("GFX_Layer::scrollY");
     if (pixels_to_scroll == 0) return;
+
+    // Everything scrolls out
+    if (abs(pixels_to_scroll) >= _height) {
+        fastFillScreen(fill_color);
+        return;
+    }
+
+    if (ring_scroll) {
+        // Rotate the row pointers, then clear the rows that scrolled in: O(height + width * |pixels|)
+        if (pixels_to_scroll > 0) {
+            std::rotate(pixels->data, pixels->data + _height - pixels_to_scroll, pixels->data + _height);
+            fastFillRect(0, 0, _width, pixels_to_scroll, fill_color);
+        } else {
+            std::rotate(pixels->data, pixels->data - pixels_to_scroll, pixels->data + _height);
+            fastFillRect(0, _height + pixels_to_scroll, _width, -pixels_to_scroll, fill_color);
+        }
+        return;
+    }
+
+    linearize();
     
     if (pixels_to_scroll > 0) {
         // Scroll down
@@ -300,270 +478,1484 @@ void GFX_Layer::scrollY(int16_t pixels_to_scroll, CRGB fill_color) {
 }
 
 void GFX_Layer::adjustBrightness(uint8_t scale) {
-    if (pixels->contiguous_memory) {
-        for (int i = 0; i < _width * _height; i++) {
-            pixels->contiguous_memory[i].nscale8(scale);
-        }
-    } else {
-        for (int y = 0; y < _height; y++) {
+    GFX_PROFILE_CALL("GFX_Layer::adjustBrightness");
+    forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (int y = begin; y < end; y++) {
+            CRGB *row = pixels->data[y];
             for (int x = 0; x < _width; x++) {
-                pixels->data[y][x].nscale8(scale);
+                row[x].nscale8(scale);
             }
         }
-    }
+    });
 }
 
-CRGB GFX_Layer::getAverageColor() const {
-    uint32_t total_r = 0, total_g = 0, total_b = 0;
-    uint32_t pixel_count = _width * _height;
-    
-    if (pixels->contiguous_memory) {
-        for (int i = 0; i < pixel_count; i++) {
-            total_r += pixels->contiguous_memory[i].r;
-            total_g += pixels->contiguous_memory[i].g;
-            total_b += pixels->contiguous_memory[i].b;
+void GFX_Layer::adjustGamma(float gamma) {
+    GFX_ColorCurve curve;
+    curve.setGamma(gamma);
+    applyCurve(curve);
+}
+
+void GFX_Layer::applyCurve(GFX_ColorCurve &curve) {
+    GFX_PROFILE_CALL("GFX_Layer::applyCurve");
+    if (!isInitialized()) return;
+
+    curve.update();
+    forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (int y = begin; y < end; y++) {
+            curve.map(pixels->data[y], _width);
         }
-    } else {
-        for (int y = 0; y < _height; y++) {
-            for (int x = 0; x < _width; x++) {
-                total_r += pixels->data[y][x].r;
-                total_g += pixels->data[y][x].g;
-                total_b += pixels->data[y][x].b;
-            }
+    });
+}
+
+void GFX_Layer::applyColorMatrix(const float matrix[3][3]) {
+    applyColorMatrix(GFX_ColorMatrix(matrix));
+}
+
+void GFX_Layer::applyColorMatrix(const GFX_ColorMatrix &matrix) {
+    GFX_PROFILE_CALL("GFX_Layer::applyColorMatrix");
+    if (!isInitialized()) return;
+
+    forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (int y = begin; y < end; y++) {
+            matrix.apply(pixels->data[y], _width);
         }
-    }
-    
-    return CRGB(total_r / pixel_count, total_g / pixel_count, total_b / pixel_count);
+    });
 }
 
-void GFX_Layer::blur(uint8_t blur_amount) {
-    if (blur_amount == 0) return;
-    
-    // Simple box blur implementation
-    // Note: This is a basic implementation. For better results, consider Gaussian blur
-    for (int y = 1; y < _height - 1; y++) {
-        for (int x = 1; x < _width - 1; x++) {
-            uint16_t r = 0, g = 0, b = 0;
-            uint8_t count = 0;
-            
-            // Sample 3x3 neighborhood
-            for (int dy = -1; dy <= 1; dy++) {
-                for (int dx = -1; dx <= 1; dx++) {
-                    r += pixels->data[y + dy][x + dx].r;
-                    g += pixels->data[y + dy][x + dx].g;
-                    b += pixels->data[y + dy][x + dx].b;
-                    count++;
-                }
-            }
-            
-            CRGB blurred(r / count, g / count, b / count);
-            CRGB original = pixels->data[y][x];
-            
-            // Blend based on blur_amount
-            pixels->data[y][x] = blend(original, blurred, blur_amount);
+void GFX_Layer::mapPalette(const uint8_t *indices, GFX_PaletteCache &palette, uint8_t opacity) {
+    mapPalette(0, 0, _width, _height, indices, palette, opacity);
+}
+
+void GFX_Layer::mapPalette(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *indices,
+                           GFX_PaletteCache &palette, uint8_t opacity) {
+    GFX_PROFILE_CALL("GFX_Layer::mapPalette");
+    if (!isInitialized() || !indices) return;
+
+    // Clip to the layer; the map keeps its w x h layout
+    int32_t x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int32_t x1 = (int32_t)x + w, y1 = (int32_t)y + h;
+    if (x1 > _width)  x1 = _width;
+    if (y1 > _height) y1 = _height;
+    if (x1 <= x0 || y1 <= y0) return;
+
+    const uint16_t cols = x1 - x0;
+    const uint8_t *src  = indices + (size_t)(y0 - y) * w + (x0 - x);
+    GFX_STATS(countFill(x0, y0, cols, y1 - y0));
+
+    // Logical columns x0.. may wrap round the ring-scroll seam: at most two runs per row
+    const uint16_t start = column(x0);
+    const uint16_t first = (start + cols <= _width) ? cols : _width - start;
+
+    palette.update();
+    forEachBand(worker_pool, y1 - y0, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (uint16_t r = begin; r < end; r++) {
+            CRGB          *row = pixels->data[y0 + r];
+            const uint8_t *in  = src + (size_t)r * w;
+            palette.map(in, row + start, first, opacity);
+            palette.map(in + first, row, cols - first, opacity);
+        }
+    });
+}
+
+namespace {
+
+// One band's share of computeStats(), merged once every band is done
+struct StatsPartial {
+    uint32_t *histogram;                // 3 x 256, only with HISTOGRAM
+    uint32_t *buckets;                  // 4096 4-4-4 bit colour buckets, only with DOMINANT
+    uint64_t sum[3];
+    int16_t  min_x, min_y, max_x, max_y;
+    uint32_t foreground;
+    uint8_t  luma_min, luma_max;
+};
+
+void statsSpan(StatsPartial &p, const CRGB *px, uint16_t count, int16_t x, int16_t y, uint8_t flags, const CRGB &background)
+{
+    const bool histogram = flags & GFX_LayerStats::HISTOGRAM;
+    const bool average   = flags & GFX_LayerStats::AVERAGE;
+    const bool dominant  = flags & GFX_LayerStats::DOMINANT;
+    const bool bounds    = flags & GFX_LayerStats::BOUNDS;
+    const bool luma      = flags & GFX_LayerStats::LUMA;
+
+    for (uint16_t i = 0; i < count; i++) {
+        const CRGB &c = px[i];
+
+        if (histogram) {
+            p.histogram[c.r]++;
+            p.histogram[256 + c.g]++;
+            p.histogram[512 + c.b]++;
+        }
+        if (average) {
+            p.sum[0] += c.r;
+            p.sum[1] += c.g;
+            p.sum[2] += c.b;
+        }
+        if (dominant) {
+            p.buckets[((c.r & 0xF0) << 4) | (c.g & 0xF0) | (c.b >> 4)]++;
+        }
+        if (bounds && c != background) {
+            const int16_t cx = x + i;
+            if (cx < p.min_x) p.min_x = cx;
+            if (cx > p.max_x) p.max_x = cx;
+            if (y  < p.min_y) p.min_y = y;
+            if (y  > p.max_y) p.max_y = y;
+            p.foreground++;
+        }
+        if (luma) {
+            const uint8_t l = c.getLuma();
+            if (l < p.luma_min) p.luma_min = l;
+            if (l > p.luma_max) p.luma_max = l;
         }
     }
 }
 
+} // namespace
 
-GFX_Layer::~GFX_Layer(void)
+bool GFX_Layer::computeStats(GFX_LayerStats &stats, uint8_t flags, CRGB background) const
 {
-  if (pixels) {
-    if (pixels->contiguous_memory) {
-      delete[] pixels->contiguous_memory;
+    return computeStats(stats, 0, 0, _width, _height, flags, background);
+}
+
+bool GFX_Layer::computeStats(GFX_LayerStats &stats, int16_t x, int16_t y, int16_t w, int16_t h,
+                             uint8_t flags, CRGB background) const
+{
+    GFX_PROFILE_CALL("GFX_Layer::computeStats");
+    stats.flags = 0;
+    stats.count = 0;
+    if (!isInitialized()) return false;
+
+    // Clip to the layer
+    int32_t x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int32_t x1 = (int32_t)x + w, y1 = (int32_t)y + h;
+    if (x1 > _width)  x1 = _width;
+    if (y1 > _height) y1 = _height;
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+
+    const uint16_t cols  = x1 - x0;
+    const uint16_t rows  = y1 - y0;
+    const uint8_t  bands = bandCount(worker_pool, rows);
+
+    // The counter tables are big (3KB / 16KB per band), so only allocated when asked for
+    const size_t hist_len   = (flags & GFX_LayerStats::HISTOGRAM) ? 3 * 256 : 0;
+    const size_t bucket_len = (flags & GFX_LayerStats::DOMINANT)  ? 4096 : 0;
+
+    StatsPartial *partial = new(std::nothrow) StatsPartial[bands];
+    uint32_t     *tables  = new(std::nothrow) uint32_t[bands * (hist_len + bucket_len) + 1];
+    if (!partial || !tables) {
+        delete[] partial;
+        delete[] tables;
+        return false;
     }
-    if (pixels->data) {
-      delete[] pixels->data;
+    memset(tables, 0, (bands * (hist_len + bucket_len)) * sizeof(uint32_t));
+
+    for (uint8_t b = 0; b < bands; b++) {
+        StatsPartial &p = partial[b];
+        p.histogram = tables + b * (hist_len + bucket_len);
+        p.buckets   = p.histogram + hist_len;
+        p.sum[0] = p.sum[1] = p.sum[2] = 0;
+        p.min_x = p.min_y = INT16_MAX;
+        p.max_x = p.max_y = INT16_MIN;
+        p.foreground = 0;
+        p.luma_min = 255;
+        p.luma_max = 0;
     }
-    delete pixels;
-  }
+
+    // Logical columns x0.. may wrap round the ring-scroll seam: at most two runs per row
+    const uint16_t start = cols ? column(x0) : 0;
+    const uint16_t first = (start + cols <= _width) ? cols : _width - start;
+
+    forEachBand(worker_pool, rows, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (uint16_t r = begin; r < end; r++) {
+            const int16_t  ly  = y0 + r;
+            const CRGB    *row = pixels->data[ly];
+            statsSpan(partial[band], row + start, first, x0, ly, flags, background);
+            statsSpan(partial[band], row, cols - first, x0 + first, ly, flags, background);
+        }
+    });
+
+    // Merge in band order
+    StatsPartial &total = partial[0];
+    for (uint8_t b = 1; b < bands; b++) {
+        const StatsPartial &p = partial[b];
+        for (size_t i = 0; i < hist_len; i++)   total.histogram[i] += p.histogram[i];
+        for (size_t i = 0; i < bucket_len; i++) total.buckets[i]   += p.buckets[i];
+        for (int c = 0; c < 3; c++) total.sum[c] += p.sum[c];
+        if (p.min_x < total.min_x) total.min_x = p.min_x;
+        if (p.min_y < total.min_y) total.min_y = p.min_y;
+        if (p.max_x > total.max_x) total.max_x = p.max_x;
+        if (p.max_y > total.max_y) total.max_y = p.max_y;
+        total.foreground += p.foreground;
+        if (p.luma_min < total.luma_min) total.luma_min = p.luma_min;
+        if (p.luma_max > total.luma_max) total.luma_max = p.luma_max;
+    }
+
+    const uint32_t count = (uint32_t)cols * rows;
+
+    if (flags & GFX_LayerStats::HISTOGRAM) {
+        memcpy(stats.histogram, total.histogram, sizeof(stats.histogram));
+    }
+    if (flags & GFX_LayerStats::AVERAGE) {
+        stats.average = count ? CRGB(total.sum[0] / count, total.sum[1] / count, total.sum[2] / count) : CRGB(0, 0, 0);
+    }
+    if (flags & GFX_LayerStats::DOMINANT) {
+        uint16_t best = 0;              // first bucket wins ties
+        for (uint16_t i = 1; i < 4096; i++) {
+            if (total.buckets[i] > total.buckets[best]) best = i;
+        }
+        stats.dominant       = CRGB(((best >> 8) & 0x0F) * 17, ((best >> 4) & 0x0F) * 17, (best & 0x0F) * 17);
+        stats.dominant_count = total.buckets[best];
+    }
+    if (flags & GFX_LayerStats::BOUNDS) {
+        stats.min_x      = total.min_x;
+        stats.min_y      = total.min_y;
+        stats.max_x      = total.max_x;
+        stats.max_y      = total.max_y;
+        stats.foreground = total.foreground;
+    }
+    if (flags & GFX_LayerStats::LUMA) {
+        stats.luma_min = count ? total.luma_min : 0;
+        stats.luma_max = total.luma_max;
+    }
+
+    delete[] partial;
+    delete[] tables;
+
+    stats.flags = flags;
+    stats.count = count;
+    return true;
 }
-	
 
+CRGB GFX_Layer::getAverageColor() const {
+    GFX_LayerStats stats;
+    if (!computeStats(stats, GFX_LayerStats::AVERAGE)) return CRGB(0, 0, 0);
+    return stats.average;
+}
 
+CRGB GFX_Layer::getDominantColor() const {
+    GFX_LayerStats stats;
+    if (!computeStats(stats, GFX_LayerStats::DOMINANT)) return CRGB(0, 0, 0);
+    return stats.dominant;
+}
 
-/* Merge FastLED layers into a super layer and display. Definition */
+uint32_t GFX_Layer::getPixelCount(CRGB target_color) const {
+    if (!isInitialized()) return 0;
 
-/*
-	* Display the foreground pixels if they're not the background/transparent color.
-	* If not, then fill with whatever is in the background.
-	* 
-	* writeToBg = write the result back to the _bgLayer, and not directly to the output device!
-	* 			   -> no need to do a subsequent bgLayer.display() otherwise.
-	*/
-void GFX_LayerCompositor::Stack(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, bool writeBackToBg)
+    uint32_t count = 0;
+    for (int y = 0; y < _height; y++) {
+        const CRGB *row = pixels->data[y];
+        for (int x = 0; x < _width; x++) {
+            if (row[x] == target_color) count++;
+        }
+    }
+    return count;
+}
+
+/* Noise fills */
+
+bool GFX_NoiseScratch::reserve(size_t count)
 {
-		for (int y = 0; y < _fgLayer.getHeight(); y++) {
-			for (int x = 0; x < _fgLayer.getWidth(); x++)
-			{
-				//https://www.educative.io/edpresso/how-to-resolve-the-expression-must-have-class-type-error-in-cpp
-				if (_fgLayer.pixels->data[y][x] == _fgLayer.transparency_colour) // foreground is transparent, show the _bgLayer colors
-				{
-					if (writeBackToBg) // write the foreground to the background layer... perhaps so we can do stuff later with the _fgLayer.
-						_bgLayer.pixels->data[y][x]	= _bgLayer.pixels->data[y][x];
-					else
-
-						callback(x,y, _bgLayer.pixels->data[y][x].r, _bgLayer.pixels->data[y][x].g, _bgLayer.pixels->data[y][x].b );
-
-				} // if the foreground is NOT transparent, then print whatever is the bg
-				else
-				{
-					if (writeBackToBg) // write the foreground to the background layer... perhaps so we can do stuff later with the _fgLayer.
-						_bgLayer.pixels->data[y][x]	= _fgLayer.pixels->data[y][x];
-					else
-						callback(x,y, _fgLayer.pixels->data[y][x].r, _fgLayer.pixels->data[y][x].g, _fgLayer.pixels->data[y][x].b );
-				}
+    if (count <= pixels) return true;
 
-			} // end x loop
-		} // end y loop
-}  // end stack
+    uint8_t *grown = new(std::nothrow) uint8_t[count * 2];
+    if (!grown) return false;
 
+    delete[] buffer;
+    buffer = grown;
+    pixels = count;
+    return true;
+}
 
-/*
-	* Where the foreground pixels are not the background/transparent color, populate with 
-	* whatever is in the background.
-	*/
-void GFX_LayerCompositor::Siloette(GFX_Layer &_bgLayer,  GFX_Layer &_fgLayer)
+bool GFX_Layer::fillNoise8(const GFX_NoiseField &value, const GFX_NoiseField &hue, bool blend,
+                           GFX_NoiseScratch *scratch)
 {
+    return fillNoise(NOISE_PERLIN8, 0, 0, _width, _height, value, hue, 0, blend, scratch);
+}
 
-		for (int y = 0; y < _fgLayer.getHeight(); y++) {
-			for (int x = 0; x < _fgLayer.getWidth(); x++)
-			{
-				//https://www.educative.io/edpresso/how-to-resolve-the-expression-must-have-class-type-error-in-cpp
-				if (_fgLayer.pixels->data[y][x] != _fgLayer.transparency_colour)
-				{
-					callback(x,y, _bgLayer.pixels->data[y][x].r, _bgLayer.pixels->data[y][x].g, _bgLayer.pixels->data[y][x].b );
-				} // if the foreground is transparent, then print whatever is the bg
-				else
-				{
-					callback(x,y, 0,0,0);
-				}
-
-			} // end x loop
-		} // end y loop
-}  // end stack		
+bool GFX_Layer::fillNoise8(int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                           const GFX_NoiseField &hue, bool blend, GFX_NoiseScratch *scratch)
+{
+    return fillNoise(NOISE_PERLIN8, x, y, w, h, value, hue, 0, blend, scratch);
+}
 
+bool GFX_Layer::fillNoise16(const GFX_NoiseField &value, const GFX_NoiseField &hue, uint16_t hue_shift,
+                            bool blend, GFX_NoiseScratch *scratch)
+{
+    return fillNoise(NOISE_PERLIN16, 0, 0, _width, _height, value, hue, hue_shift, blend, scratch);
+}
 
+bool GFX_Layer::fillNoise16(int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                            const GFX_NoiseField &hue, uint16_t hue_shift, bool blend, GFX_NoiseScratch *scratch)
+{
+    return fillNoise(NOISE_PERLIN16, x, y, w, h, value, hue, hue_shift, blend, scratch);
+}
 
+bool GFX_Layer::fillSimplex(const GFX_NoiseField &value, const GFX_NoiseField &hue, uint16_t hue_shift,
+                            bool blend, GFX_NoiseScratch *scratch)
+{
+    return fillNoise(NOISE_SIMPLEX, 0, 0, _width, _height, value, hue, hue_shift, blend, scratch);
+}
 
+bool GFX_Layer::fillSimplex(int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                            const GFX_NoiseField &hue, uint16_t hue_shift, bool blend, GFX_NoiseScratch *scratch)
+{
+    return fillNoise(NOISE_SIMPLEX, x, y, w, h, value, hue, hue_shift, blend, scratch);
+}
 
-void GFX_LayerCompositor::Blend(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, uint8_t ratio)
+bool GFX_Layer::fillNoise(NoiseKind kind, int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                          const GFX_NoiseField &hue, uint16_t hue_shift, bool blend, GFX_NoiseScratch *scratch)
 {
-	CRGB _pixel = 0 ;
+    GFX_PROFILE_CALL(kind == NOISE_SIMPLEX  ? "GFX_Layer::fillSimplex" :
+                     kind == NOISE_PERLIN16 ? "GFX_Layer::fillNoise16" : "GFX_Layer::fillNoise8");
+    if (!isInitialized()) return false;
 
-	for (int y = 0; y < _fgLayer.getHeight(); y++) 
-	{
-		for (int x = 0; x < _fgLayer.getWidth(); x++)
-		{
-				_pixel = _bgLayer.pixels->data[y][x];
-			
-				// (set ratio to 127 for a constant 50% / 50% blend)
-				//_pixel = blend(_bgLayer.pixels->data[y][x], _fgLayer.pixels->data[y][x], ratio);
-
-				// Blend with background if foreground pixel isn't clear/transparent
-				if (_fgLayer.pixels->data[y][x] != _fgLayer.transparency_colour)
-				{
-					_pixel = blend(_bgLayer.pixels->data[y][x], _fgLayer.pixels->data[y][x], ratio);
-				} // if the foreground is transparent, then print whatever is the bg
-				
-				
-				// https://gist.github.com/StefanPetrick/0c0d54d0f35ea9cca983
-				callback(x,y, _pixel.r, _pixel.g, _pixel.b );
+    // Clip to the layer
+    int32_t x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int32_t x1 = (int32_t)x + w, y1 = (int32_t)y + h;
+    if (x1 > _width)  x1 = _width;
+    if (y1 > _height) y1 = _height;
+    if (x1 <= x0 || y1 <= y0) return true;
 
-		} // end x loop
-	} // end y loop
+    const uint16_t cols = x1 - x0;
+    const uint16_t rows = y1 - y0;
 
+    if (!scratch) {
+        if (!noise_scratch) noise_scratch = new(std::nothrow) GFX_NoiseScratch;
+        scratch = noise_scratch;
+    }
+    if (!scratch || !scratch->reserve((size_t)cols * rows)) return false;
 
+    const uint8_t saturation = kind == NOISE_PERLIN16 ? 196 : 255;
+    const uint8_t hue_offset = hue_shift >> 8;
 
-} // end blend
+    // Each band builds the maps for its own rows, in its own part of the scratch
+    forEachBand(worker_pool, rows, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        const int band_rows = end - begin;
+        uint8_t *V = scratch->value() + (size_t)begin * cols;
+        uint8_t *H = scratch->hue()   + (size_t)begin * cols;
+        if (kind == NOISE_SIMPLEX) {
+            // Simplex fields aren't periodic, so a window is just the field at an offset origin
+            fill_raw_2dsimplex8(V, cols, band_rows, value.octaves,
+                                value.x + (uint32_t)x0 * value.xscale, value.xscale,
+                                value.y + (uint32_t)(y0 + begin) * value.yscale, value.yscale, value.time);
+            fill_raw_2dsimplex8(H, cols, band_rows, hue.octaves,
+                                hue.x + (uint32_t)x0 * hue.xscale, hue.xscale,
+                                hue.y + (uint32_t)(y0 + begin) * hue.yscale, hue.yscale, hue.time);
+        } else {
+            memset(V, 0, (size_t)band_rows * cols);
+            memset(H, 0, (size_t)band_rows * cols);
 
+            if (kind == NOISE_PERLIN16) {
+                fill_raw_2dnoise16into8_upscaled_window(V, cols, _width, _height, x0, y0 + begin, cols, band_rows, value.step,
+                                                        value.octaves, value.x, value.xscale, value.y, value.yscale, value.time);
+            } else {
+                fill_raw_2dnoise8_window(V, cols, _width, _height, x0, y0 + begin, cols, band_rows,
+                                         value.octaves, value.x, value.xscale, value.y, value.yscale, value.time);
+            }
 
-// Advanced blending function implementation
-CRGB GFX_LayerCompositor::blendPixels(CRGB base, CRGB overlay, BlendMode mode, uint8_t opacity) {
-    if (opacity == 0) return base;
-    if (opacity == 255 && mode == BLEND_NORMAL) return overlay;
-    
-    CRGB result;
-    
-    switch (mode) {
-        case BLEND_NORMAL:
-            result = overlay;
-            break;
-            
-        case BLEND_MULTIPLY:
-            result.r = (base.r * overlay.r) / 255;
-            result.g = (base.g * overlay.g) / 255;
-            result.b = (base.b * overlay.b) / 255;
-            break;
-            
-        case BLEND_SCREEN:
-            result.r = 255 - ((255 - base.r) * (255 - overlay.r)) / 255;
-            result.g = 255 - ((255 - base.g) * (255 - overlay.g)) / 255;
-            result.b = 255 - ((255 - base.b) * (255 - overlay.b)) / 255;
-            break;
-            
-        case BLEND_OVERLAY:
-            // Simple overlay implementation
-            for (int i = 0; i < 3; i++) {
-                uint8_t* base_c = (i == 0) ? &base.r : (i == 1) ? &base.g : &base.b;
-                uint8_t* overlay_c = (i == 0) ? &overlay.r : (i == 1) ? &overlay.g : &overlay.b;
-                uint8_t* result_c = (i == 0) ? &result.r : (i == 1) ? &result.g : &result.b;
-                
-                if (*base_c < 128) {
-                    *result_c = (2 * (*base_c) * (*overlay_c)) / 255;
+            // The hue map is read mirrored, so its window is the mirror image of this one
+            fill_raw_2dnoise8_window(H, cols, _width, _height, _width - x1, _height - (y0 + end), cols, band_rows,
+                                     hue.octaves, hue.x, hue.xscale, hue.y, hue.yscale, hue.time);
+        }
+
+        for (int i = 0; i < band_rows; i++) {
+            CRGB          *row = pixels->data[y0 + begin + i];
+            const uint8_t *v   = V + (size_t)i * cols;
+            const uint8_t *h   = H + (size_t)i * cols;
+            const uint8_t *hm  = H + (size_t)(band_rows - 1 - i) * cols + (cols - 1);
+
+            for (uint16_t j = 0; j < cols; j++) {
+                const uint8_t hv = kind == NOISE_SIMPLEX ? h[j] : hm[-(int)j];
+                CRGB  led(CHSV(hue_offset + hv, saturation, v[j]));
+                CRGB &px = row[column(x0 + j)];
+                if (blend) {
+                    px >>= 1; px += (led >>= 1);
                 } else {
-                    *result_c = 255 - (2 * (255 - *base_c) * (255 - *overlay_c)) / 255;
+                    px = led;
                 }
             }
-            break;
-            
-        default:
-            result = overlay; // fallback to normal blend
-            break;
-    }
-    
-    // Apply opacity
-    if (opacity < 255) {
-        result = blend(base, result, opacity);
-    }
-    
-    return result;
+        }
+    });
+
+    return true;
 }
 
-void GFX_LayerCompositor::BlendAdvanced(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, BlendMode mode, uint8_t opacity) {
-    for (int y = 0; y < min(_bgLayer.getHeight(), _fgLayer.getHeight()); y++) {
-        for (int x = 0; x < min(_bgLayer.getWidth(), _fgLayer.getWidth()); x++) {
-            CRGB base = _bgLayer.pixels->data[y][x];
-            CRGB overlay = _fgLayer.pixels->data[y][x];
-            
-            // Skip transparent pixels in foreground layer if transparency is enabled
-            if (_fgLayer.transparency_enabled && overlay == _fgLayer.transparency_colour) {
-                callback(x, y, base.r, base.g, base.b);
-                continue;
+/* Flips and rotations */
+
+namespace {
+
+// Tile edge for the blocked transposes: a 16x16 CRGB tile is 768 bytes, so both the
+// tile being read and the one being written stay in L1 on every target
+const uint16_t TRANSPOSE_TILE = 16;
+
+// In place transpose of an n x n block of pixels, a pair of tiles at a time
+void transposeSquare(CRGB *p, uint16_t n)
+{
+    for (uint16_t ty = 0; ty < n; ty += TRANSPOSE_TILE) {
+        const uint16_t ty1 = std::min<uint16_t>(ty + TRANSPOSE_TILE, n);
+
+        for (uint16_t tx = ty; tx < n; tx += TRANSPOSE_TILE) {
+            const uint16_t tx1 = std::min<uint16_t>(tx + TRANSPOSE_TILE, n);
+
+            for (uint16_t y = ty; y < ty1; y++) {
+                // On the diagonal tile only swap above the diagonal
+                for (uint16_t x = (tx == ty) ? y + 1 : tx; x < tx1; x++) {
+                    std::swap(p[(size_t)y * n + x], p[(size_t)x * n + y]);
+                }
             }
-            
-            CRGB result = blendPixels(base, overlay, mode, opacity);
-            callback(x, y, result.r, result.g, result.b);
         }
     }
 }
 
-void GFX_LayerCompositor::Mask(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_Layer &_maskLayer) {
-    int max_width = min(min(_bgLayer.getWidth(), _fgLayer.getWidth()), _maskLayer.getWidth());
-    int max_height = min(min(_bgLayer.getHeight(), _fgLayer.getHeight()), _maskLayer.getHeight());
-    
-    for (int y = 0; y < max_height; y++) {
-        for (int x = 0; x < max_width; x++) {
-            CRGB base = _bgLayer.pixels->data[y][x];
-            CRGB overlay = _fgLayer.pixels->data[y][x];
-            CRGB mask = _maskLayer.pixels->data[y][x];
-            
-            // Use mask luminance as alpha
-            uint8_t alpha = (mask.r + mask.g + mask.b) / 3;
-            CRGB result = blend(base, overlay, alpha);
-            
-            callback(x, y, result.r, result.g, result.b);
+} // namespace
+
+void GFX_Layer::flipHorizontal() {
+    GFX_PROFILE_CALL("GFX_Layer::flipHorizontal");
+    if (!isInitialized()) return;
+    linearize();
+
+    forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (int y = begin; y < end; y++) {
+            std::reverse(pixels->data[y], pixels->data[y] + _width);
+        }
+    });
+}
+
+void GFX_Layer::flipVertical() {
+    GFX_PROFILE_CALL("GFX_Layer::flipVertical");
+    if (!isInitialized()) return;
+    linearize();
+
+    for (int y = 0; y < _height / 2; y++) {
+        std::swap_ranges(pixels->data[y], pixels->data[y] + _width, pixels->data[_height - 1 - y]);
+    }
+}
+
+void GFX_Layer::rotate180() {
+    GFX_PROFILE_CALL("GFX_Layer::rotate180");
+    if (!isInitialized()) return;
+    linearize();
+    std::reverse(pixels->contiguous_memory, pixels->contiguous_memory + (size_t)_width * _height);
+}
+
+// Clockwise: transpose, then mirror each row
+bool GFX_Layer::rotate90() {
+    GFX_PROFILE_CALL("GFX_Layer::rotate90");
+    if (!isInitialized() || _width != _height) return false;
+    linearize();
+    transposeSquare(pixels->contiguous_memory, _width);
+    flipHorizontal();
+    return true;
+}
+
+// Anti-clockwise: transpose, then swap the rows top to bottom
+bool GFX_Layer::rotate270() {
+    GFX_PROFILE_CALL("GFX_Layer::rotate270");
+    if (!isInitialized() || _width != _height) return false;
+    linearize();
+    transposeSquare(pixels->contiguous_memory, _width);
+    flipVertical();
+    return true;
+}
+
+bool GFX_Layer::rotate90(GFX_Layer &dst) {
+    GFX_PROFILE_CALL("GFX_Layer::rotate90");
+    if (&dst == this) return rotate90();
+    if (!isInitialized() || !dst.isInitialized()) return false;
+    if (dst.getWidth() != _height || dst.getHeight() != _width) return false;
+
+    linearize();
+    dst.linearize();
+
+    const CRGB *src = pixels->contiguous_memory;
+    CRGB       *out = dst.pixels->contiguous_memory;
+
+    // Source (x,y) lands on destination (H-1-y, x); walk tile by tile so neither side
+    // strides through more than a tile's worth of cache lines
+    for (uint16_t ty = 0; ty < _height; ty += TRANSPOSE_TILE) {
+        const uint16_t ty1 = std::min<uint16_t>(ty + TRANSPOSE_TILE, _height);
+        for (uint16_t tx = 0; tx < _width; tx += TRANSPOSE_TILE) {
+            const uint16_t tx1 = std::min<uint16_t>(tx + TRANSPOSE_TILE, _width);
+            for (uint16_t x = tx; x < tx1; x++) {
+                CRGB *row = out + (size_t)x * _height + (_height - 1);
+                for (uint16_t y = ty; y < ty1; y++) {
+                    row[-(int32_t)y] = src[(size_t)y * _width + x];
+                }
+            }
         }
     }
+    return true;
 }
 
+bool GFX_Layer::rotate270(GFX_Layer &dst) {
+    GFX_PROFILE_CALL("GFX_Layer::rotate270");
+    if (&dst == this) return rotate270();
+    if (!isInitialized() || !dst.isInitialized()) return false;
+    if (dst.getWidth() != _height || dst.getHeight() != _width) return false;
+
+    linearize();
+    dst.linearize();
+
+    const CRGB *src = pixels->contiguous_memory;
+    CRGB       *out = dst.pixels->contiguous_memory;
+
+    // Source (x,y) lands on destination (y, W-1-x)
+    for (uint16_t ty = 0; ty < _height; ty += TRANSPOSE_TILE) {
+        const uint16_t ty1 = std::min<uint16_t>(ty + TRANSPOSE_TILE, _height);
+        for (uint16_t tx = 0; tx < _width; tx += TRANSPOSE_TILE) {
+            const uint16_t tx1 = std::min<uint16_t>(tx + TRANSPOSE_TILE, _width);
+            for (uint16_t x = tx; x < tx1; x++) {
+                CRGB *row = out + (size_t)(_width - 1 - x) * _height;
+                for (uint16_t y = ty; y < ty1; y++) {
+                    row[y] = src[(size_t)y * _width + x];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/* Affine blits */
+
+GFX_Affine &GFX_Affine::translate(float x, float y)
+{
+    tx += x;
+    ty += y;
+    return *this;
+}
+
+GFX_Affine &GFX_Affine::rotate(float degrees)
+{
+    const float r = degrees * (float)M_PI / 180.0f;
+    const float cs = cosf(r), sn = sinf(r);
+    const GFX_Affine m = *this;
+
+    a  = cs * m.a  - sn * m.c;   b  = cs * m.b  - sn * m.d;
+    c  = sn * m.a  + cs * m.c;   d  = sn * m.b  + cs * m.d;
+    tx = cs * m.tx - sn * m.ty;  ty = sn * m.tx + cs * m.ty;
+    return *this;
+}
+
+GFX_Affine &GFX_Affine::scale(float sx, float sy)
+{
+    a *= sx; b *= sx; tx *= sx;
+    c *= sy; d *= sy; ty *= sy;
+    return *this;
+}
+
+GFX_Affine &GFX_Affine::shear(float kx, float ky)
+{
+    const GFX_Affine m = *this;
+
+    a  = m.a  + kx * m.c;   b  = m.b  + kx * m.d;
+    c  = m.c  + ky * m.a;   d  = m.d  + ky * m.b;
+    tx = m.tx + kx * m.ty;  ty = m.ty + ky * m.tx;
+    return *this;
+}
+
+namespace {
+
+inline int64_t toFixed16(float v)
+{
+    return (int64_t)llroundf(v * 65536.0f);
+}
+
+inline int64_t floorDiv(int64_t n, int64_t d)   // d > 0
+{
+    return (n >= 0) ? n / d : -((-n + d - 1) / d);
+}
+
+// Narrow [x0, x1) to the x where lo <= f0 + x*df < hi, all in 16.16
+void clipLinear(int64_t f0, int64_t df, int64_t lo, int64_t hi, int64_t &x0, int64_t &x1)
+{
+    if (df == 0) {
+        if (f0 < lo || f0 >= hi) x1 = x0;
+        return;
+    }
+
+    int64_t first, end;
+    if (df > 0) {
+        first = -floorDiv(f0 - lo, df);                 // ceil((lo - f0) / df)
+        end   = -floorDiv(f0 - hi, df);                 // ceil((hi - f0) / df)
+    } else {
+        first = floorDiv(f0 - hi, -df) + 1;
+        end   = floorDiv(f0 - lo, -df) + 1;
+    }
+    if (first > x0) x0 = first;
+    if (end   < x1) x1 = end;
+}
+
+// Bilinear tap weights are 8 bit, so the four products of one channel sum to at most 255 << 16
+inline uint8_t bilerp(uint8_t p00, uint8_t p10, uint8_t p01, uint8_t p11, uint16_t fx, uint16_t fy)
+{
+    const uint32_t top = p00 * (256 - fx) + p10 * fx;
+    const uint32_t bot = p01 * (256 - fx) + p11 * fx;
+    return (uint8_t)((top * (256 - fy) + bot * fy + 32768) >> 16);
+}
+
+} // namespace
+
+void GFX_Layer::drawAffine(const GFX_Surface &src, const GFX_Affine &xf, uint8_t flags, CRGB key)
+{
+    GFX_PROFILE_CALL("GFX_Layer::drawAffine");
+    if (!isInitialized() || !src.data || src.width == 0 || src.height == 0) return;
+    if (src.data == pixels->contiguous_memory) return;      // can't read and write the same pixels
+
+    const float det = xf.a * xf.d - xf.b * xf.c;
+    if (fabsf(det) < 1e-9f) return;
+
+    linearize();
+
+    // Destination pixel centre -> source coordinates, 16.16
+    const float ia =  xf.d / det, ib = -xf.b / det;
+    const float ic = -xf.c / det, id =  xf.a / det;
+    const float ox = 0.5f - xf.tx, oy = 0.5f - xf.ty;
+
+    const int64_t u00 = toFixed16(ia * ox + ib * oy), v00 = toFixed16(ic * ox + id * oy);
+    const int64_t du_dx = toFixed16(ia), dv_dx = toFixed16(ic);
+    const int64_t du_dy = toFixed16(ib), dv_dy = toFixed16(id);
+
+    const int64_t u_end = (int64_t)src.width << 16, v_end = (int64_t)src.height << 16;
+    const bool bilinear = flags & GFX_Affine::BILINEAR;
+    const bool keyed    = flags & GFX_Affine::COLOR_KEY;
+
+    forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        for (uint16_t y = begin; y < end; y++) {
+            const int64_t u0 = u00 + y * du_dy, v0 = v00 + y * dv_dy;
+
+            // Only the run of x whose sample lands inside the source
+            int64_t x0 = 0, x1 = _width;
+            clipLinear(u0, du_dx, 0, u_end, x0, x1);
+            clipLinear(v0, dv_dx, 0, v_end, x0, x1);
+            if (x0 >= x1) continue;
+
+            int32_t u = (int32_t)(u0 + x0 * du_dx), v = (int32_t)(v0 + x0 * dv_dx);
+            const int32_t du = (int32_t)du_dx, dv = (int32_t)dv_dx;
+            CRGB *out = pixels->data[y];
+
+            for (int32_t x = (int32_t)x0; x < x1; x++, u += du, v += dv) {
+                const CRGB &nearest = src.row(v >> 16)[u >> 16];
+                if (keyed && nearest == key) continue;
+
+                if (!bilinear) {
+                    out[x] = nearest;
+                    continue;
+                }
+
+                // Taps around the sample point, clamped at the source edges
+                const int32_t su = u - 0x8000, sv = v - 0x8000;
+                int32_t sx0 = su >> 16, sy0 = sv >> 16;
+                const uint16_t fx = (su >> 8) & 0xFF, fy = (sv >> 8) & 0xFF;
+                int32_t sx1 = sx0 + 1, sy1 = sy0 + 1;
+                if (sx0 < 0) sx0 = 0;
+                if (sy0 < 0) sy0 = 0;
+                if (sx1 >= src.width)  sx1 = src.width - 1;
+                if (sy1 >= src.height) sy1 = src.height - 1;
+
+                const CRGB *r0 = src.row(sy0), *r1 = src.row(sy1);
+                CRGB p00 = r0[sx0], p10 = r0[sx1], p01 = r1[sx0], p11 = r1[sx1];
+
+                // Keyed taps take the colour of the nearest one, so the key doesn't bleed in
+                if (keyed) {
+                    if (p00 == key) p00 = nearest;
+                    if (p10 == key) p10 = nearest;
+                    if (p01 == key) p01 = nearest;
+                    if (p11 == key) p11 = nearest;
+                }
+
+                out[x] = CRGB(bilerp(p00.r, p10.r, p01.r, p11.r, fx, fy),
+                              bilerp(p00.g, p10.g, p01.g, p11.g, fx, fy),
+                              bilerp(p00.b, p10.b, p01.b, p11.b, fx, fy));
+            }
+        }
+    });
+}
+
+void GFX_Layer::blur(uint8_t blur_amount) {
+    GFX_PROFILE_CALL("GFX_Layer::blur");
+    if (blur_amount == 0 || _width < 3 || _height < 3) return;
+
+    linearize();
+    
+    // Simple box blur implementation
+    // Note: This is a basic implementation. For better results, consider Gaussian blur
+    //
+    // Every pixel is averaged from the *original* 3x3 neighbourhood, so the result doesn't
+    // depend on scan order or on how the rows are split between worker threads. Each band
+    // keeps copies of the original rows around the one being written, and the rows just
+    // outside each band are captured before any band starts.
+    const uint16_t rows  = _height - 2;
+    const uint8_t  bands = bandCount(worker_pool, rows);
+
+    CRGB *scratch = new(std::nothrow) CRGB[(size_t)bands * 4 * _width];
+    if (!scratch) return;
+
+    for (uint8_t b = 0; b < bands; b++) {
+        CRGB *edges = scratch + (size_t)b * 4 * _width;
+        memcpy(edges,          pixels->data[GFX_WorkerPool::bandBegin(rows, bands, b)],     _width * sizeof(CRGB)); // row above the band
+        memcpy(edges + _width, pixels->data[GFX_WorkerPool::bandBegin(rows, bands, b + 1) + 1], _width * sizeof(CRGB)); // row below
+    }
+
+    forEachBand(worker_pool, rows, [&](uint16_t begin, uint16_t end, uint8_t band) {
+        CRGB *above = scratch + (size_t)band * 4 * _width;
+        CRGB *below = above + _width;
+        CRGB *prev  = below + _width;
+        CRGB *cur   = prev + _width;
+
+        memcpy(prev, above, _width * sizeof(CRGB));
+
+        for (int y = begin + 1; y < end + 1; y++) {
+            memcpy(cur, pixels->data[y], _width * sizeof(CRGB));
+            const CRGB *next = (y + 1 == end + 1) ? below : pixels->data[y + 1];
+            const CRGB *src[3] = { prev, cur, next };
+
+            for (int x = 1; x < _width - 1; x++) {
+                uint16_t r = 0, g = 0, b = 0;
+                uint8_t count = 0;
+
+                // Sample 3x3 neighborhood
+                for (int dy = 0; dy < 3; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        r += src[dy][x + dx].r;
+                        g += src[dy][x + dx].g;
+                        b += src[dy][x + dx].b;
+                        count++;
+                    }
+                }
+
+                CRGB blurred(r / count, g / count, b / count);
+
+                // Blend based on blur_amount
+                pixels->data[y][x] = blend(cur[x], blurred, blur_amount);
+            }
+
+            CRGB *t = prev; prev = cur; cur = t;
+        }
+    });
+
+    delete[] scratch;
+}
+
+
+namespace {
+
+// Columns gathered together by the vertical box blur pass, so each row is read once per block
+const uint16_t BLUR_COLUMN_BLOCK = 16;
+
+/*
+ * One box blur pass along a line of n pixels: in[] is a copy of the line, results go to
+ * out[]. The window slides by adding the pixel entering it and removing
+ * the one leaving it; indices outside the line are clamped to its ends.
+ */
+void boxBlurLine(const CRGB *in, CRGB *out, uint16_t n, uint8_t radius, uint8_t amount)
+{
+    const int32_t  last = n - 1;
+    const uint32_t size = 2 * (uint32_t)radius + 1;
+    const uint32_t half = size / 2;
+    const uint32_t inv  = (uint32_t)((0x100000000ull + size - 1) / size);  // exact for sums < 2^23
+
+    auto avg = [&](uint32_t sum) -> uint8_t { return (uint8_t)(((uint64_t)(sum + half) * inv) >> 32); };
+
+    uint32_t r = 0, g = 0, b = 0;
+    for (int32_t i = -radius; i <= radius; i++) {
+        const CRGB &p = in[i < 0 ? 0 : (i > last ? last : i)];
+        r += p.r; g += p.g; b += p.b;
+    }
+
+    for (int32_t x = 0; x <= last; x++) {
+        const CRGB box(avg(r), avg(g), avg(b));
+        out[x] = (amount == 255) ? box : blend(in[x], box, amount);
+
+        const int32_t add = x + radius + 1, sub = x - radius;
+        const CRGB &pa = in[add > last ? last : add];
+        const CRGB &ps = in[sub < 0 ? 0 : sub];
+        r += pa.r - ps.r; g += pa.g - ps.g; b += pa.b - ps.b;
+    }
+}
+
+} // namespace
+
+void GFX_Layer::boxBlur(uint8_t radius, uint8_t passes, uint8_t amount)
+{
+    GFX_PROFILE_CALL("GFX_Layer::boxBlur");
+    if (radius == 0 || passes == 0 || amount == 0 || !isInitialized()) return;
+
+    linearize();
+
+    // One line of scratch per band for the rows, a block of columns in and out for the columns
+    const uint8_t row_bands = bandCount(worker_pool, _height);
+    const uint8_t col_bands = bandCount(worker_pool, _width);
+    const size_t  per_band  = std::max((size_t)_width, (size_t)2 * BLUR_COLUMN_BLOCK * _height);
+
+    CRGB *scratch = new(std::nothrow) CRGB[per_band * std::max(row_bands, col_bands)];
+    if (!scratch) return;
+
+    CRGB *const base = pixels->contiguous_memory;
+
+    for (uint8_t pass = 0; pass < passes; pass++) {
+
+        forEachBand(worker_pool, _height, [&](uint16_t begin, uint16_t end, uint8_t band) {
+            CRGB *line = scratch + band * per_band;
+            for (uint16_t y = begin; y < end; y++) {
+                CRGB *row = base + (size_t)y * _width;
+                memcpy(line, row, _width * sizeof(CRGB));
+                boxBlurLine(line, row, _width, radius, amount);
+            }
+        });
+
+        forEachBand(worker_pool, _width, [&](uint16_t begin, uint16_t end, uint8_t band) {
+            CRGB *in  = scratch + band * per_band;
+            CRGB *out = in + BLUR_COLUMN_BLOCK * _height;
+
+            for (uint16_t x0 = begin; x0 < end; x0 += BLUR_COLUMN_BLOCK) {
+                const uint16_t cols = std::min<uint16_t>(BLUR_COLUMN_BLOCK, end - x0);
+
+                // Gather the block column-major, filter each column, scatter it back
+                for (uint16_t y = 0; y < _height; y++) {
+                    const CRGB *row = base + (size_t)y * _width + x0;
+                    for (uint16_t c = 0; c < cols; c++) in[(size_t)c * _height + y] = row[c];
+                }
+                for (uint16_t c = 0; c < cols; c++) {
+                    boxBlurLine(in + (size_t)c * _height, out + (size_t)c * _height, _height, radius, amount);
+                }
+                for (uint16_t y = 0; y < _height; y++) {
+                    CRGB *row = base + (size_t)y * _width + x0;
+                    for (uint16_t c = 0; c < cols; c++) row[c] = out[(size_t)c * _height + y];
+                }
+            }
+        });
+    }
+
+    delete[] scratch;
+}
+
+
+void GFX_Layer::blur2d(fract8 blur_amount) {
+    GFX_PROFILE_CALL("GFX_Layer::blur2d");
+    if (!isInitialized()) return;
+    linearize();
+    ::blur2d(pixels->contiguous_memory, _width, _height, _width, blur_amount);
+}
+
+void GFX_Layer::blurRows(fract8 blur_amount) {
+    GFX_PROFILE_CALL("GFX_Layer::blurRows");
+    if (!isInitialized()) return;
+    linearize();
+    ::blurRows(pixels->contiguous_memory, _width, _height, _width, blur_amount);
+}
+
+void GFX_Layer::blurColumns(fract8 blur_amount) {
+    GFX_PROFILE_CALL("GFX_Layer::blurColumns");
+    if (!isInitialized()) return;
+    linearize();
+    ::blurColumns(pixels->contiguous_memory, _width, _height, _width, blur_amount);
+}
+
+
+#if GFX_RENDER_STATS
+void GFX_Layer::resetRenderStats()
+{
+    render_stats = GFX_RenderStats();
+    if (written) memset(written, 0, ((size_t)_width * _height + 7) / 8);
+}
+
+// Marks (x,y) written this frame, counting it as overdraw if it already was
+void GFX_Layer::countWrite(int16_t x, int16_t y)
+{
+    if (!written) {
+        const size_t bytes = ((size_t)_width * _height + 7) / 8;
+        written = new(std::nothrow) uint8_t[bytes];
+        if (!written) return;
+        memset(written, 0, bytes);
+    }
+
+    const size_t  i   = (size_t)y * _width + x;
+    const uint8_t bit = 1 << (i & 7);
+    if (written[i >> 3] & bit) render_stats.overdraw_pixels++;
+    written[i >> 3] |= bit;
+}
+
+void GFX_Layer::countFill(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    render_stats.fill_pixels += (uint32_t)w * h;
+    for (int16_t j = y; j < y + h; j++) {
+        for (int16_t i = x; i < x + w; i++) countWrite(i, j);
+    }
+}
+#endif
+
+GFX_Layer::~GFX_Layer(void)
+{
+  delete noise_scratch;
+#if GFX_RENDER_STATS
+  delete[] written;
+#endif
+  if (pixels) {
+    if (pixels->contiguous_memory) {
+      delete[] pixels->contiguous_memory;
+    }
+    if (pixels->data) {
+      delete[] pixels->data;
+    }
+    delete pixels;
+  }
+}
+	
+
+
+
+/* 8-bit alpha mask. Definition */
+
+GFX_AlphaMask::GFX_AlphaMask(uint16_t width, uint16_t height)
+    : GFX(width, height), _width(width), _height(height)
+{
+    alpha = new(std::nothrow) uint8_t[(size_t)_width * _height];
+    if (!alpha) {
+        _width = _height = 0;
+        return;
+    }
+    memset(alpha, 0, (size_t)_width * _height);
+}
+
+void GFX_AlphaMask::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB color)
+{
+    // Bounds checking and clipping
+    if (x >= _width || y >= _height) return;
+    if (x + w < 0 || y + h < 0) return;
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > _width) { w = _width - x; }
+    if (y + h > _height) { h = _height - y; }
+
+    if (w <= 0 || h <= 0) return;
+
+    const uint8_t a = (color.r + color.g + color.b) / 3;
+    for (int16_t j = y; j < y + h; j++) {
+        memset(row(j) + x, a, w);
+    }
+}
+
+void GFX_AlphaMask::fillAlpha(uint8_t a)
+{
+    if (alpha) memset(alpha, a, (size_t)_width * _height);
+}
+
+void GFX_AlphaMask::fromLuminance(GFX_Layer &layer)
+{
+    if (!isInitialized() || !layer.isInitialized()) return;
+
+    const uint16_t w = min(_width, layer.getWidth());
+    const uint16_t h = min(_height, layer.getHeight());
+
+    // Logical pixels, so a ring-scrolled layer reads from its wrapped columns
+    CRGB scratch[64];
+    for (int y = 0; y < h; y++) {
+        uint8_t *dst = row(y);
+        for (int x0 = 0; x0 < w; x0 += 64) {
+            const uint16_t n = min(64, w - x0);
+            const CRGB *src = layer.readRow(y, x0, n, scratch);
+            for (int x = 0; x < n; x++) {
+                dst[x0 + x] = (src[x].r + src[x].g + src[x].b) / 3;
+            }
+        }
+    }
+}
+
+
+/* Merge FastLED layers into a super layer and display. Definition */
+
+/*
+ * Compile-time blend kernels.
+ *
+ * Every blend mode is a tiny policy struct with a per-channel mix(). blendRow()
+ * is instantiated for each (mode x keyed x full opacity) combination, so the
+ * transparency test, the opacity test and the mode switch are all resolved
+ * once per call in resolveBlendRow() rather than once per pixel.
+ *
+ * Adding a blend mode = add a policy below and a case in resolveBlendRow().
+ */
+namespace {
+
+struct BlendNormalOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return overlay; }
+};
+
+struct BlendMultiplyOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return (base * overlay) / 255; }
+};
+
+struct BlendScreenOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return 255 - ((255 - base) * (255 - overlay)) / 255; }
+};
+
+struct BlendOverlayOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) {
+        return (base < 128) ? (2 * base * overlay) / 255
+                            : 255 - (2 * (255 - base) * (255 - overlay)) / 255;
+    }
+};
+
+struct BlendDarkenOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return (overlay < base) ? overlay : base; }
+};
+
+struct BlendLightenOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return (overlay > base) ? overlay : base; }
+};
+
+struct BlendAddOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return qadd8(base, overlay); }
+};
+
+struct BlendSubtractOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return qsub8(base, overlay); }
+};
+
+struct BlendDifferenceOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) { return (base > overlay) ? base - overlay : overlay - base; }
+};
+
+struct BlendColorDodgeOp {
+    static inline uint8_t mix(uint8_t base, uint8_t overlay) {
+        if (overlay == 255) return 255;
+        uint16_t v = (base * 255) / (255 - overlay);
+        return (v > 255) ? 255 : v;
+    }
+};
+
+typedef void (*BlendRowFn)(CRGB *out, const CRGB *bg, const CRGB *fg, uint16_t count, CRGB key, uint8_t opacity);
+
+template <class Op, bool Keyed, bool FullOpacity>
+void blendRow(CRGB *out, const CRGB *bg, const CRGB *fg, uint16_t count, CRGB key, uint8_t opacity)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        const CRGB base    = bg[i];
+        const CRGB overlay = fg[i];
+
+        CRGB result(Op::mix(base.r, overlay.r), Op::mix(base.g, overlay.g), Op::mix(base.b, overlay.b));
+
+        if (!FullOpacity) {
+            result.r = blend8(base.r, result.r, opacity);
+            result.g = blend8(base.g, result.g, opacity);
+            result.b = blend8(base.b, result.b, opacity);
+        }
+
+        // Transparent foreground pixels show the background
+        if (Keyed) result = (overlay == key) ? base : result;
+
+        out[i] = result;
+    }
+}
+
+// opacity == 0: the result is always the background
+void keepRow(CRGB *out, const CRGB *bg, const CRGB *fg, uint16_t count, CRGB key, uint8_t opacity)
+{
+    if (out != bg) memmove(out, bg, count * sizeof(CRGB));
+}
+
+template <class Op>
+BlendRowFn selectBlendRow(bool keyed, bool full)
+{
+    if (keyed) return full ? blendRow<Op, true, true>  : blendRow<Op, true, false>;
+    return            full ? blendRow<Op, false, true> : blendRow<Op, false, false>;
+}
+
+BlendRowFn resolveBlendRow(GFX_LayerCompositor::BlendMode mode, bool keyed, uint8_t opacity)
+{
+    if (opacity == 0) return keepRow;
+
+    const bool full = (opacity == 255);
+
+    switch (mode) {
+        case GFX_LayerCompositor::BLEND_MULTIPLY:    return selectBlendRow<BlendMultiplyOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_SCREEN:      return selectBlendRow<BlendScreenOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_OVERLAY:     return selectBlendRow<BlendOverlayOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_DARKEN:      return selectBlendRow<BlendDarkenOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_LIGHTEN:     return selectBlendRow<BlendLightenOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_ADD:         return selectBlendRow<BlendAddOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_SUBTRACT:    return selectBlendRow<BlendSubtractOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_DIFFERENCE:  return selectBlendRow<BlendDifferenceOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_COLOR_DODGE: return selectBlendRow<BlendColorDodgeOp>(keyed, full);
+        case GFX_LayerCompositor::BLEND_NORMAL:
+        default:                                     return selectBlendRow<BlendNormalOp>(keyed, full); // fallback to normal blend
+    }
+}
+
+// Siloette: background where the foreground is opaque, black elsewhere
+void siloetteRow(CRGB *out, const CRGB *bg, const CRGB *fg, uint16_t count, CRGB key)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        out[i] = (fg[i] != key) ? bg[i] : CRGB(0, 0, 0);
+    }
+}
+
+// Mask with a precomputed 8-bit alpha per pixel
+void alphaMaskRow(CRGB *out, const CRGB *bg, const CRGB *fg, const uint8_t *alpha, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        out[i] = blend(bg[i], fg[i], alpha[i]);
+    }
+}
+
+// Mask: the mask's luminance is the alpha of the foreground
+void maskRow(CRGB *out, const CRGB *bg, const CRGB *fg, const CRGB *mask, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t alpha = (mask[i].r + mask[i].g + mask[i].b) / 3;
+        out[i] = blend(bg[i], fg[i], alpha);
+    }
+}
+
+// Spans are handed to the kernels in chunks of at most this many pixels, so a run
+// that crosses a ring-scroll seam can be gathered into a small stack buffer
+const uint16_t SPAN_CHUNK = 64;
+
+// 'count' pixels of row 'cy' of a layer from canvas column 'cx' (canvas coordinates)
+inline const CRGB *canvasRead(GFX_Layer &layer, int32_t cx, int32_t cy, uint16_t count, CRGB *scratch)
+{
+    return layer.sampleRow(cy - layer.getPositionY(), cx - layer.getPositionX(), count, scratch);
+}
+
+inline int32_t clampSpan(int32_t v, int32_t n)
+{
+    return (v < 0) ? 0 : (v > n) ? n : v;
+}
+
+} // namespace
+
+
+CRGB *GFX_LayerCompositor::rowBuffer(uint16_t len)
+{
+    if (len > row_buffer_len) {
+        delete[] row_buffer;
+        row_buffer = new(std::nothrow) CRGB[len];
+        row_buffer_len = row_buffer ? len : 0;
+    }
+    return row_buffer;
+}
+
+template <class Kernel>
+void GFX_LayerCompositor::composite(GFX_Layer &_bgLayer, int32_t ux0, int32_t uy0, int32_t ux1, int32_t uy1,
+                                    const GFX_Surface *dst, bool black_outside, Kernel kernel)
+{
+    // Output rectangle: the background, clipped to the target if there is one
+    int32_t x0 = _bgLayer.getPositionX(), x1 = x0 + _bgLayer.getWidth();
+    int32_t y0 = _bgLayer.getPositionY(), y1 = y0 + _bgLayer.getHeight();
+    if (dst) {
+        x0 = max(x0, (int32_t)dst->x); x1 = min(x1, (int32_t)dst->x + dst->width);
+        y0 = max(y0, (int32_t)dst->y); y1 = min(y1, (int32_t)dst->y + dst->height);
+    }
+    if (x1 <= x0 || y1 <= y0) return;
+
+    const uint16_t width = x1 - x0;
+
+    // Overlap with the upper layer(s); may be empty
+    const int32_t ax0 = max(x0, ux0), ax1 = min(x1, ux1);
+    const bool    has_span = (ax1 > ax0);
+
+    // Rendering into the background itself: rows without overlap are already right
+    const bool in_place = dst && (dst->data == _bgLayer.pixels->contiguous_memory)
+                              && (dst->x == _bgLayer.getPositionX()) && (dst->y == _bgLayer.getPositionY());
+
+    // A fractional background samples the row above and the column to the left, which
+    // rendering in place has already overwritten: its rows are read from copies instead,
+    // and every row changes
+    const bool staged = in_place && (_bgLayer.getSubpixelX() || _bgLayer.getSubpixelY());
+    if (in_place && !black_outside && !staged) {
+        y0 = max(y0, uy0); y1 = min(y1, uy1);
+        if (y1 <= y0) return;
+    }
+
+    const int32_t bx = _bgLayer.getPositionX(), by = _bgLayer.getPositionY();
+
+    // Columns [from,to) of the output row, 'out' pointing at column 'from'.
+    // row / above: copies of the background's rows for a staged render, otherwise null
+    auto renderRow = [&](int32_t cy, CRGB *out, uint16_t from, uint16_t to, const CRGB *row, const CRGB *above) {
+        const bool active = has_span && (cy >= uy0) && (cy < uy1);
+
+        for (uint16_t c = from; c < to; c += SPAN_CHUNK) {
+            const uint16_t n = min((uint16_t)(to - c), SPAN_CHUNK);
+
+            CRGB bg_scratch[SPAN_CHUNK];
+            const CRGB *bg = row ? _bgLayer.sampleRow(cy - by, x0 + c - bx, n, bg_scratch, row, above)
+                                 : canvasRead(_bgLayer, x0 + c, cy, n, bg_scratch);
+            CRGB *o = out + (c - from);
+
+            // Everything the upper layer doesn't cover
+            const int32_t lo = active ? clampSpan(ax0 - (x0 + c), n) : n;
+            const int32_t hi = active ? clampSpan(ax1 - (x0 + c), n) : n;
+            if (black_outside) {
+                for (int32_t i = 0; i < lo; i++) o[i] = CRGB(0, 0, 0);
+                for (int32_t i = hi; i < n; i++) o[i] = CRGB(0, 0, 0);
+            } else if (o != bg) {
+                memmove(o, bg, lo * sizeof(CRGB));
+                memmove(o + hi, bg + hi, (n - hi) * sizeof(CRGB));
+            }
+
+            if (hi > lo) kernel(o + lo, bg + lo, x0 + c + lo, cy, (uint16_t)(hi - lo));
+        }
+    };
+
+    GFX_STATS(render_stats.composited_pixels += (uint32_t)width * (y1 - y0);
+              render_stats.bytes_flushed     += (uint32_t)width * (y1 - y0) * 3);
+
+    if (dst) {
+        const uint16_t rows  = y1 - y0;
+        const uint16_t bw    = _bgLayer.getWidth();
+        const uint8_t  bands = staged ? bandCount(worker_pool, rows) : 1;
+
+        // Staged: two row copies per band, the first holding the row above the band,
+        // taken before any band starts (it belongs to the band before), as blur() does
+        CRGB *copies = nullptr;
+        if (staged) {
+            copies = new(std::nothrow) CRGB[(size_t)bands * 2 * bw];
+            if (!copies) return;
+            for (uint8_t b = 0; b < bands; b++) {
+                const int32_t ly = y0 + GFX_WorkerPool::bandBegin(rows, bands, b) - 1 - by;
+                if (ly >= 0) memcpy(copies + (size_t)b * 2 * bw, _bgLayer.pixels->data[ly], bw * sizeof(CRGB));
+            }
+        }
+
+        // In place, the background's logical columns may wrap round the ring-scroll seam:
+        // at most two runs per row, written through its rows as mapPalette() does
+        const uint16_t start = in_place ? _bgLayer.physicalColumn(x0 - bx) : 0;
+        const uint16_t first = (start + width <= bw) ? width : bw - start;
+
+        // Otherwise rows are independent, so the target can be filled in parallel bands
+        forEachBand(worker_pool, rows, [&](uint16_t begin, uint16_t end, uint8_t band) {
+            CRGB *prev = copies ? copies + (size_t)band * 2 * bw : nullptr;
+            CRGB *cur  = copies ? prev + bw : nullptr;
+            const CRGB *above = (copies && y0 + begin - by > 0) ? prev : nullptr;
+
+            for (int32_t cy = y0 + begin; cy < y0 + end; cy++) {
+                if (copies) memcpy(cur, _bgLayer.pixels->data[cy - by], bw * sizeof(CRGB));
+                if (in_place) {
+                    CRGB *out = _bgLayer.pixels->data[cy - by];
+                    renderRow(cy, out + start, 0, first, cur, above);
+                    renderRow(cy, out, first, width, cur, above);
+                } else {
+                    renderRow(cy, dst->row(cy - dst->y) + (x0 - dst->x), 0, width, cur, above);
+                }
+                if (copies) {
+                    std::swap(prev, cur);
+                    above = prev;
+                }
+            }
+        });
+
+        delete[] copies;
+        return;
+    }
+
+    GFX_STATS(render_stats.callback_calls += (uint32_t)width * (y1 - y0));
+
+    CRGB *out = rowBuffer(width);
+    if (!out) return;
+
+    for (int32_t cy = y0; cy < y1; cy++) {
+        renderRow(cy, out, 0, width, nullptr, nullptr);
+
+        for (int x = 0; x < width; x++) {
+            callback(x0 + x, cy, out[x].r, out[x].g, out[x].b);
+        }
+    }
+}
+
+/*
+	* Display the foreground pixels if they're not the background/transparent color.
+	* If not, then fill with whatever is in the background.
+	* 
+	* writeToBg = write the result back to the _bgLayer, and not directly to the output device!
+	* 			   -> no need to do a subsequent bgLayer.display() otherwise.
+	*/
+void GFX_LayerCompositor::Stack(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, bool writeBackToBg)
+{
+		if (writeBackToBg) {
+			if (!_bgLayer.isInitialized()) return;
+
+			// The background's own memory marks the render as in place, which composite()
+			// writes through the layer's rows: a ring-scrolled layer stays as it is
+			const GFX_Surface bg(_bgLayer.pixels->contiguous_memory, _bgLayer.getWidth(), _bgLayer.getHeight(),
+			                     _bgLayer.getWidth(), _bgLayer.getPositionX(), _bgLayer.getPositionY());
+			stackTo(_bgLayer, _fgLayer, &bg);
+		} else {
+			stackTo(_bgLayer, _fgLayer, nullptr);
+		}
+}
+
+void GFX_LayerCompositor::stackTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface *dst)
+{
+    GFX_PROFILE_CALL("GFX_LayerCompositor::Stack");
+		// Stack always honours the foreground's transparency colour
+		blendTo(_bgLayer, _fgLayer, dst, BLEND_NORMAL, 255, true);
+}  // end stack
+
+
+/*
+	* Where the foreground pixels are not the background/transparent color, populate with 
+	* whatever is in the background.
+	*/
+void GFX_LayerCompositor::Siloette(GFX_Layer &_bgLayer,  GFX_Layer &_fgLayer)
+{
+		siloetteTo(_bgLayer, _fgLayer, nullptr);
+}
+
+void GFX_LayerCompositor::siloetteTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface *dst)
+{
+    GFX_PROFILE_CALL("GFX_LayerCompositor::Siloette");
+		const int32_t fx = _fgLayer.getPositionX(), fy = _fgLayer.getPositionY();
+		const CRGB key = _fgLayer.transparency_colour;
+
+		// Outside the foreground counts as transparent, so it is black too
+		composite(_bgLayer, fx, fy, fx + _fgLayer.getWidth(), fy + _fgLayer.getHeight(), dst, true,
+			[&](CRGB *out, const CRGB *bg, int32_t cx, int32_t cy, uint16_t count) {
+				CRGB fg[SPAN_CHUNK];
+				siloetteRow(out, bg, canvasRead(_fgLayer, cx, cy, count, fg), count, key);
+			});
+}  // end siloette
+
+
+/*
+	* Blend with background if foreground pixel isn't clear/transparent
+	* (set ratio to 127 for a constant 50% / 50% blend)
+	* https://gist.github.com/StefanPetrick/0c0d54d0f35ea9cca983
+	*/
+void GFX_LayerCompositor::Blend(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, uint8_t ratio)
+{
+	blendTo(_bgLayer, _fgLayer, nullptr, BLEND_NORMAL, ratio, true);
+}
+
+void GFX_LayerCompositor::Blend(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst, uint8_t ratio)
+{
+	blendTo(_bgLayer, _fgLayer, &dst, BLEND_NORMAL, ratio, true);
+} // end blend
+
+
+void GFX_LayerCompositor::BlendAdvanced(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, BlendMode mode, uint8_t opacity) {
+    // Skip transparent pixels in foreground layer if transparency is enabled
+    blendTo(_bgLayer, _fgLayer, nullptr, mode, opacity, _fgLayer.transparency_enabled);
+}
+
+void GFX_LayerCompositor::BlendAdvanced(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst, BlendMode mode, uint8_t opacity) {
+    blendTo(_bgLayer, _fgLayer, &dst, mode, opacity, _fgLayer.transparency_enabled);
+}
+
+void GFX_LayerCompositor::AlphaComposite(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, uint8_t alpha) {
+    blendTo(_bgLayer, _fgLayer, nullptr, BLEND_NORMAL, alpha, _fgLayer.transparency_enabled);
+}
+
+void GFX_LayerCompositor::AlphaComposite(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst, uint8_t alpha) {
+    blendTo(_bgLayer, _fgLayer, &dst, BLEND_NORMAL, alpha, _fgLayer.transparency_enabled);
+}
+
+void GFX_LayerCompositor::blendTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface *dst, BlendMode mode, uint8_t opacity, bool keyed) {
+    GFX_PROFILE_CALL("GFX_LayerCompositor::Blend");
+    const int32_t fx = _fgLayer.getPositionX(), fy = _fgLayer.getPositionY();
+    const CRGB key = _fgLayer.transparency_colour;
+
+    // Resolved once per call: each span is then a tight, branch-free loop
+    BlendRowFn kernel = resolveBlendRow(mode, keyed, opacity);
+
+    composite(_bgLayer, fx, fy, fx + _fgLayer.getWidth(), fy + _fgLayer.getHeight(), dst, false,
+        [&](CRGB *out, const CRGB *bg, int32_t cx, int32_t cy, uint16_t count) {
+            CRGB fg[SPAN_CHUNK];
+            kernel(out, bg, canvasRead(_fgLayer, cx, cy, count, fg), count, key, opacity);
+        });
+}
+
+void GFX_LayerCompositor::Mask(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_Layer &_maskLayer) {
+    maskTo(_bgLayer, _fgLayer, _maskLayer, nullptr);
+}
+
+void GFX_LayerCompositor::maskTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_Layer &_maskLayer, const GFX_Surface *dst) {
+    GFX_PROFILE_CALL("GFX_LayerCompositor::Mask");
+    // Only where both the foreground and the mask are present can anything change
+    const int32_t ux0 = max(_fgLayer.getPositionX(), _maskLayer.getPositionX());
+    const int32_t uy0 = max(_fgLayer.getPositionY(), _maskLayer.getPositionY());
+    const int32_t ux1 = min(_fgLayer.getPositionX() + _fgLayer.getWidth(),  _maskLayer.getPositionX() + _maskLayer.getWidth());
+    const int32_t uy1 = min(_fgLayer.getPositionY() + _fgLayer.getHeight(), _maskLayer.getPositionY() + _maskLayer.getHeight());
+
+    composite(_bgLayer, ux0, uy0, ux1, uy1, dst, false,
+        [&](CRGB *out, const CRGB *bg, int32_t cx, int32_t cy, uint16_t count) {
+            CRGB fg[SPAN_CHUNK], mask[SPAN_CHUNK];
+            maskRow(out, bg, canvasRead(_fgLayer, cx, cy, count, fg), canvasRead(_maskLayer, cx, cy, count, mask), count);
+        });
+}
+
+void GFX_LayerCompositor::maskTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_AlphaMask &_mask, const GFX_Surface *dst) {
+    GFX_PROFILE_CALL("GFX_LayerCompositor::Mask");
+    const int32_t ux0 = max(_fgLayer.getPositionX(), _mask.getPositionX());
+    const int32_t uy0 = max(_fgLayer.getPositionY(), _mask.getPositionY());
+    const int32_t ux1 = min(_fgLayer.getPositionX() + _fgLayer.getWidth(),  _mask.getPositionX() + _mask.getWidth());
+    const int32_t uy1 = min(_fgLayer.getPositionY() + _fgLayer.getHeight(), _mask.getPositionY() + _mask.getHeight());
+
+    composite(_bgLayer, ux0, uy0, ux1, uy1, dst, false,
+        [&](CRGB *out, const CRGB *bg, int32_t cx, int32_t cy, uint16_t count) {
+            const uint8_t *alpha = _mask.row(cy - _mask.getPositionY()) + (cx - _mask.getPositionX());
+            CRGB fg[SPAN_CHUNK];
+            alphaMaskRow(out, bg, canvasRead(_fgLayer, cx, cy, count, fg), alpha, count);
+        });
+}
+
+/*
+ * layers[0] is the base; every following layer is blended onto the running
+ * result with its own mode and opacity (modes[0] and opacities[0] are unused).
+ */
+void GFX_LayerCompositor::CompositeMultiple(GFX_Layer* layers[], uint8_t count, BlendMode modes[], uint8_t opacities[]) {
+    compositeMultipleTo(layers, count, modes, opacities, nullptr);
+}
+
+void GFX_LayerCompositor::CompositeMultiple(GFX_Layer* layers[], uint8_t count, BlendMode modes[], uint8_t opacities[], const GFX_Surface &dst) {
+    compositeMultipleTo(layers, count, modes, opacities, &dst);
+}
+
+void GFX_LayerCompositor::compositeMultipleTo(GFX_Layer* layers[], uint8_t count, BlendMode modes[], uint8_t opacities[], const GFX_Surface *dst) {
+    GFX_PROFILE_CALL("GFX_LayerCompositor::CompositeMultiple");
+    if (count == 0) return;
+
+    // Bounding box of the upper layers
+    int32_t ux0 = INT32_MAX, uy0 = INT32_MAX, ux1 = INT32_MIN, uy1 = INT32_MIN;
+    for (uint8_t i = 1; i < count; i++) {
+        ux0 = min(ux0, (int32_t)layers[i]->getPositionX());
+        uy0 = min(uy0, (int32_t)layers[i]->getPositionY());
+        ux1 = max(ux1, (int32_t)layers[i]->getPositionX() + layers[i]->getWidth());
+        uy1 = max(uy1, (int32_t)layers[i]->getPositionY() + layers[i]->getHeight());
+    }
+
+    // The running result is built in the output row, so a target that is also one of
+    // the upper layers has to be composed in a scratch chunk and copied over afterwards
+    bool staged = false;
+    for (uint8_t i = 1; dst && i < count; i++) {
+        if (layers[i]->pixels->contiguous_memory == dst->data) staged = true;
+    }
+
+    auto blendSpan = [&](CRGB *acc, const CRGB *bg, int32_t cx, int32_t cy, uint16_t n) {
+        if (acc != bg) memmove(acc, bg, n * sizeof(CRGB));
+
+        for (uint8_t i = 1; i < count; i++) {
+            GFX_Layer &layer = *layers[i];
+
+            // This layer's part of the span
+            const int32_t lx0 = max(cx, (int32_t)layer.getPositionX());
+            const int32_t lx1 = min(cx + n, (int32_t)layer.getPositionX() + layer.getWidth());
+            if (lx1 <= lx0 || cy < layer.getPositionY() || cy >= layer.getPositionY() + layer.getHeight()) continue;
+
+            CRGB src[SPAN_CHUNK];
+            BlendRowFn kernel = resolveBlendRow(modes[i], layer.transparency_enabled, opacities[i]);
+            kernel(acc + (lx0 - cx), acc + (lx0 - cx), canvasRead(layer, lx0, cy, lx1 - lx0, src), lx1 - lx0, layer.transparency_colour, opacities[i]);
+        }
+    };
+
+    composite(*layers[0], ux0, uy0, ux1, uy1, dst, false,
+        [&](CRGB *out, const CRGB *bg, int32_t cx, int32_t cy, uint16_t n) {
+            if (!staged) {
+                blendSpan(out, bg, cx, cy, n);
+                return;
+            }
+
+            CRGB chunk[SPAN_CHUNK];
+            blendSpan(chunk, bg, cx, cy, n);
+            memcpy(out, chunk, n * sizeof(CRGB));
+        });
+}
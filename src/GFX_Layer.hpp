@@ -21,11 +21,142 @@
 #include <functional>
 #include <new>
 #include "GFX_Lite.h"
+#include "GFX_Lite_optimizations.h"
+#include "GFX_WorkerPool.hpp"
 
 #define BLACK_BACKGROUND_PIXEL_COLOUR CRGB(0,0,0)
 
+class GFX_ColorCurve;
+class GFX_PaletteCache;
+class GFX_ColorMatrix;
+struct GFX_Surface;
+
+/*
+ * 2D affine transform for GFX_Layer::drawAffine(): maps source pixel coordinates
+ * to destination ones. Each call applies its step after the ones before it, e.g.
+ *
+ *   GFX_Affine().translate(-8, -8).rotate(30).scale(2).translate(32, 16)
+ *
+ * spins a 16x16 sprite about its centre, doubles it and centres it on (32,16).
+ */
+struct GFX_Affine {
+    float a = 1, b = 0, c = 0, d = 1;   // dst.x = a*x + b*y + tx
+    float tx = 0, ty = 0;               // dst.y = c*x + d*y + ty
+
+    GFX_Affine &translate(float x, float y);
+    GFX_Affine &rotate(float degrees);  // clockwise on screen (y points down)
+    GFX_Affine &scale(float sx, float sy);
+    GFX_Affine &scale(float s) { return scale(s, s); }
+    GFX_Affine &shear(float kx, float ky);
+
+    // Sampling flags for drawAffine()
+    enum {
+        NEAREST   = 0x00,
+        BILINEAR  = 0x01,
+        COLOR_KEY = 0x02                // skip source pixels of the key colour
+    };
+};
+
 enum textPosition { TOP, MIDDLE, BOTTOM };
 
+/*
+ * Everything GFX_Layer::computeStats() can gather in one pass over the pixels.
+ * Pick what is needed with the flags; the rest is left untouched.
+ */
+struct GFX_LayerStats {
+    enum {
+        HISTOGRAM = 0x01,       // per channel histograms
+        AVERAGE   = 0x02,       // mean colour
+        DOMINANT  = 0x04,       // most common colour, from 4-4-4 bit buckets
+        BOUNDS    = 0x08,       // box around the pixels that aren't the background colour
+        LUMA      = 0x10,       // darkest / brightest luma
+        ALL       = 0x1F
+    };
+
+    uint8_t  flags = 0;                 // what was computed
+    uint32_t count = 0;                 // pixels looked at
+
+    uint32_t histogram[3][256];         // [0] red, [1] green, [2] blue
+    CRGB     average;
+    CRGB     dominant;                  // bucket colour, each 4 bit level expanded to 0..255
+    uint32_t dominant_count = 0;        // pixels in the dominant bucket
+
+    int16_t  min_x, min_y, max_x, max_y;  // inclusive, layer coordinates
+    uint32_t foreground = 0;            // pixels inside the bounds test
+    uint8_t  luma_min, luma_max;
+
+    bool empty() const { return foreground == 0; }  // nothing but background (BOUNDS)
+};
+
+/*
+ * Per-frame work counters, kept by GFX_Layer and GFX_LayerCompositor when the library
+ * is built with GFX_RENDER_STATS=1 (otherwise they cost nothing and read as zero).
+ * A layer counts drawing into it; a compositor counts what it renders and sends out.
+ */
+struct GFX_RenderStats {
+    uint32_t draw_pixel_calls  = 0;     // drawPixel() / setPixel() / drawPixelUnsafe()
+    uint32_t rejected_pixels   = 0;     // drawPixel() calls outside the layer
+    uint32_t fill_pixels       = 0;     // written by fastFillRect(), fastFillScreen(), clear()
+    uint32_t overdraw_pixels   = 0;     // writes to a pixel already written this frame
+    uint32_t composited_pixels = 0;     // compositor output pixels
+    uint32_t callback_calls    = 0;     // pixels handed to the output callback
+    uint32_t bytes_flushed     = 0;     // RGB bytes sent to the callback or written to a surface
+};
+
+/*
+ * One noise field for GFX_Layer::fillNoise8() / fillNoise16(): where it starts, how far
+ * apart neighbouring pixels sample it and how many octaves are summed. The same as the
+ * matching arguments of fill_2dnoise8() / fill_2dnoise16(), including their truncation
+ * to 16 bits (x, y, time) and int16_t (scales) wherever those use the 8-bit noise.
+ *
+ * step > 1 (2, 4 or 8) evaluates the value field of fillNoise16() only every step pixels
+ * and interpolates the rest, as fill_raw_2dnoise16into8_upscaled() does. Worth it for
+ * smooth, large-scale fields; fill_raw_2dnoise16into8_upscale_error() tells how far the
+ * result strays. The other fills ignore it.
+ */
+struct GFX_NoiseField {
+    uint8_t  octaves = 1;
+    uint32_t x       = 0;
+    int32_t  xscale  = 32;
+    uint32_t y       = 0;
+    int32_t  yscale  = 32;
+    uint32_t time    = 0;
+    uint8_t  step    = 1;
+
+    GFX_NoiseField() {}
+    GFX_NoiseField(uint8_t oct, uint32_t nx, int32_t nxscale, uint32_t ny, int32_t nyscale, uint32_t t,
+                   uint8_t nstep = 1)
+        : octaves(oct), x(nx), xscale(nxscale), y(ny), yscale(nyscale), time(t), step(nstep) {}
+};
+
+/*
+ * Working memory for the layer noise fills, two bytes per pixel filled. It grows to the
+ * largest fill it has seen and is then reused, so steady-state frames don't allocate.
+ * One can be shared by layers that are filled one after the other; a layer that isn't
+ * given one keeps its own.
+ */
+class GFX_NoiseScratch
+{
+    public:
+        GFX_NoiseScratch() {}
+        ~GFX_NoiseScratch() { delete[] buffer; }
+
+        GFX_NoiseScratch(const GFX_NoiseScratch &) = delete;
+        GFX_NoiseScratch &operator=(const GFX_NoiseScratch &) = delete;
+
+        // Room for 'count' pixels; false if that much memory isn't available
+        bool reserve(size_t count);
+        void release() { delete[] buffer; buffer = nullptr; pixels = 0; }
+
+        size_t   capacity() const { return pixels; }
+        uint8_t *value()    const { return buffer; }
+        uint8_t *hue()      const { return buffer + pixels; }
+
+    private:
+        uint8_t *buffer = nullptr;
+        size_t   pixels = 0;
+};
+
 /* To help with direct pixel referencing by width and height */
 struct layerPixels {
     CRGB **data;
@@ -102,28 +233,32 @@ class GFX_Layer : public GFX
 
         void drawPixel(int16_t x, int16_t y, CRGB color) {				// overwrite GFX_Lite implementation	
 
-            if( x >= _width 	|| x < 0) return;
-            if( y >= _height 	|| y < 0) return;
-            
-            pixels->data[y][x] = color;
+            GFX_STATS(render_stats.draw_pixel_calls++);
+
+            if( x >= _width 	|| x < 0 || y >= _height 	|| y < 0) {
+                GFX_STATS(render_stats.rejected_pixels++);
+                return;
+            }
+
+            GFX_STATS(countWrite(x, y));
+            pixels->data[y][column(x)] = color;
         }
 
         void setPixel(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b) {
-            if( x >= _width 	|| x < 0) return;
-            if( y >= _height 	|| y < 0) return;
             drawPixel(x,y, CRGB(r,g,b));
         }
 
         // Fast unsafe pixel access for performance-critical operations
         inline void drawPixelUnsafe(int16_t x, int16_t y, CRGB color) __attribute__((always_inline)) {
-            pixels->data[y][x] = color;
+            GFX_STATS(render_stats.draw_pixel_calls++; countWrite(x, y));
+            pixels->data[y][column(x)] = color;
         }
 
         // Get pixel color with bounds checking
         CRGB getPixel(int16_t x, int16_t y) {
             if( x >= _width 	|| x < 0) return CRGB::Black;
             if( y >= _height 	|| y < 0) return CRGB::Black;
-            return pixels->data[y][x];
+            return pixels->data[y][column(x)];
         }
 
         void drawPixel(int16_t x, int16_t y, uint16_t color) {;   		// overwrite GFX_Lite implementation
@@ -145,11 +280,14 @@ class GFX_Layer : public GFX
         void dim(byte value);
         void clear();
         inline void display(bool skip_transparent = false) {   //	flush to display / LED matrix via callbacks, skip transparent for performance reasons
+            GFX_PROFILE_CALL("GFX_Layer::display");
 
             for (int y = 0; y < _height; y++) {
                 for (int x = 0; x < _width; x++) {
-                    if (skip_transparent && pixels->data[y][x] == transparency_colour) continue;
-                    callback(x,y, pixels->data[y][x].r, pixels->data[y][x].g, pixels->data[y][x].b); // send values to callback
+                    const CRGB &px = pixels->data[y][column(x)];
+                    if (skip_transparent && px == transparency_colour) continue;
+                    GFX_STATS(render_stats.callback_calls++; render_stats.bytes_flushed += 3);
+                    callback(pos_x + x, pos_y + y, px.r, px.g, px.b); // send values to callback
             }}
         }
 
@@ -162,10 +300,52 @@ class GFX_Layer : public GFX
 
         inline void setTransparency(bool t) { transparency_enabled = t; }
 
+        // Split the heavier effects (blur, brightness, colour matrix) over a worker pool
+        inline void setWorkerPool(GFX_WorkerPool *pool) { worker_pool = pool; }
+
+        /*
+         * Ring scrolling: scrollX/scrollY (and moveX/moveY) only move the layer's origin
+         * and clear the newly exposed strip, instead of copying every pixel. Reads and
+         * writes through the layer's API, display() and the compositor apply the wrap.
+         * Operations that need plain row-major memory call linearize() first.
+         */
+        void setRingScroll(bool enable);
+        bool isRingScroll() const { return ring_scroll; }
+
+        // Rotate the pixel memory back so that pixels->data[y][x] is logical (x,y) and
+        // rows are contiguous from pixels->contiguous_memory. Cheap when already linear.
+        void linearize();
+        bool isLinear() const { return scroll_x == 0 && (!pixels || pixels->data[0] == pixels->contiguous_memory); }
+
+        // Where logical column x sits in the pixels->data rows
+        inline uint16_t physicalColumn(uint16_t x) const { return column(x); }
+
+        // 'count' logical pixels of row y from column x: a pointer into the layer, or
+        // into 'scratch' when the run crosses the ring-scroll seam.
+        inline const CRGB *readRow(uint16_t y, uint16_t x, uint16_t count, CRGB *scratch) const {
+            CRGB *row = pixels->data[y];
+            uint16_t px = column(x);
+            if (px + count <= _width) return row + px;
+            uint16_t first = _width - px;
+            memcpy(scratch, row + px, first * sizeof(CRGB));
+            memcpy(scratch + first, row, (count - first) * sizeof(CRGB));
+            return scratch;
+        }
+
         // Effects
         void moveX(int delta);
         void autoCenterX();		
         void moveY(int delta);
+
+        /*
+         * Move by a fraction of a pixel: offsets are 8.8 fixed point (256 = one pixel).
+         * The layer is resampled with two-tap lerp8by8() lerps, a row pass then a column
+         * pass; pixels moved in from outside the layer are 'fill'.
+         */
+        void moveSubpixel(int32_t dx_q8, int32_t dy_q8, CRGB fill = BLACK_BACKGROUND_PIXEL_COLOUR);
+
+        // Same, but write the moved image to 'dst' (layer coordinates) and leave this one alone
+        void moveSubpixel(const GFX_Surface &dst, int32_t dx_q8, int32_t dy_q8, CRGB fill = BLACK_BACKGROUND_PIXEL_COLOUR) const;
         
         // Advanced layer operations
         void copyRect(int16_t src_x, int16_t src_y, int16_t dst_x, int16_t dst_y, 
@@ -174,8 +354,34 @@ class GFX_Layer : public GFX
         void scrollY(int16_t pixels, CRGB fill_color = CRGB::Black);
         void flipHorizontal();
         void flipVertical();
-        void rotate90();
+
+        // Quarter turns (clockwise). In place only works for square layers; other sizes
+        // rotate into a 'dst' layer that is height x width. Returns false on a size mismatch.
+        bool rotate90();
+        bool rotate270();
+        void rotate180();
+        bool rotate90(GFX_Layer &dst);
+        bool rotate270(GFX_Layer &dst);
+
+        /*
+         * Draw 'src' (a layer or any CRGB buffer) transformed by 'xf': rotation, scaling,
+         * shear, translation. Steps through the source in 16.16 fixed point along each
+         * destination row, only over the part of the row the source covers.
+         * flags: GFX_Affine::NEAREST or BILINEAR, optionally | COLOR_KEY with 'key'.
+         */
+        void drawAffine(const GFX_Surface &src, const GFX_Affine &xf, uint8_t flags = GFX_Affine::NEAREST,
+                        CRGB key = BLACK_BACKGROUND_PIXEL_COLOUR);
         void blur(uint8_t blur_amount = 64);
+
+        // Separable box blur over (2*radius+1)^2 pixels at O(1) cost per pixel whatever
+        // the radius; edge pixels are repeated outwards. Three passes approximate a
+        // Gaussian. Each pass is mixed with its input by 'amount' (255 = full blur).
+        void boxBlur(uint8_t radius, uint8_t passes = 1, uint8_t amount = 255);
+
+        // FastLED's blur2d / blurRows / blurColumns straight on the layer memory (no XY())
+        void blur2d(fract8 blur_amount);
+        void blurRows(fract8 blur_amount);
+        void blurColumns(fract8 blur_amount);
         
         // Performance optimizations
         void fastFillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB color);
@@ -183,10 +389,61 @@ class GFX_Layer : public GFX
         
         // Color operations
         void adjustBrightness(uint8_t scale);
-        void adjustGamma(float gamma = 2.2f);
+        void adjustGamma(float gamma = 2.2f);           // builds a one-off GFX_ColorCurve
+        void applyCurve(GFX_ColorCurve &curve);         // keep the curve around to reuse its tables
         void applyColorMatrix(const float matrix[3][3]);
+        void applyColorMatrix(const GFX_ColorMatrix &matrix);  // fixed point, with offsets / chained presets
+
+        /*
+         * Colour the layer from a map of palette indices, one table read per pixel: a
+         * width x height map for the whole layer, or a w x h one for the (clipped)
+         * rectangle x,y,w,h. opacity < 255 mixes with what is there, as
+         * map_data_into_colors_through_palette() does. Runs in row bands on the worker pool.
+         */
+        void mapPalette(const uint8_t *indices, GFX_PaletteCache &palette, uint8_t opacity = 255);
+        void mapPalette(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *indices,
+                        GFX_PaletteCache &palette, uint8_t opacity = 255);
         
         // Analysis functions
+        /*
+         * One pass over the layer, or the (clipped) rectangle x,y,w,h of it, filling in
+         * the parts of 'stats' selected by 'flags'. 'background' is what BOUNDS ignores.
+         * Runs in row bands on the worker pool; results don't depend on the thread count.
+         * Returns false if the layer isn't initialized or scratch memory ran out.
+         */
+        bool computeStats(GFX_LayerStats &stats, uint8_t flags = GFX_LayerStats::ALL,
+                          CRGB background = BLACK_BACKGROUND_PIXEL_COLOUR) const;
+        bool computeStats(GFX_LayerStats &stats, int16_t x, int16_t y, int16_t w, int16_t h,
+                          uint8_t flags = GFX_LayerStats::ALL, CRGB background = BLACK_BACKGROUND_PIXEL_COLOUR) const;
+
+        /*
+         * fill_2dnoise8() / fill_2dnoise16() straight into the layer: bit for bit what they
+         * give on a width x height, non-serpentine matrix, or just the (clipped) rectangle
+         * x,y,w,h of that. The noise maps are built in 'scratch' (or the layer's own) rather
+         * than on the stack, in row bands on the worker pool. blend = average with what is
+         * there. Returns false if the layer isn't initialized or scratch memory ran out.
+         */
+        bool fillNoise8(const GFX_NoiseField &value, const GFX_NoiseField &hue, bool blend = false,
+                        GFX_NoiseScratch *scratch = nullptr);
+        bool fillNoise8(int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                        const GFX_NoiseField &hue, bool blend = false, GFX_NoiseScratch *scratch = nullptr);
+        bool fillNoise16(const GFX_NoiseField &value, const GFX_NoiseField &hue, uint16_t hue_shift = 0,
+                         bool blend = false, GFX_NoiseScratch *scratch = nullptr);
+        bool fillNoise16(int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                         const GFX_NoiseField &hue, uint16_t hue_shift = 0, bool blend = false,
+                         GFX_NoiseScratch *scratch = nullptr);
+
+        /*
+         * Animated simplex noise (fill_raw_2dsimplex8() maps): value and hue each at
+         * (x + column * xscale, y + row * yscale, time), octaves 1-8, full saturation.
+         * Cheaper than fillNoise16() for 3D fields and without its grid-aligned look.
+         */
+        bool fillSimplex(const GFX_NoiseField &value, const GFX_NoiseField &hue, uint16_t hue_shift = 0,
+                         bool blend = false, GFX_NoiseScratch *scratch = nullptr);
+        bool fillSimplex(int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                         const GFX_NoiseField &hue, uint16_t hue_shift = 0, bool blend = false,
+                         GFX_NoiseScratch *scratch = nullptr);
+
         CRGB getAverageColor() const;
         CRGB getDominantColor() const;
         uint32_t getPixelCount(CRGB target_color) const;
@@ -201,6 +458,30 @@ class GFX_Layer : public GFX
         // used by the compositor really.
         uint16_t getWidth() { return _width; }
         uint16_t getHeight() { return _height; }
+
+        // Where the layer sits on the compositor's canvas (top-left corner).
+        // Lets small overlays (badges, clocks, toasts) be a fraction of the screen.
+        inline void setPosition(int16_t x, int16_t y) { pos_x = x; pos_y = y; sub_x = sub_y = 0; }
+        int16_t getPositionX() const { return pos_x; }
+        int16_t getPositionY() const { return pos_y; }
+
+        // Position in 8.8 fixed point (256 = one pixel). The fraction isn't a move of the
+        // layer's rectangle: the compositor resamples the content inside it, so leave a
+        // transparent pixel round the edge for the content to slide into.
+        inline void setPositionQ8(int32_t x_q8, int32_t y_q8) {
+            pos_x = (int16_t)(x_q8 >> 8); sub_x = x_q8 & 0xFF;
+            pos_y = (int16_t)(y_q8 >> 8); sub_y = y_q8 & 0xFF;
+        }
+        uint8_t getSubpixelX() const { return sub_x; }
+        uint8_t getSubpixelY() const { return sub_y; }
+
+        // readRow() as the compositor sees it: resampled by the sub-pixel position if any
+        const CRGB *sampleRow(uint16_t y, uint16_t x, uint16_t count, CRGB *scratch) const;
+
+        // Same, with rows y and y-1 taken from copies of the layer's own rows ('above' null
+        // for the top row). For rendering into the layer itself, which overwrites them.
+        const CRGB *sampleRow(uint16_t y, uint16_t x, uint16_t count, CRGB *scratch,
+                              const CRGB *row, const CRGB *above) const;
         
         // Utility functions
         bool isValidCoordinate(int16_t x, int16_t y) const {
@@ -215,6 +496,19 @@ class GFX_Layer : public GFX
             return (pixels != nullptr && pixels->data != nullptr && pixels->contiguous_memory != nullptr);
         }
         
+        /*
+         * Work done on this layer since the last resetRenderStats(): call that at the
+         * start of each frame. Everything reads zero unless built with GFX_RENDER_STATS=1.
+         * Overdraw covers drawPixel() and the fast fills; whole-layer effects aren't counted.
+         */
+#if GFX_RENDER_STATS
+        const GFX_RenderStats &getRenderStats() const { return render_stats; }
+        void resetRenderStats();
+#else
+        const GFX_RenderStats &getRenderStats() const { static const GFX_RenderStats none; return none; }
+        void resetRenderStats() {}
+#endif
+
         // Debug/diagnostic functions
         void printMemoryInfo() const {
             if (!pixels) return;
@@ -227,16 +521,147 @@ class GFX_Layer : public GFX
 	
         uint16_t _width;
         uint16_t _height;
+
+        int16_t  pos_x = 0;
+        int16_t  pos_y = 0;
+        uint8_t  sub_x = 0;         // sub-pixel part of the position, 1/256ths
+        uint8_t  sub_y = 0;
+
+        GFX_WorkerPool *worker_pool = nullptr;
+
+        GFX_NoiseScratch *noise_scratch = nullptr;    // fillNoise8/16 without a caller's scratch
+
+        enum NoiseKind : uint8_t { NOISE_PERLIN8, NOISE_PERLIN16, NOISE_SIMPLEX };
+
+        bool fillNoise(NoiseKind kind, int16_t x, int16_t y, int16_t w, int16_t h, const GFX_NoiseField &value,
+                       const GFX_NoiseField &hue, uint16_t hue_shift, bool blend, GFX_NoiseScratch *scratch);
+
+        bool     ring_scroll = false;
+        uint16_t scroll_x    = 0;   // physical column of logical column 0
+
+        // Physical column of logical column x
+        inline uint16_t column(uint16_t x) const __attribute__((always_inline)) {
+            uint16_t px = x + scroll_x;
+            return (px >= _width) ? px - _width : px;
+        }
 		
     
         // Member variable to store the callback
         std::function<void(int16_t, int16_t, uint8_t, uint8_t, uint8_t)> callback;
+
+#if GFX_RENDER_STATS
+        GFX_RenderStats render_stats;
+        uint8_t        *written = nullptr;      // 1 bit per pixel written this frame, for overdraw
+
+        void countWrite(int16_t x, int16_t y);
+        void countFill(int16_t x, int16_t y, int16_t w, int16_t h);
+#endif
 		
 };
 
 
 
 
+/*
+ * 1 byte per pixel alpha mask for GFX_LayerCompositor::Mask.
+ *
+ * Supports the whole GFX drawing API: anything drawn is stored as its luminance,
+ * (r+g+b)/3, so white text or shapes are fully opaque and black is fully clear.
+ * A third of the memory of a CRGB mask layer, and no per-frame luminance math.
+ */
+class GFX_AlphaMask : public GFX
+{
+    public:
+        GFX_AlphaMask(uint16_t width, uint16_t height);
+        ~GFX_AlphaMask(void) { delete[] alpha; }
+
+        GFX_AlphaMask(const GFX_AlphaMask &) = delete;
+        GFX_AlphaMask &operator=(const GFX_AlphaMask &) = delete;
+
+        void drawPixel(int16_t x, int16_t y, CRGB color) {
+            setAlpha(x, y, (color.r + color.g + color.b) / 3);
+        }
+
+        void drawPixel(int16_t x, int16_t y, uint16_t color) {
+            drawPixel(x, y, color565_to_CRGB(color));
+        }
+
+        void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB color);
+        void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRect(x, y, w, h, color565_to_CRGB(color)); }
+
+        inline void setAlpha(int16_t x, int16_t y, uint8_t a) {
+            if( x >= _width 	|| x < 0) return;
+            if( y >= _height 	|| y < 0) return;
+            alpha[(size_t)y * _width + x] = a;
+        }
+
+        inline uint8_t getAlpha(int16_t x, int16_t y) const {
+            if( x >= _width 	|| x < 0) return 0;
+            if( y >= _height 	|| y < 0) return 0;
+            return alpha[(size_t)y * _width + x];
+        }
+
+        void fillAlpha(uint8_t a);
+        void clear() { fillAlpha(0); }
+
+        // One-time conversion from an existing (luminance) mask layer of any size
+        void fromLuminance(GFX_Layer &layer);
+
+        inline uint8_t *row(uint16_t y) { return alpha + (size_t)y * _width; }
+
+        inline void setPosition(int16_t x, int16_t y) { pos_x = x; pos_y = y; }
+        int16_t  getPositionX() const { return pos_x; }
+        int16_t  getPositionY() const { return pos_y; }
+        uint16_t getWidth()  const { return _width; }
+        uint16_t getHeight() const { return _height; }
+
+        bool   isInitialized() const { return alpha != nullptr; }
+        size_t getMemoryUsage() const { return (size_t)_width * _height; }
+
+    private:
+        uint16_t _width;
+        uint16_t _height;
+        int16_t  pos_x = 0;
+        int16_t  pos_y = 0;
+        uint8_t *alpha = nullptr;
+};
+
+
+/*
+ * A view onto CRGB pixel memory that compositor output can be written to,
+ * instead of going through the per-pixel callback. Rows are 'stride' pixels apart,
+ * and (x,y) is where the buffer's top-left pixel sits on the canvas.
+ */
+struct GFX_Surface {
+    CRGB     *data;
+    uint16_t  width;
+    uint16_t  height;
+    uint16_t  stride;
+    int16_t   x;
+    int16_t   y;
+
+    GFX_Surface(CRGB *buf, uint16_t w, uint16_t h, uint16_t row_stride = 0, int16_t canvas_x = 0, int16_t canvas_y = 0)
+        : data(buf), width(w), height(h), stride(row_stride ? row_stride : w), x(canvas_x), y(canvas_y) {}
+
+    /*
+     * Surfaces need plain row-major memory, so a ring-scrolled layer is linearized
+     * first: a rotation of the whole layer whenever it has scrolled since the last one.
+     * To composite into the background in place, Stack(bg, fg, true) avoids that.
+     */
+    explicit GFX_Surface(GFX_Layer &layer) {
+        layer.linearize();
+        data   = layer.pixels ? layer.pixels->contiguous_memory : nullptr;
+        width  = layer.getWidth();
+        height = layer.getHeight();
+        stride = layer.getWidth();
+        x      = layer.getPositionX();
+        y      = layer.getPositionY();
+    }
+
+    inline CRGB *row(uint16_t y) const { return data + (size_t)y * stride; }
+};
+
+
 /* Merge FastLED layers into a super layer and display. */
 // A class that will take a callback function
 class GFX_LayerCompositor {
@@ -246,19 +671,67 @@ public:
         BLEND_NORMAL,
         BLEND_MULTIPLY,
         BLEND_SCREEN, 
-        BLEND_OVERLAY
+        BLEND_OVERLAY,
+        BLEND_DARKEN,
+        BLEND_LIGHTEN,
+        BLEND_ADD,
+        BLEND_SUBTRACT,
+        BLEND_DIFFERENCE,
+        BLEND_COLOR_DODGE
     };
 
 private:
     std::function<void(int16_t, int16_t, uint8_t, uint8_t, uint8_t)> callback;
-    
-    // Advanced blending function
-    CRGB blendPixels(CRGB base, CRGB overlay, BlendMode mode, uint8_t opacity = 255);
+
+    GFX_WorkerPool *worker_pool = nullptr;
+
+    // One row of composited output, handed to the callback once complete
+    CRGB     *row_buffer     = nullptr;
+    uint16_t  row_buffer_len = 0;
+    CRGB     *rowBuffer(uint16_t len);
+
+#if GFX_RENDER_STATS
+    GFX_RenderStats render_stats;
+#endif
+
+    /*
+     * Walks the rows where the background overlaps the output (the target, or the
+     * whole background for the callback) and hands 'kernel' only the spans that also
+     * overlap the upper rectangle [ux0,ux1) x [uy0,uy1). Elsewhere the background is
+     * passed through (or black when black_outside), and skipped entirely in place.
+     */
+    template <class Kernel>
+    void composite(GFX_Layer &_bgLayer, int32_t ux0, int32_t uy0, int32_t ux1, int32_t uy1,
+                   const GFX_Surface *dst, bool black_outside, Kernel kernel);
+
+    void stackTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface *dst);
+    void siloetteTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface *dst);
+    void blendTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface *dst, BlendMode mode, uint8_t opacity, bool keyed);
+    void maskTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_Layer &_maskLayer, const GFX_Surface *dst);
+    void maskTo(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_AlphaMask &_mask, const GFX_Surface *dst);
+    void compositeMultipleTo(GFX_Layer* layers[], uint8_t count, BlendMode modes[], uint8_t opacities[], const GFX_Surface *dst);
 
 public:
 
     // New constructor
     GFX_LayerCompositor(const std::function<void(int16_t, int16_t, uint8_t, uint8_t, uint8_t)> cb) : callback(cb) {}
+    ~GFX_LayerCompositor() { delete[] row_buffer; }
+
+    GFX_LayerCompositor(const GFX_LayerCompositor &) = delete;
+    GFX_LayerCompositor &operator=(const GFX_LayerCompositor &) = delete;
+
+    // Split GFX_Surface targets into row bands over a worker pool.
+    // Callback output always runs on the calling thread, in row order.
+    inline void setWorkerPool(GFX_WorkerPool *pool) { worker_pool = pool; }
+
+    // Pixels composited and sent out since the last reset (GFX_RENDER_STATS=1 builds)
+#if GFX_RENDER_STATS
+    const GFX_RenderStats &getRenderStats() const { return render_stats; }
+    void resetRenderStats() { render_stats = GFX_RenderStats(); }
+#else
+    const GFX_RenderStats &getRenderStats() const { static const GFX_RenderStats none; return none; }
+    void resetRenderStats() {}
+#endif
 
     void Stack(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, bool writeToBgLayer = false);
     void Siloette(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer);
@@ -267,10 +740,30 @@ public:
     // Advanced compositing methods
     void BlendAdvanced(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, BlendMode mode, uint8_t opacity = 255);
     void Mask(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_Layer &_maskLayer);
+    void Mask(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_AlphaMask &_mask) { maskTo(_bgLayer, _fgLayer, _mask, nullptr); }
     void AlphaComposite(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, uint8_t alpha);
     
-    // Multi-layer compositing (up to 4 layers)
+    /*
+     * Multi-layer compositing: layers[0] is the base and sets the output area,
+     * layers[1..count-1] are blended over it in order, each wherever it is positioned,
+     * with modes[i] / opacities[i]. modes[0] and opacities[0] are not used.
+     */
     void CompositeMultiple(GFX_Layer* layers[], uint8_t count, BlendMode modes[], uint8_t opacities[]);
+
+    /*
+     * Render-to-surface variants: the result is written into 'dst' (another layer,
+     * or any CRGB buffer) rather than sent to the callback. 'dst' may be the
+     * background layer itself to composite in place, though Stack(bg, fg, true)
+     * does that without linearizing a ring-scrolled background.
+     */
+    void Stack(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst)                 { stackTo(_bgLayer, _fgLayer, &dst); }
+    void Siloette(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst)              { siloetteTo(_bgLayer, _fgLayer, &dst); }
+    void Blend(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst, uint8_t ratio = 127);
+    void BlendAdvanced(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst, BlendMode mode, uint8_t opacity = 255);
+    void Mask(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_Layer &_maskLayer, const GFX_Surface &dst) { maskTo(_bgLayer, _fgLayer, _maskLayer, &dst); }
+    void Mask(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, GFX_AlphaMask &_mask, const GFX_Surface &dst)     { maskTo(_bgLayer, _fgLayer, _mask, &dst); }
+    void AlphaComposite(GFX_Layer &_bgLayer, GFX_Layer &_fgLayer, const GFX_Surface &dst, uint8_t alpha);
+    void CompositeMultiple(GFX_Layer* layers[], uint8_t count, BlendMode modes[], uint8_t opacities[], const GFX_Surface &dst);
 };
 
 
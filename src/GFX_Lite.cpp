@@ -32,6 +32,7 @@
 */
 
 #include "GFX_Lite.h"
+#include "GFX_Lite_optimizations.h"
 #include "glcdfont.c"
 #ifdef __AVR__
 #include <avr/pgmspace.h>
@@ -132,6 +133,7 @@ GFX::GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h)
 /**************************************************************************/
 void GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB color)
 {
+  GFX_PROFILE_PRIMITIVE("GFX::fillRect");
   // Bounds checking and clipping
   if (x >= _width || y >= _height) return;
   if (x + w < 0 || y + h < 0) return;
@@ -155,6 +157,7 @@ void GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, CRGB color)
 
 void GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
+  GFX_PROFILE_PRIMITIVE("GFX::fillRect");
   // Bounds checking and clipping
   if (x >= _width || y >= _height) return;
   if (x + w < 0 || y + h < 0) return;
@@ -205,6 +208,7 @@ void GFX::fillScreen(uint16_t color)
 template<typename T>
 void GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, T color)
 {
+  GFX_PROFILE_PRIMITIVE("GFX::drawLine");
   if (x0 == x1) 
   {
     if (y0 > y1) _swap_int16_t(y0, y1);
@@ -276,6 +280,7 @@ template void GFX::drawLine<uint16_t>(int16_t x0, int16_t y0, int16_t x1, int16_
 template<typename T>
 void GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, T color)
 {
+  GFX_PROFILE_CALL("GFX::drawCircle");
 #if defined(ESP8266)
   yield();
 #endif
@@ -382,6 +387,7 @@ template void GFX::drawCircleHelper<uint16_t>(int16_t x0, int16_t y0, int16_t r,
 template<typename T>
 void GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, T color) 
 {
+  GFX_PROFILE_CALL("GFX::fillCircle");
   fillRect(x0, y0 - r, 1, 2 * r + 1, color);
   fillCircleHelper(x0, y0, r, 3, 0, color);
 }
@@ -460,6 +466,7 @@ template void GFX::fillCircleHelper<uint16_t>(int16_t x0, int16_t y0, int16_t r,
 template<typename T>
 void GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, T color) 
 {
+  GFX_PROFILE_CALL("GFX::drawRect");
   fillRect(x, y, w, 1, color);
   fillRect(x, y + h - 1, w, 1, color);
   fillRect(x, y, 1, h, color);
@@ -485,6 +492,7 @@ template void GFX::drawRect<uint16_t>(int16_t x, int16_t y, int16_t w, int16_t h
 template<typename T>
 void GFX::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, T color) 
 {
+  GFX_PROFILE_CALL("GFX::drawRoundRect");
   int16_t max_radius = ((w < h) ? w : h) / 2; // 1/2 minor axis
   if (r > max_radius) r = max_radius;
   // smarter version
@@ -517,6 +525,7 @@ template void GFX::drawRoundRect<uint16_t>(int16_t x, int16_t y, int16_t w, int1
 template<typename T>
 void GFX::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, T color) 
 {
+  GFX_PROFILE_CALL("GFX::fillRoundRect");
   int16_t max_radius = ((w < h) ? w : h) / 2; // 1/2 minor axis
   if (r > max_radius) r = max_radius;
   // smarter version
@@ -546,6 +555,7 @@ template void GFX::fillRoundRect<uint16_t>(int16_t x, int16_t y, int16_t w, int1
 template<typename T>
 void GFX::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, T color) 
 {
+  GFX_PROFILE_CALL("GFX::drawTriangle");
   drawLine(x0, y0, x1, y1, color);
   drawLine(x1, y1, x2, y2, color);
   drawLine(x2, y2, x0, y0, color);
@@ -571,6 +581,7 @@ template void GFX::drawTriangle<uint16_t>(int16_t x0, int16_t y0, int16_t x1, in
 template<typename T>
 void GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, T color) 
 {
+  GFX_PROFILE_CALL("GFX::fillTriangle");
 
   int16_t a, b, y, last;
 
@@ -673,6 +684,7 @@ template void GFX::fillTriangle<uint16_t>(int16_t x0, int16_t y0, int16_t x1, in
 template<typename T>
 void GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, T color) 
 {
+  GFX_PROFILE_CALL("GFX::drawBitmap");
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t byte = 0;
@@ -711,6 +723,7 @@ template void GFX::drawBitmap<uint16_t>(int16_t x, int16_t y, const uint8_t bitm
 template<typename T>
 void GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, T color, T bg) 
 {
+  GFX_PROFILE_CALL("GFX::drawBitmap");
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t byte = 0;
@@ -744,6 +757,7 @@ template void GFX::drawBitmap<uint16_t> (int16_t x, int16_t y, const uint8_t bit
 template<typename T>
 void GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, T color) 
 {
+  GFX_PROFILE_CALL("GFX::drawBitmap");
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t byte = 0;
@@ -782,6 +796,7 @@ template void GFX::drawBitmap<uint16_t> (int16_t x, int16_t y, uint8_t *bitmap,
 template<typename T>
 void GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, T color, T bg) 
 {
+  GFX_PROFILE_CALL("GFX::drawBitmap");
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t byte = 0;
@@ -818,6 +833,7 @@ template void GFX::drawBitmap<uint16_t> (int16_t x, int16_t y, uint8_t *bitmap,
 template<typename T>
 void GFX::drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, T color) 
 {
+  GFX_PROFILE_CALL("GFX::drawXBitmap");
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t byte = 0;
@@ -854,6 +870,7 @@ template void GFX::drawXBitmap<uint16_t> (int16_t x, int16_t y, const uint8_t bi
 /**************************************************************************/
 void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawGrayscaleBitmap");
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
       drawPixel(x + i, y, (uint8_t)pgm_read_byte(&bitmap[j * w + i]));
@@ -875,6 +892,7 @@ void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int1
 /**************************************************************************/
 void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawGrayscaleBitmap");
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
       drawPixel(x + i, y, bitmap[j * w + i]);
@@ -899,6 +917,7 @@ void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
 /**************************************************************************/
 void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, const uint8_t bitmap[], const uint8_t mask[], int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawGrayscaleBitmap");
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t byte = 0;
   for (int16_t j = 0; j < h; j++, y++) {
@@ -931,6 +950,7 @@ void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, const uint8_t bitmap[], cons
 /**************************************************************************/
 void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap, uint8_t *mask, int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawGrayscaleBitmap");
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t byte = 0;
   for (int16_t j = 0; j < h; j++, y++) {
@@ -959,6 +979,7 @@ void GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap, uint8_t *ma
 /**************************************************************************/
 void GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[], int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawRGBBitmap");
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
       drawPixel(x + i, y, pgm_read_word(&bitmap[j * w + i]));
@@ -979,6 +1000,7 @@ void GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[], int16_t w
 /**************************************************************************/
 void GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawRGBBitmap");
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
       drawPixel(x + i, y, bitmap[j * w + i]);
@@ -1002,6 +1024,7 @@ void GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16
 /**************************************************************************/
 void GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[], const uint8_t mask[], int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawRGBBitmap");
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t byte = 0;
   for (int16_t j = 0; j < h; j++, y++) {
@@ -1033,6 +1056,7 @@ void GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[], const uin
 /**************************************************************************/
 void GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, uint8_t *mask, int16_t w, int16_t h) 
 {
+  GFX_PROFILE_CALL("GFX::drawRGBBitmap");
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t byte = 0;
   for (int16_t j = 0; j < h; j++, y++) {
@@ -1084,6 +1108,7 @@ void GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16
 /**************************************************************************/
 void GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y) 
 {
+  GFX_PROFILE_PRIMITIVE("GFX::drawChar");
 
   if (!gfxFont) { // 'Classic' built-in font
 
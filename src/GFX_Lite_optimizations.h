@@ -97,6 +97,66 @@
   #define GFX_DUAL_CORE_AVAILABLE 0
 #endif
 
+// Worker pool backend for row-parallel layer / compositor work (GFX_WorkerPool.hpp)
+#if GFX_DUAL_CORE_AVAILABLE
+  #define GFX_WORKER_POOL_FREERTOS   1
+  #define GFX_WORKER_POOL_STD_THREAD 0
+#elif defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+  #define GFX_WORKER_POOL_FREERTOS   0
+  #define GFX_WORKER_POOL_STD_THREAD 1
+#else
+  #define GFX_WORKER_POOL_FREERTOS   0
+  #define GFX_WORKER_POOL_STD_THREAD 0
+#endif
+
+// SIMD row kernels (GFX_ColorMatrix); define GFX_DISABLE_SIMD to force the portable code
+#if !defined(GFX_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define GFX_SIMD_SSE2 1
+#else
+  #define GFX_SIMD_SSE2 0
+#endif
+
+#if !defined(GFX_DISABLE_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+  #define GFX_SIMD_NEON 1
+#else
+  #define GFX_SIMD_NEON 0
+#endif
+
+// Render counters on GFX_Layer / GFX_LayerCompositor (GFX_RenderStats). Off by default:
+// build with -DGFX_RENDER_STATS=1 to find out where a frame's time goes.
+#ifndef GFX_RENDER_STATS
+  #define GFX_RENDER_STATS 0
+#endif
+
+#if GFX_RENDER_STATS
+  #define GFX_STATS(statement) do { statement; } while (0)
+#else
+  #define GFX_STATS(statement) do { } while (0)
+#endif
+
+// Scoped timing spans (GFX_Profiler.hpp). Off by default: build with -DGFX_PROFILE=1.
+// GFX_PROFILE_SCOPE is for application code (a frame, a scene). The library marks its
+// entry points with GFX_PROFILE_CALL, and its building blocks (fillRect, drawLine, ...)
+// with GFX_PROFILE_PRIMITIVE, which only get a span of their own when not called from
+// inside another library call.
+#ifndef GFX_PROFILE
+  #define GFX_PROFILE 0
+#endif
+
+#if GFX_PROFILE
+  #define GFX_PROFILE_CONCAT_(a, b)   a##b
+  #define GFX_PROFILE_CONCAT(a, b)    GFX_PROFILE_CONCAT_(a, b)
+  #define GFX_PROFILE_SPAN_(name, kind) \
+    GFX_ProfileScope GFX_PROFILE_CONCAT(gfx_profile_scope_, __LINE__)(name, GFX_ProfileScope::kind)
+  #define GFX_PROFILE_SCOPE(name)     GFX_PROFILE_SPAN_(name, USER)
+  #define GFX_PROFILE_CALL(name)      GFX_PROFILE_SPAN_(name, CALL)
+  #define GFX_PROFILE_PRIMITIVE(name) GFX_PROFILE_SPAN_(name, PRIMITIVE)
+#else
+  #define GFX_PROFILE_SCOPE(name)     do { } while (0)
+  #define GFX_PROFILE_CALL(name)      do { } while (0)
+  #define GFX_PROFILE_PRIMITIVE(name) do { } while (0)
+#endif
+
 // Memory management optimizations
 #define GFX_SMALL_MEMORY_DEVICE (defined(__AVR__) || defined(ESP8266))
 
@@ -109,4 +169,8 @@
   #define GFX_USE_PROGMEM_TABLES 0
 #endif
 
+#if GFX_PROFILE
+  #include "GFX_Profiler.hpp"
+#endif
+
 #endif // _GFX_LITE_OPTIMIZATIONS_H_
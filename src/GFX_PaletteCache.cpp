@@ -0,0 +1,117 @@
+/**
+ * Palette lookup table with blend type and brightness baked in, see GFX_PaletteCache.hpp
+ */
+
+#include "GFX_PaletteCache.hpp"
+#include <string.h>
+
+void GFX_PaletteCache::setEntries(Kind new_kind, const CRGB *entries, uint16_t count, TBlendType new_blend)
+{
+    if (kind == new_kind && blend == new_blend && memcmp(source, entries, count * sizeof(CRGB)) == 0) return;
+
+    memcpy(source, entries, count * sizeof(CRGB));
+    kind    = new_kind;
+    blend   = new_blend;
+    progmem = nullptr;
+    dirty   = true;
+}
+
+void GFX_PaletteCache::setPalette(const CRGBPalette16 &pal, TBlendType blend)
+{
+    setEntries(RGB16, pal.entries, 16, blend);
+}
+
+void GFX_PaletteCache::setPalette(const CRGBPalette32 &pal, TBlendType blend)
+{
+    setEntries(RGB32, pal.entries, 32, blend);
+}
+
+void GFX_PaletteCache::setPalette(const CRGBPalette256 &pal, TBlendType blend)
+{
+    setEntries(RGB256, pal.entries, 256, blend);
+}
+
+void GFX_PaletteCache::setPalette(const TProgmemRGBPalette16 &pal, TBlendType new_blend)
+{
+    if (kind == PROGMEM16 && progmem == &pal && blend == new_blend) return;
+    kind    = PROGMEM16;
+    progmem = &pal;
+    blend   = new_blend;
+    dirty   = true;
+}
+
+void GFX_PaletteCache::setPalette(const TProgmemRGBPalette32 &pal, TBlendType new_blend)
+{
+    if (kind == PROGMEM32 && progmem == &pal && blend == new_blend) return;
+    kind    = PROGMEM32;
+    progmem = &pal;
+    blend   = new_blend;
+    dirty   = true;
+}
+
+void GFX_PaletteCache::setBrightness(uint8_t new_brightness)
+{
+    if (brightness == new_brightness) return;
+    brightness = new_brightness;
+    dirty = true;
+}
+
+void GFX_PaletteCache::update()
+{
+    if (!dirty) return;
+
+    // The palette classes are rebuilt from the copied entries only as needed, on the
+    // stack, so the cache itself stays one table and one copy of the source
+    switch (kind) {
+        case RGB16: {
+            CRGBPalette16 pal;
+            memcpy(pal.entries, source, sizeof(pal.entries));
+            for (int i = 0; i < 256; i++) lut[i] = ColorFromPalette(pal, (uint8_t)i, brightness, blend);
+            break;
+        }
+        case RGB32: {
+            CRGBPalette32 pal;
+            memcpy(pal.entries, source, sizeof(pal.entries));
+            for (int i = 0; i < 256; i++) lut[i] = ColorFromPalette(pal, (uint8_t)i, brightness, blend);
+            break;
+        }
+        case RGB256: {
+            CRGBPalette256 pal;
+            memcpy(pal.entries, source, sizeof(pal.entries));
+            for (int i = 0; i < 256; i++) lut[i] = ColorFromPalette(pal, (uint8_t)i, brightness, blend);
+            break;
+        }
+        case PROGMEM16: {
+            const TProgmemRGBPalette16 &pal = *(const TProgmemRGBPalette16 *)progmem;
+            for (int i = 0; i < 256; i++) lut[i] = ColorFromPalette(pal, (uint8_t)i, brightness, blend);
+            break;
+        }
+        case PROGMEM32: {
+            const TProgmemRGBPalette32 &pal = *(const TProgmemRGBPalette32 *)progmem;
+            for (int i = 0; i < 256; i++) lut[i] = ColorFromPalette(pal, (uint8_t)i, brightness, blend);
+            break;
+        }
+        default:
+            memset(lut, 0, sizeof(lut));
+            break;
+    }
+
+    dirty = false;
+}
+
+void GFX_PaletteCache::map(const uint8_t *indices, CRGB *leds, size_t count, uint8_t opacity) const
+{
+    if (opacity == 255) {
+        for (size_t i = 0; i < count; i++) leds[i] = lut[indices[i]];
+        return;
+    }
+
+    // As map_data_into_colors_through_palette(), including its 256 - opacity
+    const uint8_t keep = 256 - opacity;
+    for (size_t i = 0; i < count; i++) {
+        CRGB rgb = lut[indices[i]];
+        leds[i].nscale8(keep);
+        rgb.nscale8_video(opacity);
+        leds[i] += rgb;
+    }
+}
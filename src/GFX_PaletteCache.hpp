@@ -0,0 +1,71 @@
+/**
+ * A palette expanded into a 256 entry CRGB table, with the blend type and brightness
+ * baked in, so mapping palette indices to colours costs one table read per pixel
+ * instead of a ColorFromPalette() call.
+ *
+ * The table is rebuilt lazily, on the first apply() after a setter changed something.
+ * Setting the same palette again is a no-op, so a palette that is being cross-faded
+ * with nblendPaletteTowardPalette() can simply be set every frame.
+ *
+ * Requires GFX_Lite
+ */
+
+#ifndef GFX_PALETTE_CACHE_HPP
+#define GFX_PALETTE_CACHE_HPP
+
+#include "GFX_Lite.h"
+
+class GFX_PaletteCache
+{
+    public:
+        GFX_PaletteCache() {}
+
+        // The palette is copied; same defaults as ColorFromPalette()
+        void setPalette(const CRGBPalette16 &pal, TBlendType blend = LINEARBLEND);
+        void setPalette(const CRGBPalette32 &pal, TBlendType blend = LINEARBLEND);
+        void setPalette(const CRGBPalette256 &pal, TBlendType blend = NOBLEND);
+
+        // PROGMEM palettes are read in place, so must stay where they are
+        void setPalette(const TProgmemRGBPalette16 &pal, TBlendType blend = LINEARBLEND);
+        void setPalette(const TProgmemRGBPalette32 &pal, TBlendType blend = LINEARBLEND);
+
+        void setBrightness(uint8_t brightness);
+        uint8_t getBrightness() const { return brightness; }
+
+        // Rebuild the table if anything changed. apply() does this itself.
+        void update();
+
+        // Colour for one index, same as ColorFromPalette(pal, index, brightness, blend)
+        CRGB apply(uint8_t index) { update(); return lut[index]; }
+
+        /*
+         * Map 'count' palette indices to colours. opacity < 255 mixes them into what is
+         * in 'leds' the way map_data_into_colors_through_palette() does.
+         */
+        void apply(const uint8_t *indices, CRGB *leds, size_t count, uint8_t opacity = 255) {
+            update();
+            map(indices, leds, count, opacity);
+        }
+
+        // Map with the table as it is, without checking for changes. Safe to call from
+        // several threads at once after update().
+        void map(const uint8_t *indices, CRGB *leds, size_t count, uint8_t opacity = 255) const;
+
+        // The 256 colours, current after update()
+        const CRGB *table() const { return lut; }
+
+    private:
+        enum Kind : uint8_t { NONE, RGB16, RGB32, RGB256, PROGMEM16, PROGMEM32 };
+
+        void setEntries(Kind kind, const CRGB *entries, uint16_t count, TBlendType blend);
+
+        CRGB        source[256];
+        const void *progmem = nullptr;
+        Kind        kind    = NONE;
+        TBlendType  blend   = LINEARBLEND;
+        uint8_t     brightness = 255;
+        bool        dirty   = true;
+        CRGB        lut[256];
+};
+
+#endif
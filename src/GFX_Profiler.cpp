@@ -0,0 +1,153 @@
+/**
+ * Scoped timing spans and Chrome trace export, see GFX_Profiler.hpp
+ */
+
+#include "GFX_Profiler.hpp"
+
+#if GFX_PROFILE
+
+#include <atomic>
+#include <stdio.h>
+#include "Arduino.h"
+
+#if defined(ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+#elif (defined(__x86_64__) || defined(__i386__) || defined(_M_X64)) && (defined(__linux__) || defined(__APPLE__))
+  #include <time.h>
+#endif
+
+namespace {
+
+struct Span {
+    const char *name;
+    uint64_t    start;
+    uint64_t    end;
+    uint32_t    thread;
+};
+
+static_assert((GFX_PROFILE_EVENTS & (GFX_PROFILE_EVENTS - 1)) == 0, "GFX_PROFILE_EVENTS must be a power of two");
+
+Span                  ring[GFX_PROFILE_EVENTS];
+std::atomic<uint32_t> next_slot(0);
+uint64_t              epoch = GFX_Profiler::now();
+
+uint32_t threadId()
+{
+#if defined(ESP32)
+    return xPortGetCoreID();
+#else
+    static std::atomic<uint32_t> threads(0);
+    static thread_local uint32_t id = threads++;
+    return id;
+#endif
+}
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64)) && (defined(__linux__) || defined(__APPLE__))
+uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// The TSC rate isn't published, so it is measured against the monotonic clock
+const uint64_t tsc_epoch = __rdtsc();
+const uint64_t ns_epoch  = monotonicNs();
+#endif
+
+// JSON string body; span names are literals, but quotes and backslashes are escaped anyway
+size_t writeEscaped(Print &out, const char *s)
+{
+    size_t n = 0;
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\') n += out.write('\\');
+        n += out.write((uint8_t)((uint8_t)*s < 0x20 ? ' ' : *s));
+    }
+    return n;
+}
+
+} // namespace
+
+uint64_t GFX_Profiler::nowFallback()
+{
+    return micros();
+}
+
+double GFX_Profiler::ticksPerMicrosecond()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  #if defined(__linux__) || defined(__APPLE__)
+    // Take at least 10 ms of both clocks for a stable ratio
+    uint64_t ns = monotonicNs() - ns_epoch;
+    while (ns < 10000000u) ns = monotonicNs() - ns_epoch;
+    return (double)(__rdtsc() - tsc_epoch) * 1000.0 / ns;
+  #else
+    static double rate = 0;
+    if (rate == 0) {
+        const uint64_t t0 = __rdtsc(), us0 = micros();
+        while (micros() - us0 < 10000) {}
+        rate = (double)(__rdtsc() - t0) / (micros() - us0);
+    }
+    return rate;
+  #endif
+#elif defined(__aarch64__)
+    uint64_t hz;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(hz));
+    return hz / 1e6;
+#elif defined(ESP32)
+    return 1.0;
+#elif defined(__linux__) || defined(__APPLE__)
+    return 1000.0;
+#else
+    return 1.0;
+#endif
+}
+
+void GFX_Profiler::record(const char *name, uint64_t start, uint64_t end)
+{
+    Span &span  = ring[next_slot.fetch_add(1, std::memory_order_relaxed) & (GFX_PROFILE_EVENTS - 1)];
+    span.name   = name;
+    span.start  = start;
+    span.end    = end;
+    span.thread = threadId();
+}
+
+void GFX_Profiler::clear()
+{
+    next_slot.store(0, std::memory_order_relaxed);
+    epoch = now();
+}
+
+uint32_t GFX_Profiler::count()
+{
+    const uint32_t n = next_slot.load(std::memory_order_relaxed);
+    return (n < GFX_PROFILE_EVENTS) ? n : GFX_PROFILE_EVENTS;
+}
+
+size_t GFX_Profiler::writeChromeTrace(Print &out)
+{
+    const uint32_t end   = next_slot.load(std::memory_order_acquire);
+    const uint32_t held  = count();
+    const double   scale = 1.0 / ticksPerMicrosecond();
+
+    size_t n = out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    for (uint32_t i = end - held; i != end; i++) {
+        const Span &span = ring[i & (GFX_PROFILE_EVENTS - 1)];
+        if (span.start < epoch) continue;               // from before a clear()
+
+        char times[96];
+        snprintf(times, sizeof(times), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+                 (span.start - epoch) * scale, (span.end - span.start) * scale, (unsigned)span.thread);
+
+        n += out.print(first ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+        first = false;
+        n += writeEscaped(out, span.name);
+        n += out.print(times);
+    }
+    n += out.print("\n]}\n");
+    return n;
+}
+
+#endif // GFX_PROFILE
@@ -0,0 +1,128 @@
+/**
+ * Scoped timing spans, exported as Chrome trace events.
+ *
+ * Build with GFX_PROFILE=1 and the library's main entry points (primitives, text,
+ * layer effects, compositor calls, noise fills) each record a span into a fixed ring
+ * buffer; wrap your own frame in GFX_PROFILE_SCOPE("frame") to group them. Dump the
+ * ring with writeChromeTrace() and open the output in chrome://tracing or Perfetto
+ * for a per-frame flame view. Without GFX_PROFILE the macros compile to nothing.
+ *
+ * Timestamps come from the cheapest clock with a known rate: the TSC on x86, the
+ * generic timer on 64-bit ARM, esp_timer on ESP32 (the two cores' cycle counters
+ * aren't in step), clock_gettime() on other hosts, micros() elsewhere.
+ *
+ * Recording is lock-free: each span claims a slot with one atomic increment, so any
+ * thread (worker pool bands included) can record. Dump while nothing is drawing,
+ * e.g. between frames; the oldest spans are overwritten once the ring is full.
+ */
+
+#ifndef GFX_PROFILER_HPP
+#define GFX_PROFILER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include "GFX_Lite_optimizations.h"
+
+#if GFX_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  #include <x86intrin.h>
+#elif defined(ESP32)
+  #include <esp_timer.h>
+#elif !defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__))
+  #include <time.h>
+#endif
+
+class Print;
+
+// Ring size in spans, a power of two
+#ifndef GFX_PROFILE_EVENTS
+  #if defined(ESP32)
+    #define GFX_PROFILE_EVENTS 1024
+  #else
+    #define GFX_PROFILE_EVENTS 16384
+  #endif
+#endif
+
+class GFX_Profiler
+{
+    public:
+        // Raw clock ticks; see ticksPerMicrosecond()
+        static inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+            return __rdtsc();
+#elif defined(__aarch64__)
+            uint64_t t;
+            __asm__ volatile("mrs %0, cntvct_el0" : "=r"(t));
+            return t;
+#elif defined(ESP32)
+            return (uint64_t)esp_timer_get_time();
+#elif defined(__linux__) || defined(__APPLE__)
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#else
+            return nowFallback();
+#endif
+        }
+
+        static double ticksPerMicrosecond();
+
+        static void record(const char *name, uint64_t start, uint64_t end);
+
+        // Forget everything recorded so far
+        static void clear();
+
+        // Spans currently held (at most GFX_PROFILE_EVENTS)
+        static uint32_t count();
+
+        /*
+         * Write the held spans, oldest first, as a Chrome trace-event JSON object.
+         * Times are in microseconds from the last clear() (or program start).
+         * Returns the number of bytes written.
+         */
+        static size_t writeChromeTrace(Print &out);
+
+        // Library calls (CALL / PRIMITIVE spans) open on the calling thread
+        static inline uint8_t &depth() {
+            static thread_local uint8_t open_spans = 0;
+            return open_spans;
+        }
+
+    private:
+        static uint64_t nowFallback();
+};
+
+class GFX_ProfileScope
+{
+    public:
+        enum Kind : uint8_t {
+            USER,       // always recorded, doesn't hide anything beneath it
+            CALL,       // library entry point: always recorded, hides nested primitives
+            PRIMITIVE   // building block: recorded only outside any CALL / PRIMITIVE
+        };
+
+        GFX_ProfileScope(const char *span_name, Kind kind)
+            : name(span_name), active(kind != PRIMITIVE || GFX_Profiler::depth() == 0),
+              nested(kind != USER), start(GFX_Profiler::now()) {
+            if (nested) GFX_Profiler::depth()++;
+        }
+
+        ~GFX_ProfileScope() {
+            if (nested) GFX_Profiler::depth()--;
+            if (active) GFX_Profiler::record(name, start, GFX_Profiler::now());
+        }
+
+        GFX_ProfileScope(const GFX_ProfileScope &) = delete;
+        GFX_ProfileScope &operator=(const GFX_ProfileScope &) = delete;
+
+    private:
+        const char *name;
+        bool        active;
+        bool        nested;
+        uint64_t    start;
+};
+
+#endif // GFX_PROFILE
+
+#endif
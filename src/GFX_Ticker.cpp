@@ -0,0 +1,217 @@
+/**
+ * Scrolling text ticker / marquee, see GFX_Ticker.hpp
+ */
+
+#include "GFX_Ticker.hpp"
+#include <string.h>
+
+GFX_Ticker::GFX_Ticker(uint16_t width, const GFXfont *font, uint8_t size)
+    : GFX(width, 8), window_width(width ? width : 1)
+{
+    setFont(font);
+    setTextSize(size ? size : 1);
+    setTextWrap(false);
+    measureFont();
+
+    // Anything a glyph draws past the window has to fit in the ring as well
+    strip_width = window_width + 2 * (glyph_right - glyph_left) + 1;
+    // GFX clips fillRect() (text size > 1) to _width, so let glyphs run one ring past the
+    // end and fold them back in drawPixel()
+    _width  = 2 * strip_width;
+    _height = strip_height;
+
+    strip = new(std::nothrow) CRGB[(size_t)strip_width * strip_height];
+    restart();
+}
+
+GFX_Ticker::~GFX_Ticker(void)
+{
+    delete[] strip;
+    delete[] text;
+}
+
+void GFX_Ticker::measureFont()
+{
+    int16_t minx = INT16_MAX, miny = INT16_MAX, maxx = INT16_MIN, maxy = INT16_MIN;
+
+    for (int c = 0; c < 256; c++) {
+        if (c == '\n' || c == '\r') continue;
+        int16_t x = 0, y = 0;
+        charBounds((unsigned char)c, &x, &y, &minx, &miny, &maxx, &maxy);
+        if (x - 1 > maxx) maxx = x - 1;     // advance past the ink, e.g. the classic font's spacing column
+    }
+
+    if (maxx < minx) {                  // font without a single printable glyph
+        minx = miny = 0;
+        maxx = maxy = 0;
+    }
+
+    glyph_left   = minx < 0 ? minx : 0;
+    glyph_right  = maxx + 1;
+    baseline     = -miny;               // 0 for the classic font, the ascent for GFXfonts
+    strip_height = maxy - miny + 1;
+}
+
+void GFX_Ticker::plot(int16_t x, int16_t y, CRGB color)
+{
+    if (!strip || y < 0 || y >= strip_height) return;
+
+    // Glyphs are drawn at their ring column, or one ring further on, and may run past the end
+    if (x >= strip_width) x -= strip_width;
+    if (x < 0 || x >= strip_width) return;
+
+    strip[(size_t)y * strip_width + x] = color;
+}
+
+void GFX_Ticker::clearColumns(uint32_t from, uint32_t to)
+{
+    if (!strip || to <= from) return;
+    if (to - from > strip_width) from = to - strip_width;
+
+    const uint16_t start = from % strip_width;
+    const uint16_t count = to - from;
+    const uint16_t first = (start + count <= strip_width) ? count : strip_width - start;
+
+    for (uint16_t y = 0; y < strip_height; y++) {
+        CRGB *row = strip + (size_t)y * strip_width;
+        for (uint16_t i = 0; i < first; i++) row[start + i] = paper;
+        for (uint16_t i = 0; i < count - first; i++) row[i] = paper;
+    }
+
+    if (to > cleared) cleared = to;
+}
+
+void GFX_Ticker::renderAhead()
+{
+    const uint32_t window_left  = scroll_q8 >> 8;
+    const uint32_t window_right = window_left + window_width;
+
+    // Fell behind (speed above the strip size): nothing left of the window matters
+    if (cleared < window_left) cleared = window_left;
+
+    size_t stalled = 0;                 // characters in a row that didn't move the cursor
+
+    while (text_len && (int32_t)(cursor - window_right) < -glyph_left && stalled < text_len) {
+        const unsigned char c = text[next_char];
+        uint16_t advance = gap;
+
+        if (c != '\n') {
+            int16_t x = 0, y = 0, minx = INT16_MAX, miny = INT16_MAX, maxx = INT16_MIN, maxy = INT16_MIN;
+            charBounds(c, &x, &y, &minx, &miny, &maxx, &maxy);
+            advance = x;
+
+            if (cursor + glyph_right > window_left) {
+                int16_t ring_x = cursor % strip_width;
+                if (ring_x + glyph_left < 0) ring_x += strip_width;
+
+                clearColumns(cleared, cursor + glyph_right);
+                drawChar(ring_x, baseline, c, textcolor, textcolor, textsize_x, textsize_y);
+            }
+        }
+
+        cursor += advance;
+        stalled = advance ? 0 : stalled + 1;
+        if (++next_char == text_len) next_char = 0;
+    }
+
+    // Gaps, an empty queue or a stalled one just show paper
+    clearColumns(cleared, window_right);
+    if (!text_len || stalled >= text_len) {
+        if (cursor < window_right) cursor = window_right;
+    }
+
+    // Keep the virtual columns small; only their value modulo strip_width matters
+    if (window_left >= strip_width && cursor >= strip_width) {
+        scroll_q8 -= (uint32_t)strip_width << 8;
+        cursor    -= strip_width;
+        cleared   -= strip_width;
+    }
+}
+
+bool GFX_Ticker::append(const char *msg)
+{
+    if (!msg) return false;
+
+    // Each message is followed by a '\n', which scrolls as a gap
+    const size_t len = strlen(msg);
+    if (text_len + len + 1 > text_capacity) {
+        size_t capacity = text_capacity ? text_capacity * 2 : 32;
+        while (capacity < text_len + len + 1) capacity *= 2;
+
+        char *grown = new(std::nothrow) char[capacity];
+        if (!grown) return false;
+
+        if (text) memcpy(grown, text, text_len);
+        delete[] text;
+        text = grown;
+        text_capacity = capacity;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        text[text_len + i] = (msg[i] == '\n') ? ' ' : msg[i];
+    }
+    text[text_len + len] = '\n';
+    text_len += len + 1;
+    return true;
+}
+
+void GFX_Ticker::clear()
+{
+    text_len  = 0;
+    next_char = 0;
+    restart();
+}
+
+void GFX_Ticker::restart()
+{
+    scroll_q8 = 0;
+    next_char = 0;
+    cleared   = 0;
+    cursor    = window_width;       // text enters from the right edge
+    if (strip) clearColumns(0, strip_width);
+}
+
+void GFX_Ticker::update()
+{
+    scroll_q8 += speed;
+}
+
+void GFX_Ticker::render(const GFX_Surface &dst, int16_t x, int16_t y, bool transparent)
+{
+    if (!strip || !dst.data) return;
+
+    renderAhead();
+
+    // Clip the window against the surface, in surface coordinates
+    int32_t dx0 = (int32_t)x - dst.x, dy0 = (int32_t)y - dst.y;
+    int32_t sx0 = 0, sy0 = 0;
+    int32_t w = window_width, h = strip_height;
+
+    if (dx0 < 0) { sx0 = -dx0; w += dx0; dx0 = 0; }
+    if (dy0 < 0) { sy0 = -dy0; h += dy0; dy0 = 0; }
+    if (dx0 + w > dst.width)  w = dst.width  - dx0;
+    if (dy0 + h > dst.height) h = dst.height - dy0;
+    if (w <= 0 || h <= 0) return;
+
+    // Start of the visible part in the ring, and how much of it runs before the wrap
+    const uint16_t start = ((scroll_q8 >> 8) + sx0) % strip_width;
+    const uint16_t first = (start + w <= strip_width) ? w : strip_width - start;
+
+    for (int32_t row = 0; row < h; row++) {
+        const CRGB *src = strip + (size_t)(sy0 + row) * strip_width;
+        CRGB *out = dst.row(dy0 + row) + dx0;
+
+        if (!transparent) {
+            memcpy(out, src + start, first * sizeof(CRGB));
+            memcpy(out + first, src, (w - first) * sizeof(CRGB));
+            continue;
+        }
+
+        for (uint16_t i = 0; i < first; i++) {
+            if (src[start + i] != paper) out[i] = src[start + i];
+        }
+        for (uint16_t i = first; i < w; i++) {
+            if (src[i - first] != paper) out[i] = src[i - first];
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * Scrolling text ticker / marquee.
+ *
+ * Glyphs are rasterized once into a small off-screen ring strip as they are about
+ * to scroll into view, and every frame only the visible window is copied out of it.
+ * The text loops seamlessly, messages can be appended while it is running without
+ * re-rendering anything already drawn, and the speed is in 1/256ths of a pixel per
+ * update() so slow tickers don't have to skip frames.
+ *
+ * The font and text size are fixed when the ticker is constructed, as they decide
+ * the strip size.
+ *
+ * Requires GFX_Lite
+ */
+
+#ifndef GFX_TICKER_HPP
+#define GFX_TICKER_HPP
+
+#include <new>
+#include "GFX_Lite.h"
+#include "GFX_Layer.hpp"
+
+class GFX_Ticker : public GFX
+{
+    public:
+        // width = visible width in pixels, font = NULL for the classic 6x8 font
+        GFX_Ticker(uint16_t width, const GFXfont *font = NULL, uint8_t size = 1);
+        ~GFX_Ticker(void);
+
+        GFX_Ticker(const GFX_Ticker &) = delete;
+        GFX_Ticker &operator=(const GFX_Ticker &) = delete;
+
+        // Draw into the strip; x wraps around the ring. Glyphs come through the
+        // 16-bit path (drawChar() takes 5-6-5 colours), which uses the ink colour.
+        void drawPixel(int16_t x, int16_t y, CRGB color) { plot(x, y, color); }
+        void drawPixel(int16_t x, int16_t y, uint16_t /*color*/) { plot(x, y, ink); }
+
+        // Applies to glyphs rendered from now on; restart() to redraw everything
+        inline void setColors(CRGB ink_colour, CRGB paper_colour = CRGB::Black) { ink = ink_colour; paper = paper_colour; }
+
+        // Pixels per update() in 8.8 fixed point: 256 = 1 px per frame, 64 = 1 px every 4 frames
+        inline void setSpeed(uint16_t px_q8) { speed = px_q8; }
+
+        // Blank pixels between messages and before the text loops round again
+        inline void setGap(uint16_t px) { gap = px; }
+
+        // Queue another message. Returns false if there was no memory for it.
+        bool append(const char *msg);
+
+        // Drop all messages and start from an empty window
+        void clear();
+
+        // Scroll back to the start of the first message and redraw
+        void restart();
+
+        // Advance the scroll position by one frame
+        void update();
+
+        /*
+         * Copy the visible window to canvas position (x,y) of dst. With 'transparent'
+         * set, paper coloured pixels are skipped so the text can overlay a scene.
+         */
+        void render(const GFX_Surface &dst, int16_t x, int16_t y, bool transparent = false);
+
+        uint16_t getWindowWidth() const { return window_width; }
+        uint16_t getStripHeight() const { return strip_height; }
+
+        bool   isInitialized() const { return strip != nullptr; }
+        size_t getMemoryUsage() const { return (size_t)strip_width * strip_height * sizeof(CRGB) + text_capacity; }
+
+    private:
+        uint16_t window_width;
+        uint16_t strip_width   = 0;     // ring size; always > window + two glyph extents
+        uint16_t strip_height  = 0;
+        int16_t  baseline      = 0;     // y passed to drawChar()
+        int16_t  glyph_left    = 0;     // furthest any glyph draws left of its cursor (<= 0)
+        int16_t  glyph_right   = 0;     // furthest any glyph draws right of its cursor
+        CRGB    *strip         = nullptr;
+
+        char    *text          = nullptr;
+        size_t   text_len      = 0;
+        size_t   text_capacity = 0;
+        size_t   next_char     = 0;     // next character to rasterize
+
+        // Virtual strip columns; the ring column is v % strip_width. All three are
+        // rebased together so they never overflow.
+        uint32_t scroll_q8     = 0;     // window left edge, 8.8
+        uint32_t cursor        = 0;     // where the next glyph goes
+        uint32_t cleared       = 0;     // columns before this have been cleared to paper
+
+        uint16_t speed         = 256;
+        uint16_t gap           = 8;
+        CRGB     ink           = CRGB::White;
+        CRGB     paper         = CRGB::Black;
+
+        void measureFont();
+        void plot(int16_t x, int16_t y, CRGB color);
+        void clearColumns(uint32_t from, uint32_t to);
+        void renderAhead();
+};
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * Small persistent worker pool used to split layer and compositor work into row bands.
+ */
+
+#include "GFX_WorkerPool.hpp"
+#include <new>
+
+#if GFX_WORKER_POOL_FREERTOS
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+  #include <freertos/semphr.h>
+#endif
+
+uint8_t GFX_WorkerPool::bands(uint16_t count) const
+{
+    uint16_t n = count / MIN_ROWS_PER_BAND;
+    if (n > _threads) n = _threads;
+    return n ? (uint8_t)n : 1;
+}
+
+void GFX_WorkerPool::runBand(uint8_t band)
+{
+    if (band >= job_bands) return;
+    GFX_PROFILE_CALL("GFX_WorkerPool band");
+
+    bool &inside = insideBand();
+    const bool outer = inside;
+    inside = true;
+    (*job)(bandBegin(job_count, job_bands, band), bandBegin(job_count, job_bands, band + 1), band);
+    inside = outer;
+}
+
+#if GFX_WORKER_POOL_STD_THREAD
+
+struct GFX_WorkerPool::Worker {
+    std::thread thread;
+};
+
+GFX_WorkerPool::GFX_WorkerPool(uint8_t threads)
+{
+    if (threads == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        threads = (hw == 0) ? 1 : (hw > 255) ? 255 : (uint8_t)hw;
+    }
+    _threads = threads;
+
+    if (_threads > 1) {
+        worker_list = new(std::nothrow) Worker[_threads - 1];
+        if (!worker_list) {
+            _threads = 1;
+            return;
+        }
+        for (uint8_t i = 0; i < _threads - 1; i++) {
+            worker_list[i].thread = std::thread(&GFX_WorkerPool::workerLoop, this, (uint8_t)(i + 1));
+        }
+    }
+}
+
+GFX_WorkerPool::~GFX_WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    start_cv.notify_all();
+
+    for (uint8_t i = 0; worker_list && i < _threads - 1; i++) {
+        worker_list[i].thread.join();
+    }
+    delete[] worker_list;
+}
+
+void GFX_WorkerPool::workerLoop(uint8_t band)
+{
+    uint32_t seen = 0;
+
+    for (;;) {
+        std::unique_lock<std::mutex> guard(lock);
+        start_cv.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        guard.unlock();
+
+        runBand(band);
+
+        guard.lock();
+        if (--pending == 0) done_cv.notify_one();
+    }
+}
+
+void GFX_WorkerPool::parallelFor(uint16_t count, const BandFn &fn)
+{
+    const uint8_t n = bands(count);
+
+    // Single band, nested call or another thread already using the pool: same bands, one thread
+    if (n <= 1 || insideBand() || !submit_lock.try_lock()) {
+        for (uint8_t b = 0; b < n; b++) fn(bandBegin(count, n, b), bandBegin(count, n, b + 1), b);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job       = &fn;
+        job_count = count;
+        job_bands = n;
+        pending   = _threads - 1;
+        generation++;
+    }
+    start_cv.notify_all();
+
+    runBand(0);
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        done_cv.wait(guard, [&] { return pending == 0; });
+        job = nullptr;
+    }
+    submit_lock.unlock();
+}
+
+#elif GFX_WORKER_POOL_FREERTOS
+
+struct GFX_WorkerPool::Worker {
+    GFX_WorkerPool    *pool;
+    uint8_t            band;
+    SemaphoreHandle_t  start;
+};
+
+GFX_WorkerPool::GFX_WorkerPool(uint8_t threads)
+{
+#if CONFIG_FREERTOS_UNICORE
+    threads = 1;
+#else
+    if (threads == 0) threads = portNUM_PROCESSORS;
+#endif
+    _threads = threads;
+
+    if (_threads > 1) {
+        done_sem    = xSemaphoreCreateCounting(_threads - 1, 0);
+        submit_sem  = xSemaphoreCreateMutex();
+        worker_list = new(std::nothrow) Worker[_threads - 1];
+
+        if (!done_sem || !submit_sem || !worker_list) {
+            _threads = 1;
+            return;
+        }
+
+        for (uint8_t i = 0; i < _threads - 1; i++) {
+            Worker &w = worker_list[i];
+            w.pool  = this;
+            w.band  = i + 1;
+            w.start = xSemaphoreCreateBinary();
+
+            // Spread the workers over the cores the caller isn't on
+            BaseType_t core = (xPortGetCoreID() + w.band) % portNUM_PROCESSORS;
+            const bool started = w.start &&
+                xTaskCreatePinnedToCore(workerTask, "gfx_worker", 4096, &w, uxTaskPriorityGet(NULL), NULL, core) == pdPASS;
+
+            // Out of memory: carry on with the workers already running (the destructor
+            // only stops and deletes those), or on the calling task alone
+            if (!started) {
+                if (w.start) vSemaphoreDelete(w.start);
+                _threads = i + 1;
+                break;
+            }
+        }
+    }
+}
+
+GFX_WorkerPool::~GFX_WorkerPool()
+{
+    if (worker_list) {
+        stopping = true;
+        for (uint8_t i = 0; i < _threads - 1; i++) xSemaphoreGive((SemaphoreHandle_t)worker_list[i].start);
+        for (uint8_t i = 0; i < _threads - 1; i++) xSemaphoreTake((SemaphoreHandle_t)done_sem, portMAX_DELAY);
+        for (uint8_t i = 0; i < _threads - 1; i++) vSemaphoreDelete(worker_list[i].start);
+        delete[] worker_list;
+    }
+    if (done_sem)   vSemaphoreDelete((SemaphoreHandle_t)done_sem);
+    if (submit_sem) vSemaphoreDelete((SemaphoreHandle_t)submit_sem);
+}
+
+void GFX_WorkerPool::workerTask(void *arg)
+{
+    Worker &w = *(Worker *)arg;
+    GFX_WorkerPool *pool = w.pool;
+
+    for (;;) {
+        xSemaphoreTake(w.start, portMAX_DELAY);
+        if (pool->stopping) break;
+
+        pool->runBand(w.band);
+        xSemaphoreGive((SemaphoreHandle_t)pool->done_sem);
+    }
+
+    xSemaphoreGive((SemaphoreHandle_t)pool->done_sem);
+    vTaskDelete(NULL);
+}
+
+void GFX_WorkerPool::parallelFor(uint16_t count, const BandFn &fn)
+{
+    const uint8_t n = bands(count);
+
+    // Single band, nested call or another task already using the pool: same bands, one task
+    if (n <= 1 || insideBand() || xSemaphoreTake((SemaphoreHandle_t)submit_sem, 0) != pdTRUE) {
+        for (uint8_t b = 0; b < n; b++) fn(bandBegin(count, n, b), bandBegin(count, n, b + 1), b);
+        return;
+    }
+
+    job       = &fn;
+    job_count = count;
+    job_bands = n;
+
+    for (uint8_t i = 0; i < _threads - 1; i++) xSemaphoreGive(worker_list[i].start);
+
+    runBand(0);
+
+    for (uint8_t i = 0; i < _threads - 1; i++) xSemaphoreTake((SemaphoreHandle_t)done_sem, portMAX_DELAY);
+
+    job = nullptr;
+    xSemaphoreGive((SemaphoreHandle_t)submit_sem);
+}
+
+#else // no threading available
+
+GFX_WorkerPool::GFX_WorkerPool(uint8_t threads) : _threads(1) {}
+GFX_WorkerPool::~GFX_WorkerPool() {}
+
+void GFX_WorkerPool::parallelFor(uint16_t count, const BandFn &fn)
+{
+    fn(0, count, 0);
+}
+
+#endif
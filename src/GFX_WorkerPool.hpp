@@ -0,0 +1,98 @@
+/**
+ * Small persistent worker pool used to split layer and compositor work into row bands.
+ *
+ * Backends:
+ *  - std::thread on hosted platforms (Linux / macOS / Windows builds)
+ *  - FreeRTOS tasks on dual-core ESP32 parts (pinned to the other core)
+ *  - everything runs on the calling thread otherwise
+ *
+ * Work is split into contiguous bands that are a fixed function of the row count
+ * and the number of threads. Callers only ever write the rows of their own band,
+ * so results are identical whatever the thread count.
+ */
+
+#ifndef GFX_WORKER_POOL_HPP
+#define GFX_WORKER_POOL_HPP
+
+#include <stdint.h>
+#include <functional>
+#include "GFX_Lite_optimizations.h"
+
+#if GFX_WORKER_POOL_STD_THREAD
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+#endif
+
+class GFX_WorkerPool
+{
+    public:
+        // fn(begin, end, band): process rows [begin, end) of band number 'band'
+        typedef std::function<void(uint16_t, uint16_t, uint8_t)> BandFn;
+
+        // threads = total threads including the caller, 0 = one per CPU core
+        explicit GFX_WorkerPool(uint8_t threads = 0);
+        ~GFX_WorkerPool();
+
+        GFX_WorkerPool(const GFX_WorkerPool &) = delete;
+        GFX_WorkerPool &operator=(const GFX_WorkerPool &) = delete;
+
+        // Threads taking part in a parallelFor(), including the calling one
+        uint8_t threadCount() const { return _threads; }
+
+        // Number of bands 'count' rows are split into (always >= 1)
+        uint8_t bands(uint16_t count) const;
+
+        // First row of band 'band' out of 'bands' (band == bands gives 'count')
+        static inline uint16_t bandBegin(uint16_t count, uint8_t bands, uint8_t band) {
+            return (uint16_t)(((uint32_t)count * band) / bands);
+        }
+
+        /**
+         * Run fn over [0, count) split into bands(count) bands. The calling thread
+         * takes band 0; returns once every band is done. Calls made from inside a
+         * band (nesting) run serially on that thread.
+         */
+        void parallelFor(uint16_t count, const BandFn &fn);
+
+        // Rows below this are not worth waking the workers for
+        static const uint16_t MIN_ROWS_PER_BAND = 4;
+
+    private:
+        uint8_t       _threads;
+        const BandFn *job       = nullptr;
+        uint16_t      job_count = 0;
+        uint8_t       job_bands = 0;
+
+        void runBand(uint8_t band);
+
+        // Set while this thread runs a band, so a nested parallelFor() stays serial
+        // without touching the submit lock the caller may already hold
+        static inline bool &insideBand() {
+            static thread_local bool inside = false;
+            return inside;
+        }
+
+        struct Worker;                  // backend specific, see GFX_WorkerPool.cpp
+        Worker       *worker_list = nullptr;
+
+#if GFX_WORKER_POOL_STD_THREAD
+        std::mutex              lock;
+        std::mutex              submit_lock;
+        std::condition_variable start_cv;
+        std::condition_variable done_cv;
+        uint32_t                generation = 0;
+        uint8_t                 pending    = 0;
+        bool                    stopping   = false;
+
+        void workerLoop(uint8_t band);
+#elif GFX_WORKER_POOL_FREERTOS
+        void *done_sem   = nullptr;     // SemaphoreHandle_t, counting
+        void *submit_sem = nullptr;     // SemaphoreHandle_t, mutex
+        volatile bool stopping = false; // set by the destructor, read by the worker tasks
+
+        static void workerTask(void *arg);
+#endif
+};
+
+#endif
@@ -479,9 +479,9 @@ void blurColumns(CRGB* leds, uint16_t width, uint16_t height, fract8 blur_amount
     // blur columns
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
-    for( uint8_t col = 0; col < width; ++col) {
+    for( uint16_t col = 0; col < width; ++col) {
         CRGB carryover = CRGB::Black;
-        for( uint8_t i = 0; i < height; ++i) {
+        for( uint16_t i = 0; i < height; ++i) {
             CRGB cur = leds[XY(col,i)];
             CRGB part = cur;
             part.nscale8( seep);
@@ -494,6 +494,52 @@ void blurColumns(CRGB* leds, uint16_t width, uint16_t height, fract8 blur_amount
     }
 }
 
+void blur2d( CRGB* base, uint16_t width, uint16_t height, uint16_t stride, fract8 blur_amount)
+{
+    blurRows(base, width, height, stride, blur_amount);
+    blurColumns(base, width, height, stride, blur_amount);
+}
+
+void blurRows( CRGB* base, uint16_t width, uint16_t height, uint16_t stride, fract8 blur_amount)
+{
+    for( uint16_t row = 0; row < height; row++) {
+        blur1d( base + (size_t)row * stride, width, blur_amount);
+    }
+}
+
+// Columns handled together by blurColumns(), each with its own carryover
+#define BLUR_COLUMNS_PER_BLOCK 16
+
+void blurColumns( CRGB* base, uint16_t width, uint16_t height, uint16_t stride, fract8 blur_amount)
+{
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    CRGB carryover[BLUR_COLUMNS_PER_BLOCK];
+
+    for( uint32_t col0 = 0; col0 < width; col0 += BLUR_COLUMNS_PER_BLOCK) {
+        uint16_t cols = width - col0;
+        if( cols > BLUR_COLUMNS_PER_BLOCK) cols = BLUR_COLUMNS_PER_BLOCK;
+
+        for( uint16_t c = 0; c < cols; c++) carryover[c] = CRGB::Black;
+
+        CRGB* above = 0;
+        for( uint16_t i = 0; i < height; ++i) {
+            CRGB* row = base + (size_t)i * stride + col0;
+            for( uint16_t c = 0; c < cols; c++) {
+                CRGB cur = row[c];
+                CRGB part = cur;
+                part.nscale8( seep);
+                cur.nscale8( keep);
+                cur += carryover[c];
+                if( above) above[c] += part;
+                row[c] = cur;
+                carryover[c] = part;
+            }
+            above = row;
+        }
+    }
+}
+
 
 
 // CRGB HeatColor( uint8_t temperature)
@@ -451,6 +451,25 @@ void blurRows( CRGB* leds, uint16_t width, uint16_t height, fract8 blur_amount);
 /// @copydetails blurRows()
 void blurColumns(CRGB* leds, uint16_t width, uint16_t height, fract8 blur_amount);
 
+/// blur2d() on a plain row-major buffer, without going through XY().
+/// Rows start @p stride pixels apart, so a sub-rectangle of a larger
+/// buffer can be blurred in place.
+/// @param base a pointer to the top-left pixel
+/// @param width the width of the area
+/// @param height the height of the area
+/// @param stride distance between the starts of two rows, in pixels
+/// @param blur_amount the amount of blur to apply
+void blur2d( CRGB* base, uint16_t width, uint16_t height, uint16_t stride, fract8 blur_amount);
+
+/// blurRows() on a plain row-major buffer
+/// @copydetails blur2d(CRGB*, uint16_t, uint16_t, uint16_t, fract8)
+void blurRows( CRGB* base, uint16_t width, uint16_t height, uint16_t stride, fract8 blur_amount);
+
+/// blurColumns() on a plain row-major buffer. Columns are processed a
+/// block at a time, walking each row's pixels in memory order.
+/// @copydetails blur2d(CRGB*, uint16_t, uint16_t, uint16_t, fract8)
+void blurColumns( CRGB* base, uint16_t width, uint16_t height, uint16_t stride, fract8 blur_amount);
+
 /// @} ColorBlurs
 
 
@@ -5,6 +5,7 @@
 #define FASTLED_INTERNAL
 #include <string.h>
 #include <FastLED_Lite.h>
+#include "GFX_Lite_optimizations.h"
 
 // Compiler throws a warning about stack usage possibly being unbounded even
 // though bounds are checked, silence that so users don't see it
@@ -566,6 +567,483 @@ uint8_t inoise8(uint16_t x) {
     return ans;
 }
 
+// Row kernels. Along a row y and z are fixed, so each lattice cell's corner hashes,
+// and the y / z half of each corner's gradient, are worked out once per cell rather
+// than once per sample.
+
+/// @cond
+
+// A lattice corner's gradient with its y / z part applied, for the x of each sample.
+// grad8() / grad16() average two of +-x, +-y, +-z as (u>>1) + (v>>1) + (u&1);
+// here that is base + (t>>1) + (t&odd) with t = x, -x, or 0 when x isn't used
+template <class T> struct CornerGrad {
+    T       base;
+    int8_t  sign;
+    uint8_t odd;
+
+    inline T operator()(T x) const __attribute__((always_inline)) {
+        const T t = (T)(x * sign);   // wraps like the original negation
+        return base + (t >> 1) + (t & odd);
+    }
+};
+
+// Which of x, y, z each hash's gradient averages, and their signs: u = su*y (or x when
+// su is 0), v = sv*(vz ? z : y) (or x when sv is 0), and x's sign. Looked up rather
+// than branched on, since the hashes along a row are random
+struct GradSelect { int8_t su, sv, sx; uint8_t vz, odd; };
+
+// grad8() / grad16() in 3D, by hash & 15
+static const GradSelect grad3_select[16] = {
+  { 0, 1, 1,0,1}, { 0, 1,-1,0,1}, { 0,-1, 1,0,1}, { 0,-1,-1,0,1},    // u = x, v = y
+  { 0, 1, 1,1,1}, { 0, 1,-1,1,1}, { 0,-1, 1,1,1}, { 0,-1,-1,1,1},    // u = x, v = z
+  { 1, 1, 0,1,0}, {-1, 1, 0,1,0}, { 1,-1, 0,1,0}, {-1,-1, 0,1,0},    // u = y, v = z
+  { 1, 0, 1,0,0}, {-1, 1, 0,1,0}, { 1, 0,-1,0,0}, {-1,-1, 0,1,0}     // 12, 14: u = y, v = x; 13, 15 as 8..11
+};
+
+// grad8() / grad16() in 2D, by hash & 7
+static const GradSelect grad2_select[8] = {
+  { 0, 1, 1,0,1}, { 0, 1,-1,0,1}, { 0,-1, 1,0,1}, { 0,-1,-1,0,1},    // u = x, v = y
+  { 1, 0, 1,0,0}, {-1, 0, 1,0,0}, { 1, 0,-1,0,0}, {-1, 0,-1,0,0}     // u = y, v = x
+};
+
+template <class T> static inline CornerGrad<T> cornerGrad(const GradSelect &s, T y, T z) {
+  const T u = (T)(y * s.su);
+  const T v = (T)((s.vz ? z : y) * s.sv);
+  CornerGrad<T> g;
+  g.base = (u >> 1) + (v >> 1) + (u & 1);
+  g.sign = s.sx;
+  g.odd  = s.odd;
+  return g;
+}
+
+template <class T> static inline CornerGrad<T> cornerGrad(uint8_t hash, T y, T z) {
+  return cornerGrad<T>(grad3_select[hash & 15], y, z);
+}
+
+template <class T> static inline CornerGrad<T> cornerGrad(uint8_t hash, T y) {
+  return cornerGrad<T>(grad2_select[hash & 7], y, y);
+}
+
+// lerp7by8() / lerp15by16() written so the compiler can pick with a conditional move:
+// in a row of noise the branch on b > a is a coin toss
+static inline int8_t __attribute__((always_inline)) lerp7by8_select(int8_t a, int8_t b, fract8 frac) {
+  const bool up = b > a;
+  const uint8_t scaled = scale8(up ? (uint8_t)(b - a) : (uint8_t)(a - b), frac);
+  return up ? a + scaled : a - scaled;
+}
+
+static inline int16_t __attribute__((always_inline)) lerp15by16_select(int16_t a, int16_t b, fract16 frac) {
+  const bool up = b > a;
+  const uint16_t scaled = scale16(up ? (uint16_t)(b - a) : (uint16_t)(a - b), frac);
+  return up ? a + scaled : a - scaled;
+}
+
+#ifdef FADE_12
+#define LERP_ROW LERP
+#else
+#define LERP_ROW lerp15by16_select
+#endif
+
+/// @endcond
+
+void inoise16_row(uint16_t *out, int count, uint32_t x, int32_t dx, uint32_t y, uint32_t z) {
+#if FASTLED_NOISE_ALLOW_AVERAGE_TO_OVERFLOW == 1
+  // grad16() doesn't average the way CornerGrad does
+  for(int i = 0; i < count; ++i, x += dx) { out[i] = inoise16(x,y,z); }
+#else
+  const uint8_t Y = (y>>16)&0xFF;
+  const uint8_t Z = (z>>16)&0xFF;
+  const uint16_t N = 0x8000L;
+
+  const int16_t yy = ((y & 0xFFFF) >> 1) & 0x7FFF;
+  const int16_t zz = ((z & 0xFFFF) >> 1) & 0x7FFF;
+  const int16_t yN = yy - N;
+  const int16_t zN = zz - N;
+  const uint16_t v = EASE16((uint16_t)(y & 0xFFFF));
+  const uint16_t w = EASE16((uint16_t)(z & 0xFFFF));
+
+  CornerGrad<int16_t> g[8] = {};    // set on entering the first cell; zeroed to keep -Wall quiet
+  int cell = -1;
+  for(int i = 0; i < count; ++i, x += dx) {
+    const uint8_t X = (x>>16)&0xFF;
+    if(X != cell) {
+      cell = X;
+      uint8_t A = P(X)+Y;
+      uint8_t AA = P(A)+Z;
+      uint8_t AB = P(A+1)+Z;
+      uint8_t B = P(X+1)+Y;
+      uint8_t BA = P(B) + Z;
+      uint8_t BB = P(B+1)+Z;
+      g[0] = cornerGrad<int16_t>(P(AA), yy, zz);   g[1] = cornerGrad<int16_t>(P(BA), yy, zz);
+      g[2] = cornerGrad<int16_t>(P(AB), yN, zz);   g[3] = cornerGrad<int16_t>(P(BB), yN, zz);
+      g[4] = cornerGrad<int16_t>(P(AA+1), yy, zN); g[5] = cornerGrad<int16_t>(P(BA+1), yy, zN);
+      g[6] = cornerGrad<int16_t>(P(AB+1), yN, zN); g[7] = cornerGrad<int16_t>(P(BB+1), yN, zN);
+    }
+
+    uint16_t u = x & 0xFFFF;
+    const int16_t xx = (u >> 1) & 0x7FFF;
+    const int16_t xN = xx - N;
+    u = EASE16(u);
+
+    int16_t X1 = LERP_ROW(g[0](xx), g[1](xN), u);
+    int16_t X2 = LERP_ROW(g[2](xx), g[3](xN), u);
+    int16_t X3 = LERP_ROW(g[4](xx), g[5](xN), u);
+    int16_t X4 = LERP_ROW(g[6](xx), g[7](xN), u);
+
+    int16_t Y1 = LERP_ROW(X1,X2,v);
+    int16_t Y2 = LERP_ROW(X3,X4,v);
+
+    // Scaled as in inoise16(x,y,z)
+    uint32_t pan = (int32_t)LERP_ROW(Y1,Y2,w) + 19052L;
+    pan *= 440L;
+    out[i] = pan>>8;
+  }
+#endif
+}
+
+void inoise16_row(uint16_t *out, int count, uint32_t x, int32_t dx, uint32_t y) {
+#if FASTLED_NOISE_ALLOW_AVERAGE_TO_OVERFLOW == 1
+  for(int i = 0; i < count; ++i, x += dx) { out[i] = inoise16(x,y); }
+#else
+  const uint8_t Y = y>>16;
+  const uint16_t N = 0x8000L;
+
+  const int16_t yy = ((y & 0xFFFF) >> 1) & 0x7FFF;
+  const int16_t yN = yy - N;
+  const uint16_t v = EASE16((uint16_t)(y & 0xFFFF));
+
+  CornerGrad<int16_t> g[4] = {};
+  int cell = -1;
+  for(int i = 0; i < count; ++i, x += dx) {
+    const uint8_t X = x>>16;
+    if(X != cell) {
+      cell = X;
+      uint8_t A = P(X)+Y;
+      uint8_t AA = P(A);
+      uint8_t AB = P(A+1);
+      uint8_t B = P(X+1)+Y;
+      uint8_t BA = P(B);
+      uint8_t BB = P(B+1);
+      g[0] = cornerGrad<int16_t>(P(AA), yy); g[1] = cornerGrad<int16_t>(P(BA), yy);
+      g[2] = cornerGrad<int16_t>(P(AB), yN); g[3] = cornerGrad<int16_t>(P(BB), yN);
+    }
+
+    uint16_t u = x & 0xFFFF;
+    const int16_t xx = (u >> 1) & 0x7FFF;
+    const int16_t xN = xx - N;
+    u = EASE16(u);
+
+    int16_t X1 = LERP_ROW(g[0](xx), g[1](xN), u);
+    int16_t X2 = LERP_ROW(g[2](xx), g[3](xN), u);
+
+    // Scaled as in inoise16(x,y)
+    uint32_t pan = (int32_t)LERP_ROW(X1,X2,v) + 17308L;
+    pan *= 484L;
+    out[i] = pan>>8;
+  }
+#endif
+}
+
+void inoise8_row(uint8_t *out, int count, uint16_t x, int16_t dx, uint16_t y, uint16_t z) {
+  const uint8_t Y = y>>8;
+  const uint8_t Z = z>>8;
+  const uint8_t N = 0x80;
+
+  const int8_t yy = ((uint8_t)(y)>>1) & 0x7F;
+  const int8_t zz = ((uint8_t)(z)>>1) & 0x7F;
+  const int8_t yN = yy - N;
+  const int8_t zN = zz - N;
+  const uint8_t v = EASE8((uint8_t)y);
+  const uint8_t w = EASE8((uint8_t)z);
+
+  CornerGrad<int8_t> g[8] = {};
+  int cell = -1;
+  for(int i = 0; i < count; ++i, x += dx) {
+    const uint8_t X = x>>8;
+    if(X != cell) {
+      cell = X;
+      uint8_t A = P(X)+Y;
+      uint8_t AA = P(A)+Z;
+      uint8_t AB = P(A+1)+Z;
+      uint8_t B = P(X+1)+Y;
+      uint8_t BA = P(B) + Z;
+      uint8_t BB = P(B+1)+Z;
+      g[0] = cornerGrad<int8_t>(P(AA), yy, zz);   g[1] = cornerGrad<int8_t>(P(BA), yy, zz);
+      g[2] = cornerGrad<int8_t>(P(AB), yN, zz);   g[3] = cornerGrad<int8_t>(P(BB), yN, zz);
+      g[4] = cornerGrad<int8_t>(P(AA+1), yy, zN); g[5] = cornerGrad<int8_t>(P(BA+1), yy, zN);
+      g[6] = cornerGrad<int8_t>(P(AB+1), yN, zN); g[7] = cornerGrad<int8_t>(P(BB+1), yN, zN);
+    }
+
+    const int8_t xx = ((uint8_t)(x)>>1) & 0x7F;
+    const int8_t xN = xx - N;
+    const uint8_t u = EASE8((uint8_t)x);
+
+    int8_t X1 = lerp7by8_select(g[0](xx), g[1](xN), u);
+    int8_t X2 = lerp7by8_select(g[2](xx), g[3](xN), u);
+    int8_t X3 = lerp7by8_select(g[4](xx), g[5](xN), u);
+    int8_t X4 = lerp7by8_select(g[6](xx), g[7](xN), u);
+
+    int8_t Y1 = lerp7by8_select(X1,X2,v);
+    int8_t Y2 = lerp7by8_select(X3,X4,v);
+
+    // Scaled as in inoise8(x,y,z)
+    int8_t n = lerp7by8_select(Y1,Y2,w);
+    n += 64;
+    out[i] = qadd8(n,n);
+  }
+}
+
+void inoise8_row(uint8_t *out, int count, uint16_t x, int16_t dx, uint16_t y) {
+  const uint8_t Y = y>>8;
+  const uint8_t N = 0x80;
+
+  const int8_t yy = ((uint8_t)(y)>>1) & 0x7F;
+  const int8_t yN = yy - N;
+  const uint8_t v = EASE8((uint8_t)y);
+
+  CornerGrad<int8_t> g[4] = {};
+  int cell = -1;
+  for(int i = 0; i < count; ++i, x += dx) {
+    const uint8_t X = x>>8;
+    if(X != cell) {
+      cell = X;
+      uint8_t A = P(X)+Y;
+      uint8_t AA = P(A);
+      uint8_t AB = P(A+1);
+      uint8_t B = P(X+1)+Y;
+      uint8_t BA = P(B);
+      uint8_t BB = P(B+1);
+      g[0] = cornerGrad<int8_t>(P(AA), yy); g[1] = cornerGrad<int8_t>(P(BA), yy);
+      g[2] = cornerGrad<int8_t>(P(AB), yN); g[3] = cornerGrad<int8_t>(P(BB), yN);
+    }
+
+    const int8_t xx = ((uint8_t)(x)>>1) & 0x7F;
+    const int8_t xN = xx - N;
+    const uint8_t u = EASE8((uint8_t)x);
+
+    int8_t X1 = lerp7by8_select(g[0](xx), g[1](xN), u);
+    int8_t X2 = lerp7by8_select(g[2](xx), g[3](xN), u);
+
+    // Scaled as in inoise8(x,y)
+    int8_t n = lerp7by8_select(X1,X2,v);
+    n += 64;
+    out[i] = qadd8(n,n);
+  }
+}
+
+// Simplex noise. Coordinates are skewed onto the simplex lattice with Q32 factors
+// (so the lattice stays put across the whole 16.16 coordinate range), and the corner
+// sums are done in Q15: offsets up to ~1.3, squared radii in Q30, contributions in
+// Q30 again after the t^4 * (gradient . offset) product.
+
+/// @cond
+
+#define SIMPLEX_ONE   32768L                // 1.0 in Q15
+#define SIMPLEX_GAIN2 35930
+#define SIMPLEX_GAIN3 16766
+#define SIMPLEX_GAIN4 13978
+
+// v * f / 2^32 for a Q16 coordinate sum v and a Q32 factor f, without 64-bit overflow
+static inline uint64_t simplex_mulq32(uint64_t v, uint32_t f) {
+  return (((v >> 16) * f) >> 16) + (((v & 0xFFFF) * f) >> 32);
+}
+
+// Offset in Q15 of a Q16 coordinate from its simplex's first corner
+static inline int32_t simplex_offset(uint32_t v, uint32_t cell, uint64_t unskew) {
+  return (int32_t)((int64_t)v - ((int64_t)cell << 16) + (int64_t)unskew) >> 1;
+}
+
+// One corner's contribution, Q30: (r^2 - d^2)^4 * (g . d) inside radius r, else 0
+static inline int32_t simplex_corner(uint32_t r2, int32_t d2, int32_t dot) {
+  if(d2 >= (int32_t)r2) { return 0; }
+  int32_t t = (int32_t)(r2 - d2) >> 15;
+  t = (t * t) >> 15;
+  t = (t * t) >> 15;
+  return t * dot;
+}
+
+// |a| < limit for every offset of a corner, before squaring anything
+#define SIMPLEX_NEAR(a, limit) ((uint32_t)((a) + (limit)) < (uint32_t)(2 * (limit)))
+
+// The raw Q30 sum to 0..65535 with a Q24 gain per dimension, clamped. The gains put
+// the largest sums found over 10^7 random points at the ends of the range
+static inline uint16_t simplex_scale(int32_t n, int32_t gain) {
+  const int32_t v = 32768 + (int32_t)(((int64_t)n * gain) >> 24);
+  return v < 0 ? 0 : v > 65535 ? 65535 : v;
+}
+
+// 2D gradients by hash & 7, 3D by hash & 15 (Perlin's 12 edges plus 4 repeats),
+// 4D by hash & 31
+static const int8_t simplex_grad2[8][2] = {
+  { 1, 1}, {-1, 1}, { 1,-1}, {-1,-1}, { 1, 0}, {-1, 0}, { 0, 1}, { 0,-1}
+};
+static const int8_t simplex_grad3[16][3] = {
+  { 1, 1, 0}, {-1, 1, 0}, { 1,-1, 0}, {-1,-1, 0}, { 1, 0, 1}, {-1, 0, 1}, { 1, 0,-1}, {-1, 0,-1},
+  { 0, 1, 1}, { 0,-1, 1}, { 0, 1,-1}, { 0,-1,-1}, { 1, 1, 0}, { 0,-1, 1}, {-1, 1, 0}, { 0,-1,-1}
+};
+static const int8_t simplex_grad4[32][4] = {
+  { 0, 1, 1, 1}, { 0, 1, 1,-1}, { 0, 1,-1, 1}, { 0, 1,-1,-1}, { 0,-1, 1, 1}, { 0,-1, 1,-1}, { 0,-1,-1, 1}, { 0,-1,-1,-1},
+  { 1, 0, 1, 1}, { 1, 0, 1,-1}, { 1, 0,-1, 1}, { 1, 0,-1,-1}, {-1, 0, 1, 1}, {-1, 0, 1,-1}, {-1, 0,-1, 1}, {-1, 0,-1,-1},
+  { 1, 1, 0, 1}, { 1, 1, 0,-1}, { 1,-1, 0, 1}, { 1,-1, 0,-1}, {-1, 1, 0, 1}, {-1, 1, 0,-1}, {-1,-1, 0, 1}, {-1,-1, 0,-1},
+  { 1, 1, 1, 0}, { 1, 1,-1, 0}, { 1,-1, 1, 0}, { 1,-1,-1, 0}, {-1, 1, 1, 0}, {-1, 1,-1, 0}, {-1,-1, 1, 0}, {-1,-1,-1, 0}
+};
+
+/// @endcond
+
+uint16_t snoise16(uint32_t x, uint32_t y) {
+  const uint32_t F2 = 1572067139u, G2 = 907633386u;       // (sqrt(3)-1)/2, (3-sqrt(3))/6
+  const int32_t  G2_15 = 6925;
+
+  // Skew to the simplex lattice, find the cell, and unskew its origin
+  const uint64_t s = simplex_mulq32((uint64_t)x + y, F2);
+  const uint32_t i = ((uint64_t)x + s) >> 16;
+  const uint32_t j = ((uint64_t)y + s) >> 16;
+  const uint64_t t = simplex_mulq32((uint64_t)(i + j) << 16, G2);
+
+  const int32_t x0 = simplex_offset(x, i, t), y0 = simplex_offset(y, j, t);
+
+  // Which triangle of the cell
+  const uint8_t i1 = x0 > y0, j1 = !i1;
+  const int32_t x1 = x0 - i1*SIMPLEX_ONE + G2_15,       y1 = y0 - j1*SIMPLEX_ONE + G2_15;
+  const int32_t x2 = x0 - SIMPLEX_ONE + 2*G2_15,         y2 = y0 - SIMPLEX_ONE + 2*G2_15;
+
+  const uint8_t ii = i, jj = j;
+  const uint32_t R2 = 536870912u;                          // 0.5 in Q30
+  const int32_t  LIM = 23171;                              // sqrt(0.5) in Q15
+  int32_t n = 0;
+
+#define SIMPLEX_CORNER2(X, Y, H) \
+  if(SIMPLEX_NEAR(X, LIM) && SIMPLEX_NEAR(Y, LIM)) { \
+    const int8_t *g = simplex_grad2[(H) & 7]; \
+    n += simplex_corner(R2, X*X + Y*Y, g[0]*X + g[1]*Y); \
+  }
+  SIMPLEX_CORNER2(x0, y0, P((uint8_t)(ii + P(jj))))
+  SIMPLEX_CORNER2(x1, y1, P((uint8_t)(ii + i1 + P((uint8_t)(jj + j1)))))
+  SIMPLEX_CORNER2(x2, y2, P((uint8_t)(ii + 1 + P((uint8_t)(jj + 1)))))
+#undef SIMPLEX_CORNER2
+
+  return simplex_scale(n, SIMPLEX_GAIN2);
+}
+
+uint16_t snoise16(uint32_t x, uint32_t y, uint32_t z) {
+  const uint32_t F3 = 1431655765u, G3 = 715827883u;       // 1/3, 1/6
+  const int32_t  G3_15 = 5461;
+
+  const uint64_t s = simplex_mulq32((uint64_t)x + y + z, F3);
+  const uint32_t i = ((uint64_t)x + s) >> 16;
+  const uint32_t j = ((uint64_t)y + s) >> 16;
+  const uint32_t k = ((uint64_t)z + s) >> 16;
+  const uint64_t t = simplex_mulq32((uint64_t)(i + j + k) << 16, G3);
+
+  const int32_t x0 = simplex_offset(x, i, t), y0 = simplex_offset(y, j, t), z0 = simplex_offset(z, k, t);
+
+  // Which of the cell's six tetrahedra, from the order of the offsets
+  uint8_t i1, j1, k1, i2, j2, k2;
+  if(x0 >= y0) {
+    if(y0 >= z0)      { i1=1; j1=0; k1=0; i2=1; j2=1; k2=0; }
+    else if(x0 >= z0) { i1=1; j1=0; k1=0; i2=1; j2=0; k2=1; }
+    else              { i1=0; j1=0; k1=1; i2=1; j2=0; k2=1; }
+  } else {
+    if(y0 < z0)       { i1=0; j1=0; k1=1; i2=0; j2=1; k2=1; }
+    else if(x0 < z0)  { i1=0; j1=1; k1=0; i2=0; j2=1; k2=1; }
+    else              { i1=0; j1=1; k1=0; i2=1; j2=1; k2=0; }
+  }
+
+  const int32_t x1 = x0 - i1*SIMPLEX_ONE + G3_15,   y1 = y0 - j1*SIMPLEX_ONE + G3_15,   z1 = z0 - k1*SIMPLEX_ONE + G3_15;
+  const int32_t x2 = x0 - i2*SIMPLEX_ONE + 2*G3_15, y2 = y0 - j2*SIMPLEX_ONE + 2*G3_15, z2 = z0 - k2*SIMPLEX_ONE + 2*G3_15;
+  const int32_t x3 = x0 - SIMPLEX_ONE + 3*G3_15,    y3 = y0 - SIMPLEX_ONE + 3*G3_15,    z3 = z0 - SIMPLEX_ONE + 3*G3_15;
+
+  const uint8_t ii = i, jj = j, kk = k;
+  const uint32_t R2 = 644245094u;                          // 0.6 in Q30
+  const int32_t  LIM = 25382;                              // sqrt(0.6) in Q15
+  int32_t n = 0;
+
+#define SIMPLEX_CORNER3(X, Y, Z, H) \
+  if(SIMPLEX_NEAR(X, LIM) && SIMPLEX_NEAR(Y, LIM) && SIMPLEX_NEAR(Z, LIM)) { \
+    const int8_t *g = simplex_grad3[(H) & 15]; \
+    n += simplex_corner(R2, X*X + Y*Y + Z*Z, g[0]*X + g[1]*Y + g[2]*Z); \
+  }
+  SIMPLEX_CORNER3(x0, y0, z0, P((uint8_t)(ii + P((uint8_t)(jj + P(kk))))))
+  SIMPLEX_CORNER3(x1, y1, z1, P((uint8_t)(ii + i1 + P((uint8_t)(jj + j1 + P((uint8_t)(kk + k1)))))))
+  SIMPLEX_CORNER3(x2, y2, z2, P((uint8_t)(ii + i2 + P((uint8_t)(jj + j2 + P((uint8_t)(kk + k2)))))))
+  SIMPLEX_CORNER3(x3, y3, z3, P((uint8_t)(ii + 1 + P((uint8_t)(jj + 1 + P((uint8_t)(kk + 1)))))))
+#undef SIMPLEX_CORNER3
+
+  return simplex_scale(n, SIMPLEX_GAIN3);
+}
+
+uint16_t snoise16(uint32_t x, uint32_t y, uint32_t z, uint32_t w) {
+  const uint32_t F4 = 1327217885u, G4 = 593549882u;       // (sqrt(5)-1)/4, (5-sqrt(5))/20
+  const int32_t  G4_15 = 4528;
+
+  const uint64_t s = simplex_mulq32((uint64_t)x + y + z + w, F4);
+  const uint32_t i = ((uint64_t)x + s) >> 16;
+  const uint32_t j = ((uint64_t)y + s) >> 16;
+  const uint32_t k = ((uint64_t)z + s) >> 16;
+  const uint32_t l = ((uint64_t)w + s) >> 16;
+  const uint64_t t = simplex_mulq32((uint64_t)(i + j + k + l) << 16, G4);
+
+  const int32_t x0 = simplex_offset(x, i, t), y0 = simplex_offset(y, j, t);
+  const int32_t z0 = simplex_offset(z, k, t), w0 = simplex_offset(w, l, t);
+
+  // Rank the offsets: the largest steps first, so corner c has ones where rank >= 4-c
+  uint8_t rx = 0, ry = 0, rz = 0, rw = 0;
+  if(x0 > y0) rx++; else ry++;
+  if(x0 > z0) rx++; else rz++;
+  if(x0 > w0) rx++; else rw++;
+  if(y0 > z0) ry++; else rz++;
+  if(y0 > w0) ry++; else rw++;
+  if(z0 > w0) rz++; else rw++;
+
+  const uint8_t i1 = rx >= 3, j1 = ry >= 3, k1 = rz >= 3, l1 = rw >= 3;
+  const uint8_t i2 = rx >= 2, j2 = ry >= 2, k2 = rz >= 2, l2 = rw >= 2;
+  const uint8_t i3 = rx >= 1, j3 = ry >= 1, k3 = rz >= 1, l3 = rw >= 1;
+
+  const int32_t x1 = x0 - i1*SIMPLEX_ONE + G4_15,   y1 = y0 - j1*SIMPLEX_ONE + G4_15;
+  const int32_t z1 = z0 - k1*SIMPLEX_ONE + G4_15,   w1 = w0 - l1*SIMPLEX_ONE + G4_15;
+  const int32_t x2 = x0 - i2*SIMPLEX_ONE + 2*G4_15, y2 = y0 - j2*SIMPLEX_ONE + 2*G4_15;
+  const int32_t z2 = z0 - k2*SIMPLEX_ONE + 2*G4_15, w2 = w0 - l2*SIMPLEX_ONE + 2*G4_15;
+  const int32_t x3 = x0 - i3*SIMPLEX_ONE + 3*G4_15, y3 = y0 - j3*SIMPLEX_ONE + 3*G4_15;
+  const int32_t z3 = z0 - k3*SIMPLEX_ONE + 3*G4_15, w3 = w0 - l3*SIMPLEX_ONE + 3*G4_15;
+  const int32_t x4 = x0 - SIMPLEX_ONE + 4*G4_15,    y4 = y0 - SIMPLEX_ONE + 4*G4_15;
+  const int32_t z4 = z0 - SIMPLEX_ONE + 4*G4_15,    w4 = w0 - SIMPLEX_ONE + 4*G4_15;
+
+  const uint8_t ii = i, jj = j, kk = k, ll = l;
+  const uint32_t R2 = 644245094u;                          // 0.6 in Q30
+  const int32_t  LIM = 25382;
+  int32_t n = 0;
+
+  // (the squared radius can pass 2^31 before the corner is rejected, so it is summed unsigned)
+#define SIMPLEX_CORNER4(X, Y, Z, W, H) \
+  if(SIMPLEX_NEAR(X, LIM) && SIMPLEX_NEAR(Y, LIM) && SIMPLEX_NEAR(Z, LIM) && SIMPLEX_NEAR(W, LIM)) { \
+    const uint32_t d2 = (uint32_t)(X*X) + (uint32_t)(Y*Y) + (uint32_t)(Z*Z) + (uint32_t)(W*W); \
+    if(d2 < R2) { \
+      const int8_t *g = simplex_grad4[(H) & 31]; \
+      n += simplex_corner(R2, d2, g[0]*X + g[1]*Y + g[2]*Z + g[3]*W); \
+    } \
+  }
+  SIMPLEX_CORNER4(x0, y0, z0, w0, P((uint8_t)(ii + P((uint8_t)(jj + P((uint8_t)(kk + P(ll))))))))
+  SIMPLEX_CORNER4(x1, y1, z1, w1, P((uint8_t)(ii + i1 + P((uint8_t)(jj + j1 + P((uint8_t)(kk + k1 + P((uint8_t)(ll + l1)))))))))
+  SIMPLEX_CORNER4(x2, y2, z2, w2, P((uint8_t)(ii + i2 + P((uint8_t)(jj + j2 + P((uint8_t)(kk + k2 + P((uint8_t)(ll + l2)))))))))
+  SIMPLEX_CORNER4(x3, y3, z3, w3, P((uint8_t)(ii + i3 + P((uint8_t)(jj + j3 + P((uint8_t)(kk + k3 + P((uint8_t)(ll + l3)))))))))
+  SIMPLEX_CORNER4(x4, y4, z4, w4, P((uint8_t)(ii + 1 + P((uint8_t)(jj + 1 + P((uint8_t)(kk + 1 + P((uint8_t)(ll + 1)))))))))
+#undef SIMPLEX_CORNER4
+
+  return simplex_scale(n, SIMPLEX_GAIN4);
+}
+
+uint8_t snoise8(uint16_t x, uint16_t y) {
+  return snoise16((uint32_t)x << 8, (uint32_t)y << 8) >> 8;
+}
+
+uint8_t snoise8(uint16_t x, uint16_t y, uint16_t z) {
+  return snoise16((uint32_t)x << 8, (uint32_t)y << 8, (uint32_t)z << 8) >> 8;
+}
+
+uint8_t snoise8(uint16_t x, uint16_t y, uint16_t z, uint16_t w) {
+  return snoise16((uint32_t)x << 8, (uint32_t)y << 8, (uint32_t)z << 8, (uint32_t)w << 8) >> 8;
+}
+
 // struct q44 {
 //   uint8_t i:4;
 //   uint8_t f:4;
@@ -581,6 +1059,7 @@ uint8_t inoise8(uint16_t x) {
 // }
 
 void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16_t x, int scale, uint16_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_noise8");
   uint32_t _xx = x;
   uint32_t scx = scale;
   for(int o = 0; o < octaves; ++o) {
@@ -594,6 +1073,7 @@ void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16
 }
 
 void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint32_t x, int scale, uint32_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_noise16into8");
   uint32_t _xx = x;
   uint32_t scx = scale;
   for(int o = 0; o < octaves; ++o) {
@@ -624,67 +1104,54 @@ void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves,
 /// @param time the time position for the noise field
 /// @todo Why isn't this declared in the header (noise.h)?
 void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, q44 freq44, fract8 amplitude, int skip, uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time) {
-  if(octaves > 1) {
-    fill_raw_2dnoise8(pData, width, height, octaves-1, freq44, amplitude, skip+1, x*freq44, freq44 * scalex, y*freq44, freq44 * scaley, time);
-  } else {
-    // amplitude is always 255 on the lowest level
-    amplitude=255;
-  }
-
-  scalex *= skip;
-  scaley *= skip;
-
-  fract8 invamp = 255-amplitude;
-  uint16_t xx = x;
-  for(int i = 0; i < height; ++i, y+=scaley) {
-    uint8_t *pRow = pData + (i*width);
-    xx = x;
-    for(int j = 0; j < width; ++j, xx+=scalex) {
-      uint8_t noise_base = inoise8(xx,y,time);
-      noise_base = (0x80 & noise_base) ? (noise_base - 127) : (127 - noise_base);
-      noise_base = scale8(noise_base<<1,amplitude);
-      if(skip == 1) {
-        pRow[j] = scale8(pRow[j],invamp) + noise_base;
-      } else {
-        for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
-          uint8_t *pRow = pData + (ii*width);
-          for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
-            pRow[jj] = scale8(pRow[jj],invamp) + noise_base;
-          }
-        }
-      }
-    }
-  }
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise8");
+  fill_raw_2dnoise8_window(pData, width, width, height, 0, 0, width, height, octaves, freq44, amplitude, skip, x, scalex, y, scaley, time);
 }
 
-void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, uint16_t x, int scalex, uint16_t y, int scaley, uint16_t time) {
+void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise8");
   fill_raw_2dnoise8(pData, width, height, octaves, q44(2,0), 128, 1, x, scalex, y, scaley, time);
 }
 
-void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves, q88 freq88, fract16 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
-  if(octaves > 1) {
-    fill_raw_2dnoise16(pData, width, height, octaves-1, freq88, amplitude, skip, x *freq88 , scalex *freq88, y * freq88, scaley * freq88, time);
-  } else {
-    // amplitude is always 255 on the lowest level
-    amplitude=65535;
-  }
-
-  scalex *= skip;
-  scaley *= skip;
+/*
+ * The raw 2D fills evaluate their samples a row at a time with inoise8_row() /
+ * inoise16_row(), this many per call.
+ *
+ * Their octaves are applied deepest first, as the recursive originals did: octave n
+ * is at freq times the coordinates and scales of octave n-1 and the deepest one is
+ * at full amplitude. The coordinates are rebuilt from the top for each octave, which
+ * costs a few multiplies and keeps the stack flat however many octaves are asked for.
+ */
+#define NOISE_ROW_CHUNK 64
+
+// One octave of fill_raw_2dnoise16()
+static void fill_raw_2dnoise16_octave(uint16_t *pData, int width, int height, fract16 amplitude, int skip,
+                                      uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  scalex = (uint32_t)scalex * skip;
+  scaley = (uint32_t)scaley * skip;
   fract16 invamp = 65535-amplitude;
+  uint16_t noise[NOISE_ROW_CHUNK];
   for(int i = 0; i < height; i+=skip, y+=scaley) {
-    uint16_t *pRow = pData + (i*width);
-    for(int j = 0,xx=x; j < width; j+=skip, xx+=scalex) {
-      uint16_t noise_base = inoise16(xx,y,time);
-      noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
-      noise_base = scale16(noise_base<<1, amplitude);
-      if(skip==1) {
-        pRow[j] = scale16(pRow[j],invamp) + noise_base;
-      } else {
-        for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
-          uint16_t *pRow = pData + (ii*width);
-          for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
-            pRow[jj] = scale16(pRow[jj],invamp) + noise_base;
+    uint32_t xx = x;
+    for(int jc = 0; jc < width; jc += NOISE_ROW_CHUNK*skip) {
+      const int count = min(NOISE_ROW_CHUNK, (width - jc + skip - 1) / skip);
+      inoise16_row(noise, count, xx, scalex, y, time);
+      xx += (uint32_t)count * scalex;
+
+      for(int k = 0; k < count; ++k) {
+        const int j = jc + k*skip;
+        uint16_t noise_base = noise[k];
+        noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
+        noise_base = scale16(noise_base<<1, amplitude);
+        if(skip==1) {
+          uint16_t *p = pData + i*width + j;
+          *p = scale16(*p,invamp) + noise_base;
+        } else {
+          for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
+            uint16_t *pRow = pData + (ii*width);
+            for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
+              pRow[jj] = scale16(pRow[jj],invamp) + noise_base;
+            }
           }
         }
       }
@@ -692,6 +1159,21 @@ void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves,
   }
 }
 
+void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves, q88 freq88, fract16 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise16");
+  // (unlike the 8-bit fills every octave here uses the same skip)
+  const int levels = octaves > 1 ? octaves : 1;
+  for(int level = levels-1; level >= 0; --level) {
+    uint32_t ox = x, oy = y;
+    int32_t osx = scalex, osy = scaley;
+    for(int k = 0; k < level; ++k) {
+      ox = ox *freq88; osx = osx *freq88;
+      oy = oy *freq88; osy = osy *freq88;
+    }
+    fill_raw_2dnoise16_octave(pData, width, height, level == levels-1 ? 65535 : amplitude, skip, ox, osx, oy, osy, time);
+  }
+}
+
 /// Unused
 /// @todo Remove?
 int32_t nmin=11111110;
@@ -700,31 +1182,83 @@ int32_t nmin=11111110;
 int32_t nmax=0;
 
 void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, q44 freq44, fract8 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
-  if(octaves > 1) {
-    fill_raw_2dnoise16into8(pData, width, height, octaves-1, freq44, amplitude, skip+1, x*freq44, scalex *freq44, y*freq44, scaley * freq44, time);
-  } else {
-    // amplitude is always 255 on the lowest level
-    amplitude=255;
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise16into8");
+  fill_raw_2dnoise16into8_window(pData, width, width, height, 0, 0, width, height, octaves, freq44, amplitude, skip, x, scalex, y, scaley, time);
+}
+
+void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise16into8");
+  fill_raw_2dnoise16into8(pData, width, height, octaves, q44(2,0), 171, 1, x, scalex, y, scaley, time);
+}
+
+void fill_raw_2dsimplex8(uint8_t *pData, int width, int height, uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dsimplex8");
+  if(octaves < 1) { octaves = 1; }
+  if(octaves > 8) { octaves = 8; }
+
+  // Octave o is at 2^o times the frequency and 2^-o the amplitude; the sum is
+  // normalized back to the range of one octave
+  const int32_t weight = 512 - (512 >> octaves);          // sum of 256 >> o
+  for(int i = 0; i < height; ++i, y += scaley) {
+    uint8_t *pRow = pData + i*width;
+    uint32_t xx = x;
+    for(int j = 0; j < width; ++j, xx += scalex) {
+      int32_t acc = 0;
+      for(uint8_t o = 0; o < octaves; ++o) {
+        acc += ((int32_t)snoise16(xx << o, y << o, time) - 32768) * (256 >> o);
+      }
+      const int32_t v = 128 + acc / weight / 256;
+      pRow[j] = v < 0 ? 0 : v > 255 ? 255 : v;
+    }
   }
+}
 
+/*
+ * Windowed versions of the two raw 2D fills: produce only the ww x wh window at
+ * (wx,wy) of the width x height map, into pData (the window's top-left, rows 'stride'
+ * bytes apart). The result is bit for bit that part of the whole-map fill, so a map
+ * can be built in strips or tiles, or just where it is needed. The whole-map fills
+ * are these with the window covering the map.
+ *
+ * An octave with skip > 1 stamps each sample over a skip x skip block, and in the 8-bit
+ * fill those blocks overlap, so a window also evaluates the samples up to skip-1 rows
+ * and columns before it, applied in the same order as the whole-map fill.
+ */
+
+// One octave of fill_raw_2dnoise8_window()
+static void fill_raw_2dnoise8_octave(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                     fract8 amplitude, int skip, uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time) {
   scalex *= skip;
   scaley *= skip;
-  uint32_t xx;
+
   fract8 invamp = 255-amplitude;
-  for(int i = 0; i < height; i+=skip, y+=scaley) {
-    uint8_t *pRow = pData + (i*width);
-    xx = x;
-    for(int j = 0; j < width; j+=skip, xx+=scalex) {
-      uint16_t noise_base = inoise16(xx,y,time);
-      noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
-      noise_base = scale8(noise_base>>7,amplitude);
-      if(skip==1) {
-        pRow[j] = qadd8(scale8(pRow[j],invamp),noise_base);
-      } else {
-        for(int ii = i; ii<(i+skip) && ii<height; ++ii) {
-          uint8_t *pRow = pData + (ii*width);
-          for(int jj=j; jj<(j+skip) && jj<width; ++jj) {
-            pRow[jj] = scale8(pRow[jj],invamp) + noise_base;
+  const int i0 = max(wy - skip + 1, 0), i1 = min(wy + wh, height);
+  const int j0 = max(wx - skip + 1, 0), j1 = min(wx + ww, width);
+  uint8_t noise[NOISE_ROW_CHUNK];
+  uint16_t yy = y + i0 * scaley;
+  for(int i = i0; i < i1; ++i, yy+=scaley) {
+    const int r0 = max(i, wy), r1 = min(min(i + skip, height), wy + wh);
+    uint16_t xx = x + j0 * scalex;
+    for(int jc = j0; jc < j1; jc += NOISE_ROW_CHUNK) {
+      const int count = min(NOISE_ROW_CHUNK, j1 - jc);
+      inoise8_row(noise, count, xx, scalex, yy, time);
+      xx += count * scalex;
+
+      for(int k = 0; k < count; ++k) {
+        const int j = jc + k;
+        uint8_t noise_base = noise[k];
+        noise_base = (0x80 & noise_base) ? (noise_base - 127) : (127 - noise_base);
+        noise_base = scale8(noise_base<<1,amplitude);
+        if(skip == 1) {
+          uint8_t *p = pData + (i-wy)*stride + (j-wx);
+          *p = scale8(*p,invamp) + noise_base;
+        } else {
+          const int c0 = max(j, wx), c1 = min(min(j + skip, width), wx + ww);
+          for(int ii = r0; ii < r1; ++ii) {
+            uint8_t *pRow = pData + (ii-wy)*stride - wx;
+            for(int jj = c0; jj < c1; ++jj) {
+              pRow[jj] = scale8(pRow[jj],invamp) + noise_base;
+            }
           }
         }
       }
@@ -732,14 +1266,265 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
   }
 }
 
-void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, uint32_t x, int scalex, uint32_t y, int scaley, uint32_t time) {
-  fill_raw_2dnoise16into8(pData, width, height, octaves, q44(2,0), 171, 1, x, scalex, y, scaley, time);
+void fill_raw_2dnoise8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                              uint8_t octaves, q44 freq44, fract8 amplitude, int skip,
+                              uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time) {
+  const int levels = octaves > 1 ? octaves : 1;
+  for(int level = levels-1; level >= 0; --level) {
+    uint16_t ox = x, oy = y;
+    int16_t osx = scalex, osy = scaley;
+    for(int k = 0; k < level; ++k) {
+      ox = ox*freq44; osx = freq44 * osx;
+      oy = oy*freq44; osy = freq44 * osy;
+    }
+    fill_raw_2dnoise8_octave(pData, stride, width, height, wx, wy, ww, wh,
+                             level == levels-1 ? 255 : amplitude, skip + level, ox, osx, oy, osy, time);
+  }
+}
+
+void fill_raw_2dnoise8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                              uint8_t octaves, uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise8_window");
+  fill_raw_2dnoise8_window(pData, stride, width, height, wx, wy, ww, wh, octaves, q44(2,0), 128, 1, x, scalex, y, scaley, time);
+}
+
+// One octave of fill_raw_2dnoise16into8_window()
+static void fill_raw_2dnoise16into8_octave(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                           fract8 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  // (unsigned: the coordinates wrap anyway, and deep octaves can overflow an int)
+  scalex = (uint32_t)scalex * skip;
+  scaley = (uint32_t)scaley * skip;
+  fract8 invamp = 255-amplitude;
+
+  // Here samples sit on multiples of skip and their blocks don't overlap
+  const int i0 = wy - wy % skip, i1 = min(wy + wh, height);
+  const int j0 = wx - wx % skip, j1 = min(wx + ww, width);
+  uint16_t noise[NOISE_ROW_CHUNK];
+  uint32_t yy = y + (uint32_t)(i0 / skip) * scaley;
+  for(int i = i0; i < i1; i+=skip, yy+=scaley) {
+    uint32_t xx = x + (uint32_t)(j0 / skip) * scalex;
+    for(int jc = j0; jc < j1; jc += NOISE_ROW_CHUNK*skip) {
+      const int count = min(NOISE_ROW_CHUNK, (j1 - jc + skip - 1) / skip);
+      inoise16_row(noise, count, xx, scalex, yy, time);
+      xx += (uint32_t)count * scalex;
+
+      for(int k = 0; k < count; ++k) {
+        const int j = jc + k*skip;
+        uint16_t noise_base = noise[k];
+        noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
+        noise_base = scale8(noise_base>>7,amplitude);
+        if(skip==1) {
+          uint8_t *p = pData + (i-wy)*stride + (j-wx);
+          *p = qadd8(scale8(*p,invamp),noise_base);
+        } else {
+          const int r0 = max(i, wy), r1 = min(min(i + skip, height), wy + wh);
+          const int c0 = max(j, wx), c1 = min(min(j + skip, width), wx + ww);
+          for(int ii = r0; ii < r1; ++ii) {
+            uint8_t *pRow = pData + (ii-wy)*stride - wx;
+            for(int jj = c0; jj < c1; ++jj) {
+              pRow[jj] = scale8(pRow[jj],invamp) + noise_base;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void fill_raw_2dnoise16into8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                    uint8_t octaves, q44 freq44, fract8 amplitude, int skip,
+                                    uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  const int levels = octaves > 1 ? octaves : 1;
+  for(int level = levels-1; level >= 0; --level) {
+    uint32_t ox = x, oy = y;
+    int32_t osx = scalex, osy = scaley;
+    for(int k = 0; k < level; ++k) {
+      ox = ox*freq44; osx = osx *freq44;
+      oy = oy*freq44; osy = osy * freq44;
+    }
+    fill_raw_2dnoise16into8_octave(pData, stride, width, height, wx, wy, ww, wh,
+                                   level == levels-1 ? 255 : amplitude, skip + level, ox, osx, oy, osy, time);
+  }
+}
+
+void fill_raw_2dnoise16into8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                    uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise16into8_window");
+  fill_raw_2dnoise16into8_window(pData, stride, width, height, wx, wy, ww, wh, octaves, q44(2,0), 171, 1, x, scalex, y, scaley, time);
+}
+
+/*
+ * Upscaled fill_raw_2dnoise16into8(): the full fill is evaluated only at the nodes,
+ * the pixels whose row and column are multiples of step, and everything in between
+ * is bilinear between the four nodes around it. Nodes are those of the whole map, so
+ * windows still join up exactly, and the map is streamed a strip of up to
+ * NOISE_ROW_CHUNK node columns at a time with just two node rows held.
+ */
+
+// Round step down to 1, 2, 4 or 8; returns log2 of it
+static int upscale_shift(int step) {
+  return step >= 8 ? 3 : step >= 4 ? 2 : step >= 2 ? 1 : 0;
+}
+
+// Nodes a0 .. a0+count-1 of node row b: the full fill's value at those pixels
+static void upscale_node_row(uint8_t *nodes, int a0, int count, int b, int step, uint8_t octaves,
+                             uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  q44 freq44(2,0);
+  const int levels = octaves > 1 ? octaves : 1;
+  uint16_t noise[NOISE_ROW_CHUNK];
+
+  memset(nodes, 0, count);
+  for(int level = levels-1; level >= 0; --level) {
+    uint32_t ox = x, oy = y;
+    int32_t osx = scalex, osy = scaley;
+    for(int k = 0; k < level; ++k) {
+      ox = ox*freq44; osx = osx *freq44;
+      oy = oy*freq44; osy = osy * freq44;
+    }
+
+    // Same sample, amplitude and mix as fill_raw_2dnoise16into8_octave() uses there
+    const int skip = 1 + level;
+    const fract8 amplitude = level == levels-1 ? 255 : 171;
+    const fract8 invamp = 255-amplitude;
+    const uint32_t sx = (uint32_t)osx * skip;
+    const uint32_t yy = oy + (uint32_t)(b*step / skip) * ((uint32_t)osy * skip);
+
+    for(int kc = 0; kc < count; kc += NOISE_ROW_CHUNK) {
+      const int n = min(NOISE_ROW_CHUNK, count - kc);
+      if(step % skip == 0) {
+        // Nodes land on every (step/skip)th sample, an even stride
+        inoise16_row(noise, n, ox + (uint32_t)((a0 + kc) * (step / skip)) * sx, (int32_t)(sx * (step / skip)), yy, time);
+      } else {
+        for(int k = 0; k < n; ++k) {
+          noise[k] = inoise16(ox + (uint32_t)((a0 + kc + k)*step / skip) * sx, yy, time);
+        }
+      }
+
+      for(int k = 0; k < n; ++k) {
+        uint16_t noise_base = noise[k];
+        noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
+        noise_base = scale8(noise_base>>7,amplitude);
+        uint8_t &node = nodes[kc + k];
+        node = skip == 1 ? qadd8(scale8(node,invamp),noise_base) : scale8(node,invamp) + noise_base;
+      }
+    }
+  }
+}
+
+// Pixels c0..c1-1 of a row along the (step-scaled) node column values, node 'as' first
+template<int SHIFT>
+static void upscale_row(uint8_t *pRow, const uint16_t *column, int as, int c0, int c1) {
+  const int step = 1 << SHIFT;
+  const int32_t round = 1 << (2*SHIFT - 1);
+
+  for(int j = c0; j < c1; ) {
+    const int k = (j >> SHIFT) - as;
+    const int32_t d = (int32_t)column[k+1] - column[k];
+    int32_t v = ((int32_t)column[k] << SHIFT) + round;
+    if((j & (step - 1)) == 0 && j + step <= c1) {
+      // A whole span; fixed length, so it unrolls
+      for(int f = 0; f < step; ++f, v += d) {
+        pRow[j + f] = v >> (2*SHIFT);
+      }
+      j += step;
+    } else {
+      v += d * (j & (step - 1));
+      const int end = min(c1, (j | (step - 1)) + 1);
+      for(; j < end; ++j, v += d) {
+        pRow[j] = v >> (2*SHIFT);
+      }
+    }
+  }
+}
+
+void fill_raw_2dnoise16into8_upscaled_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                             int step, uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+    GFX_PROFILE_PRIMITIVE("fill_raw_2dnoise16into8_upscaled_window");
+  const int shift = upscale_shift(step);
+  if(shift == 0) {
+    fill_raw_2dnoise16into8_window(pData, stride, width, height, wx, wy, ww, wh, octaves, x, scalex, y, scaley, time);
+    return;
+  }
+  step = 1 << shift;
+
+  const int i1 = min(wy + wh, height), j1 = min(wx + ww, width);
+  if(wx < 0 || wy < 0 || i1 <= wy || j1 <= wx) return;
+
+  // Node columns aL..aR bracket the window's columns
+  const int aL = wx >> shift, aR = ((j1 - 1) >> shift) + 1;
+  uint8_t  n0[NOISE_ROW_CHUNK+1], n1[NOISE_ROW_CHUNK+1];
+  uint16_t column[NOISE_ROW_CHUNK+1];
+
+  for(int as = aL; as < aR; as += NOISE_ROW_CHUNK) {
+    const int nodes = min(NOISE_ROW_CHUNK, aR - as) + 1;
+    const int c0 = max(wx, as << shift), c1 = min(j1, (as + nodes - 1) << shift);
+
+    int b = wy >> shift;
+    upscale_node_row(n0, as, nodes, b, step, octaves, x, scalex, y, scaley, time);
+    upscale_node_row(n1, as, nodes, b + 1, step, octaves, x, scalex, y, scaley, time);
+
+    for(int i = wy; i < i1; ++i) {
+      if((i >> shift) != b) {
+        ++b;
+        memcpy(n0, n1, nodes);
+        upscale_node_row(n1, as, nodes, b + 1, step, octaves, x, scalex, y, scaley, time);
+      }
+
+      // Down the node columns first (values scaled by step), then along the row (by step again)
+      const int fy = i & (step - 1);
+      for(int k = 0; k < nodes; ++k) {
+        column[k] = n0[k] * (step - fy) + n1[k] * fy;
+      }
+
+      uint8_t *pRow = pData + (i-wy)*stride - wx;
+      switch(shift) {
+        case 1:  upscale_row<1>(pRow, column, as, c0, c1); break;
+        case 2:  upscale_row<2>(pRow, column, as, c0, c1); break;
+        default: upscale_row<3>(pRow, column, as, c0, c1); break;
+      }
+    }
+  }
+}
+
+void fill_raw_2dnoise16into8_upscaled(uint8_t *pData, int width, int height, int step, uint8_t octaves,
+                                      uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time) {
+  fill_raw_2dnoise16into8_upscaled_window(pData, width, width, height, 0, 0, width, height, step, octaves, x, scalex, y, scaley, time);
+}
+
+uint8_t fill_raw_2dnoise16into8_upscale_error(int width, int height, int step, uint8_t octaves,
+                                              uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time,
+                                              uint8_t *mean) {
+  uint8_t full[256], upscaled[256];
+  uint8_t worst = 0;
+  uint64_t total = 0;
+
+  // A row segment at a time, both ways
+  for(int i = 0; i < height; ++i) {
+    for(int j = 0; j < width; j += 256) {
+      const int n = min(256, width - j);
+      memset(full, 0, n);
+      fill_raw_2dnoise16into8_window(full, n, width, height, j, i, n, 1, octaves, x, scalex, y, scaley, time);
+      fill_raw_2dnoise16into8_upscaled_window(upscaled, n, width, height, j, i, n, 1, step, octaves, x, scalex, y, scaley, time);
+      for(int k = 0; k < n; ++k) {
+        const uint8_t e = full[k] > upscaled[k] ? full[k] - upscaled[k] : upscaled[k] - full[k];
+        if(e > worst) { worst = e; }
+        total += e;
+      }
+    }
+  }
+
+  if(mean) {
+    const uint64_t count = (uint64_t)width * height;
+    *mean = count ? (total + count/2) / count : 0;
+  }
+  return worst;
 }
 
 void fill_noise8(CRGB *leds, int num_leds,
             uint8_t octaves, uint16_t x, int scale,
             uint8_t hue_octaves, uint16_t hue_x, int hue_scale,
             uint16_t time) {
+    GFX_PROFILE_CALL("fill_noise8");
 
     if (num_leds <= 0) return;
 
@@ -766,6 +1551,7 @@ void fill_noise16(CRGB *leds, int num_leds,
             uint8_t octaves, uint16_t x, int scale,
             uint8_t hue_octaves, uint16_t hue_x, int hue_scale,
             uint16_t time, uint8_t hue_shift) {
+    GFX_PROFILE_CALL("fill_noise16");
 
     if (num_leds <= 0) return;
 
@@ -788,34 +1574,52 @@ void fill_noise16(CRGB *leds, int num_leds,
     }
 }
 
+// fill_2dnoise8/16 build their noise maps one window at a time in this many bytes of
+// stack per map, however large the matrix
+#define FILL_2DNOISE_TILE 512
+
 void fill_2dnoise8(CRGB *leds, int width, int height, bool serpentine,
             uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
             uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
-  uint8_t V[height][width];
-  uint8_t H[height][width];
+    GFX_PROFILE_CALL("fill_2dnoise8");
+  if(width <= 0 || height <= 0) return;
 
-  memset(V,0,height*width);
-  memset(H,0,height*width);
+  uint8_t V[FILL_2DNOISE_TILE];
+  uint8_t H[FILL_2DNOISE_TILE];
 
-  fill_raw_2dnoise8((uint8_t*)V,width,height,octaves,x,xscale,y,yscale,time);
-  fill_raw_2dnoise8((uint8_t*)H,width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+  // Whole rows per window when they fit
+  const int tw = min(width, FILL_2DNOISE_TILE);
+  const int th = max(1, FILL_2DNOISE_TILE / tw);
 
   int w1 = width-1;
-  int h1 = height-1;
-  for(int i = 0; i < height; ++i) {
-    int wb = i*width;
-    for(int j = 0; j < width; ++j) {
-      CRGB led(CHSV(H[h1-i][w1-j],255,V[i][j]));
-
-      int pos = j;
-      if(serpentine && (i & 0x1)) {
-        pos = w1-j;
-      }
+  for(int ty = 0; ty < height; ty += th) {
+    for(int tx = 0; tx < width; tx += tw) {
+      const int cw = min(tw, width - tx), ch = min(th, height - ty);
+
+      memset(V,0,cw*ch);
+      memset(H,0,cw*ch);
+
+      // The hue map is read mirrored, so its window is the mirror image of this one
+      fill_raw_2dnoise8_window(V,cw,width,height,tx,ty,cw,ch,octaves,x,xscale,y,yscale,time);
+      fill_raw_2dnoise8_window(H,cw,width,height,width-tx-cw,height-ty-ch,cw,ch,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+
+      for(int i = 0; i < ch; ++i) {
+        const int row = ty + i;
+        int wb = row*width;
+        for(int j = 0; j < cw; ++j) {
+          CRGB led(CHSV(H[(ch-1-i)*cw + (cw-1-j)],255,V[i*cw + j]));
+
+          int pos = tx + j;
+          if(serpentine && (row & 0x1)) {
+            pos = w1-pos;
+          }
 
-      if(blend) {
-        leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
-      } else {
-        leds[wb+pos] = led;
+          if(blend) {
+            leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
+          } else {
+            leds[wb+pos] = led;
+          }
+        }
       }
     }
   }
@@ -824,36 +1628,45 @@ void fill_2dnoise8(CRGB *leds, int width, int height, bool serpentine,
 void fill_2dnoise16(CRGB *leds, int width, int height, bool serpentine,
             uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
             uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift) {
-  uint8_t V[height][width];
-  uint8_t H[height][width];
+    GFX_PROFILE_CALL("fill_2dnoise16");
+  if(width <= 0 || height <= 0) return;
 
-  memset(V,0,height*width);
-  memset(H,0,height*width);
-
-  fill_raw_2dnoise16into8((uint8_t*)V,width,height,octaves,q44(2,0),171,1,x,xscale,y,yscale,time);
-  // fill_raw_2dnoise16into8((uint8_t*)V,width,height,octaves,x,xscale,y,yscale,time);
-  // fill_raw_2dnoise8((uint8_t*)V,width,height,hue_octaves,x,xscale,y,yscale,time);
-  fill_raw_2dnoise8((uint8_t*)H,width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+  uint8_t V[FILL_2DNOISE_TILE];
+  uint8_t H[FILL_2DNOISE_TILE];
 
+  const int tw = min(width, FILL_2DNOISE_TILE);
+  const int th = max(1, FILL_2DNOISE_TILE / tw);
 
   int w1 = width-1;
-  int h1 = height-1;
   hue_shift >>= 8;
 
-  for(int i = 0; i < height; ++i) {
-    int wb = i*width;
-    for(int j = 0; j < width; ++j) {
-      CRGB led(CHSV(hue_shift + (H[h1-i][w1-j]),196,V[i][j]));
+  for(int ty = 0; ty < height; ty += th) {
+    for(int tx = 0; tx < width; tx += tw) {
+      const int cw = min(tw, width - tx), ch = min(th, height - ty);
 
-      int pos = j;
-      if(serpentine && (i & 0x1)) {
-        pos = w1-j;
-      }
+      memset(V,0,cw*ch);
+      memset(H,0,cw*ch);
 
-      if(blend) {
-        leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
-      } else {
-        leds[wb+pos] = led;
+      fill_raw_2dnoise16into8_window(V,cw,width,height,tx,ty,cw,ch,octaves,q44(2,0),171,1,x,xscale,y,yscale,time);
+      fill_raw_2dnoise8_window(H,cw,width,height,width-tx-cw,height-ty-ch,cw,ch,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+
+      for(int i = 0; i < ch; ++i) {
+        const int row = ty + i;
+        int wb = row*width;
+        for(int j = 0; j < cw; ++j) {
+          CRGB led(CHSV(hue_shift + (H[(ch-1-i)*cw + (cw-1-j)]),196,V[i*cw + j]));
+
+          int pos = tx + j;
+          if(serpentine && (row & 0x1)) {
+            pos = w1-pos;
+          }
+
+          if(blend) {
+            leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
+          } else {
+            leds[wb+pos] = led;
+          }
+        }
       }
     }
   }
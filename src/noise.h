@@ -98,6 +98,74 @@ extern int8_t inoise8_raw(uint16_t x, uint16_t y);
 extern int8_t inoise8_raw(uint16_t x);
 
 /// @} 8-Bit Raw Noise Functions
+
+
+/// @name Row Noise Functions
+/// A run of samples along x in one call: out[i] is the scaled noise at x + i*dx
+/// (wrapping like the coordinates themselves), bit for bit what inoise16() /
+/// inoise8() return there. Consecutive samples in the same lattice cell share its
+/// hashing and the y / z half of its corner gradients, so a row costs a fraction
+/// of the per-sample calls.
+/// @{
+
+/// @param out where the count samples go
+/// @param count number of samples
+/// @param x x-axis coordinate of the first sample
+/// @param dx x distance between samples
+/// @param y y-axis coordinate on noise map (2D)
+/// @param z z-axis coordinate on noise map (3D)
+extern void inoise16_row(uint16_t *out, int count, uint32_t x, int32_t dx, uint32_t y, uint32_t z);
+
+/// @copydoc inoise16_row(uint16_t*, int, uint32_t, int32_t, uint32_t, uint32_t)
+extern void inoise16_row(uint16_t *out, int count, uint32_t x, int32_t dx, uint32_t y);
+
+/// @copydoc inoise16_row(uint16_t*, int, uint32_t, int32_t, uint32_t, uint32_t)
+extern void inoise8_row(uint8_t *out, int count, uint16_t x, int16_t dx, uint16_t y, uint16_t z);
+
+/// @copydoc inoise16_row(uint16_t*, int, uint32_t, int32_t, uint32_t, uint32_t)
+extern void inoise8_row(uint8_t *out, int count, uint16_t x, int16_t dx, uint16_t y);
+
+/// @} Row Noise Functions
+
+
+/// @name Simplex Noise Functions
+/// Fixed point simplex noise (Perlin's 2001 successor to the classic noise above),
+/// with the same ranges as inoise16() / inoise8(): 0-65535 / 0-255 around a middle
+/// of 32768 / 128, and coordinates in the same 16.16 / 8.8 fixed point. A 3D sample
+/// sums 4 lattice corners instead of 8 (5 instead of 16 in 4D) and shows fewer
+/// axis-aligned artifacts. Unlike inoise16() it doesn't repeat every 256 units, so
+/// there is a seam where a coordinate wraps round.
+/// @{
+
+/// 16-bit simplex noise
+/// @param x x-axis coordinate on noise map
+/// @param y y-axis coordinate on noise map
+/// @returns noise value, 0-65535
+extern uint16_t snoise16(uint32_t x, uint32_t y);
+
+/// @copydoc snoise16(uint32_t, uint32_t)
+/// @param z z-axis coordinate on noise map (3D)
+extern uint16_t snoise16(uint32_t x, uint32_t y, uint32_t z);
+
+/// @copydoc snoise16(uint32_t, uint32_t, uint32_t)
+/// @param w w-axis coordinate on noise map (4D), e.g. time for a looping 3D field
+extern uint16_t snoise16(uint32_t x, uint32_t y, uint32_t z, uint32_t w);
+
+/// 8-bit simplex noise: snoise16() with 8.8 coordinates
+/// @param x x-axis coordinate on noise map
+/// @param y y-axis coordinate on noise map
+/// @returns noise value, 0-255
+extern uint8_t snoise8(uint16_t x, uint16_t y);
+
+/// @copydoc snoise8(uint16_t, uint16_t)
+/// @param z z-axis coordinate on noise map (3D)
+extern uint8_t snoise8(uint16_t x, uint16_t y, uint16_t z);
+
+/// @copydoc snoise8(uint16_t, uint16_t, uint16_t)
+/// @param w w-axis coordinate on noise map (4D)
+extern uint8_t snoise8(uint16_t x, uint16_t y, uint16_t z, uint16_t w);
+
+/// @} Simplex Noise Functions
 /// @} NoiseGeneration
 
 
@@ -153,6 +221,100 @@ void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves,
 /// @param skip how many noise maps to skip over, incremented recursively per octave
 void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, q44 freq44, fract8 amplitude, int skip, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time);
 
+/// Fill a window of a 2D 8-bit noise map, using inoise8().
+/// The result is bit for bit the same as that part of fill_raw_2dnoise8() over the
+/// whole map, so a large map can be built in tiles or only where it is needed.
+/// @param pData where the window's top-left value goes
+/// @param stride bytes between rows in pData
+/// @param width the width of the whole map
+/// @param height the height of the whole map
+/// @param wx left column of the window
+/// @param wy top row of the window
+/// @param ww window width
+/// @param wh window height (the window is clipped to the map)
+/// @copydetails fill_raw_2dnoise8(uint8_t*, int, int, uint8_t, uint16_t, int16_t, uint16_t, int16_t, uint16_t)
+void fill_raw_2dnoise8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                              uint8_t octaves, uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time);
+
+/// @copydoc fill_raw_2dnoise8_window(uint8_t*, int, int, int, int, int, int, int, uint8_t, uint16_t, int16_t, uint16_t, int16_t, uint16_t)
+/// @param freq44 starting octave frequency
+/// @param amplitude noise amplitude
+/// @param skip how many noise maps to skip over, incremented recursively per octave
+void fill_raw_2dnoise8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                              uint8_t octaves, q44 freq44, fract8 amplitude, int skip,
+                              uint16_t x, int16_t scalex, uint16_t y, int16_t scaley, uint16_t time);
+
+/// Fill a window of a 2D 8-bit noise map, using inoise16(); the windowed
+/// fill_raw_2dnoise16into8()
+/// @copydetails fill_raw_2dnoise8_window(uint8_t*, int, int, int, int, int, int, int, uint8_t, uint16_t, int16_t, uint16_t, int16_t, uint16_t)
+void fill_raw_2dnoise16into8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                    uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time);
+
+/// @copydoc fill_raw_2dnoise16into8_window(uint8_t*, int, int, int, int, int, int, int, uint8_t, uint32_t, int32_t, uint32_t, int32_t, uint32_t)
+/// @param freq44 starting octave frequency
+/// @param amplitude noise amplitude
+/// @param skip how many noise maps to skip over, incremented recursively per octave
+void fill_raw_2dnoise16into8_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                    uint8_t octaves, q44 freq44, fract8 amplitude, int skip,
+                                    uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time);
+
+/// Fill a 2D 8-bit buffer like fill_raw_2dnoise16into8(), evaluating the noise only
+/// every step pixels in each direction and filling the rest by bilinear interpolation.
+/// The pixels on multiples of step match the full fill exactly. For smooth (large scale,
+/// few octave) fields this costs roughly 1/step² of the full fill for a small error,
+/// see fill_raw_2dnoise16into8_upscale_error(). Unlike the full fill, the map is
+/// overwritten rather than mixed into.
+/// @param pData the array of data to fill with noise values
+/// @param width the width of the 2D buffer
+/// @param height the height of the 2D buffer
+/// @param step node spacing: 2, 4 or 8 (others round down to one of those; 1 or less is the full fill)
+/// @param octaves the number of octaves to use for noise
+/// @param x the x position in the noise field
+/// @param scalex the scale (distance) between x points when filling in noise
+/// @param y the y position in the noise field
+/// @param scaley the scale (distance) between y points when filling in noise
+/// @param time the time position for the noise field
+void fill_raw_2dnoise16into8_upscaled(uint8_t *pData, int width, int height, int step, uint8_t octaves,
+                                      uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time);
+
+/// Fill a window of an upscaled 2D 8-bit noise map; the windowed
+/// fill_raw_2dnoise16into8_upscaled(), bit for bit that part of the whole map
+/// @param pData where the window's top-left value goes
+/// @param stride bytes between rows in pData
+/// @param width the width of the whole map
+/// @param height the height of the whole map
+/// @param wx left column of the window
+/// @param wy top row of the window
+/// @param ww window width
+/// @param wh window height (the window is clipped to the map)
+/// @copydetails fill_raw_2dnoise16into8_upscaled()
+void fill_raw_2dnoise16into8_upscaled_window(uint8_t *pData, int stride, int width, int height, int wx, int wy, int ww, int wh,
+                                             int step, uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time);
+
+/// How far fill_raw_2dnoise16into8_upscaled() strays from fill_raw_2dnoise16into8()
+/// with the same arguments: fills the map both ways, a row at a time, and compares.
+/// It costs more than the full fill, so use it to pick step for a scale and octave
+/// count (checking a few times and positions), not every frame.
+/// @param mean if not null, receives the mean absolute error, rounded
+/// @returns the largest absolute difference of any value in the map
+uint8_t fill_raw_2dnoise16into8_upscale_error(int width, int height, int step, uint8_t octaves,
+                                              uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time,
+                                              uint8_t *mean = nullptr);
+
+/// Fill a 2D 8-bit buffer with animated noise, using snoise16() in 3D.
+/// Each value is the noise itself (128 in the middle), not folded round the middle
+/// like the fills above; octaves (1-8) double in frequency and halve in amplitude.
+/// @param pData the array of data to fill with noise values
+/// @param width the width of the 2D buffer
+/// @param height the height of the 2D buffer
+/// @param octaves the number of octaves to sum
+/// @param x x-axis coordinate of the first value
+/// @param scalex the distance between x points
+/// @param y y-axis coordinate of the first row
+/// @param scaley the distance between rows
+/// @param time the time position for the noise field
+void fill_raw_2dsimplex8(uint8_t *pData, int width, int height, uint8_t octaves, uint32_t x, int32_t scalex, uint32_t y, int32_t scaley, uint32_t time);
+
 /// @} Raw Fill Functions
 
 